@@ -0,0 +1,604 @@
+/*******************************************************************************
+ Title          :   bench.cpp
+ Author         :   Anna Cristina Karingal
+ Created on     :   Oct 17, 2026
+ 
+ Description    :   Benchmark of the calculator on a synthetic corpus of
+                    expressions. Parsing (compile), evaluating a compiled
+                    program (run), an optimized one (run_optimized) or the
+                    optimized one as machine code (run_native), parsing and
+                    evaluating at once (evaluate), the same again with a
+                    context warmed up by a first pass, counting the
+                    allocations it makes (steady_state), loading a whole file
+                    and printing the results are timed separately, as is
+                    loading with shared subexpressions evaluated once
+                    (load_shared) and editing one digit of an expression
+                    evaluated before (edit), recomputing a sheet of cells in
+                    parallel (recompute), saving the results to a binary file
+                    (save) and reading every result and expression back from
+                    it (reload). The throughput of each phase in expressions
+                    and megabytes per second and, for the phases timed one
+                    expression at a time, its latency percentiles are printed
+                    as a JSON object. Exits with 1 if steady_state allocated
+                    anything, the machine code gave a result the interpreter
+                    did not or recompute a value get did not.
+ 
+ Usage          :   ./bench [--count N] [--depth D] [--operands N]
+                        [--mix add,sub,mul,div,pow] [--digits N] [--errors R]
+                        [--repeat R] [--variables R] [--seed S] [--threads N]
+                        [--corpus file] [-d]
+ 
+                    Where --count is the number of expressions, --depth their
+                    deepest nesting of parentheses, --operands the most
+                    literals in one expression, --mix the relative frequency
+                    of each operator, --digits the most digits in a literal,
+                    --errors the fraction of invalid expressions, --repeat
+                    the fraction of expressions that repeat an earlier one and
+                    --variables the fraction of operands that are variables,
+                    which steady_state takes to be at least 0.1 so that it
+                    also evaluates expressions with unbound variables.
+                    Files are loaded by --threads threads as well as serially.
+                    With --corpus, the corpus is written to file and nothing
+                    is timed. Values are floats, or doubles with -d.
+ 
+ Build with     :   g++ -std=c++14 -O2 -pthread -I.. -o bench bench.cpp
+                    workload.cpp ../calculator.cpp ../kernels.cpp
+                    ../thread_pool.cpp ../mapped_file.cpp ../literal.cpp
+                    ../result_cache.cpp ../output_sink.cpp ../optimizer.cpp
+                    ../shared_dag.cpp ../incremental.cpp ../cell_sheet.cpp
+                    ../result_file.cpp ../profiler.cpp ../jit.cpp
+                    ../expression_store.cpp ../tree_evaluator.cpp
+ 
+ Last modified  :   Oct 17, 2026
+ 
+ *******************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <new>
+#include <unistd.h>
+
+#include "calculator.h"
+#include "shared_dag.h"
+#include "incremental.h"
+#include "cell_sheet.h"
+#include "jit.h"
+#include "result_file.h"
+#include "workload.h"
+using namespace std;
+
+typedef chrono::steady_clock bench_clock;
+
+// Every allocation the program makes, counted by the operator new below, so
+// that steady_state also sees allocations a context does not hold on to
+static atomic<size_t> heap_allocations(0);
+
+void *operator new(size_t size) {
+    heap_allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) { throw bad_alloc(); }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+// Timings of one phase
+struct phase {
+    string name;
+    size_t count;               // Expressions processed
+    size_t errors;              // Expressions rejected
+    size_t bytes;               // Bytes of input processed
+    double seconds;             // Total wall time
+    vector<double> latencies;   // Time of each expression in ns, if measured
+    vector<pair<string, double> > extra;    // Other counters of the phase
+    
+    phase(string name) : name(name), count(0), errors(0), bytes(0), seconds(0) { }
+};
+
+static double since(bench_clock::time_point start) {
+    return chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/* Nearest rank percentile of sorted latencies */
+static double percentile(const vector<double> &sorted, double p) {
+    if (sorted.empty()) { return 0; }
+    size_t rank = (size_t)(p / 100 * sorted.size());
+    return sorted[min(rank, sorted.size()-1)];
+}
+
+/* Prints one phase as a JSON object */
+static void print_phase(ostream &os, phase &ph, bool last) {
+    os << "    {\"phase\": \"" << ph.name << "\", \"count\": " << ph.count
+       << ", \"errors\": " << ph.errors << ", \"bytes\": " << ph.bytes
+       << ", \"seconds\": " << ph.seconds
+       << ", \"exprs_per_s\": " << (ph.seconds > 0 ? ph.count / ph.seconds : 0)
+       << ", \"mb_per_s\": " << (ph.seconds > 0 ? ph.bytes / ph.seconds / 1e6 : 0);
+       
+    if (!ph.latencies.empty()) {
+        sort(ph.latencies.begin(), ph.latencies.end());
+        os << ", \"latency_ns\": {\"p50\": " << percentile(ph.latencies, 50)
+           << ", \"p90\": " << percentile(ph.latencies, 90)
+           << ", \"p99\": " << percentile(ph.latencies, 99)
+           << ", \"p999\": " << percentile(ph.latencies, 99.9)
+           << ", \"max\": " << ph.latencies.back() << "}";
+    }
+    for (size_t i = 0; i<ph.extra.size(); i++) {
+        os << ", \"" << ph.extra[i].first << "\": " << ph.extra[i].second;
+    }
+    os << "}" << (last ? "" : ",") << endl;
+}
+
+/******************************************************************************
+                                PHASES
+ ******************************************************************************/
+ 
+/* Compiles each expression, keeping the programs for the run phase. Programs
+ of rejected expressions are left empty.
+ */
+template <class T>
+static phase time_parse(basic_calculator<T> &calc, const vector<string> &corpus,
+                        vector<typename basic_calculator<T>::compiled_expression> &programs) {
+    phase ph("parse");
+    programs.resize(corpus.size());
+    ph.latencies.reserve(corpus.size());
+    
+    bench_clock::time_point all = bench_clock::now();
+    for (size_t i = 0; i<corpus.size(); i++) {
+        bench_clock::time_point start = bench_clock::now();
+        try {
+            programs[i] = calc.compile(corpus[i].data(), corpus[i].length());
+        }
+        catch (exception &e) {
+            ph.errors++;
+        }
+        ph.latencies.push_back(chrono::duration<double, nano>(bench_clock::now() - start).count());
+        ph.bytes += corpus[i].length() + 1;
+    }
+    ph.seconds = since(all);
+    ph.count = corpus.size();
+    return ph;
+}
+
+/* Runs each program that compiled */
+template <class T>
+static phase time_run(string name, basic_calculator<T> &calc, const vector<string> &corpus,
+                      const vector<typename basic_calculator<T>::compiled_expression> &programs) {
+    phase ph(name);
+    ph.latencies.reserve(corpus.size());
+    volatile T sink = 0;
+    
+    bench_clock::time_point all = bench_clock::now();
+    for (size_t i = 0; i<programs.size(); i++) {
+        if (programs[i].code.empty()) { continue; }
+        bench_clock::time_point start = bench_clock::now();
+        try {
+            sink = sink + calc.run(programs[i]);
+        }
+        catch (exception &e) {
+            ph.errors++;
+        }
+        ph.latencies.push_back(chrono::duration<double, nano>(bench_clock::now() - start).count());
+        ph.bytes += corpus[i].length() + 1;
+        ph.count++;
+    }
+    ph.seconds = since(all);
+    return ph;
+}
+
+/* Runs each program that compiled as a hot expression translated into
+ machine code after its first run, and reports how many of them were
+ translated and how many results differ from the interpreter's. Only double
+ programs are translated, so with floats this times the interpreter.
+ */
+template <class T>
+static phase time_native(basic_calculator<T> &calc, const vector<string> &corpus,
+                         const vector<typename basic_calculator<T>::compiled_expression> &programs) {
+    phase ph("run_native");
+    ph.latencies.reserve(corpus.size());
+    size_t native = 0, mismatches = 0;
+    volatile T sink = 0;
+    
+    for (size_t i = 0; i<programs.size(); i++) {
+        if (programs[i].code.empty()) { continue; }
+        hot_expression<T> hot(calc, programs[i], 1);
+        T expected;
+        try {
+            expected = calc.run(programs[i]);
+            hot.evaluate(NULL);
+        }
+        catch (exception &e) {
+            ph.errors++;
+            continue;
+        }
+        if (hot.is_native()) { native++; }
+        
+        bench_clock::time_point start = bench_clock::now();
+        T result = hot.evaluate(NULL);
+        double ns = chrono::duration<double, nano>(bench_clock::now() - start).count();
+        sink = sink + result;
+        if (result != expected && !(result != result && expected != expected)) { mismatches++; }
+        ph.latencies.push_back(ns);
+        ph.seconds += ns / 1e9;
+        ph.bytes += corpus[i].length() + 1;
+        ph.count++;
+    }
+    
+    ph.extra.push_back(make_pair("native", (double)native));
+    ph.extra.push_back(make_pair("mismatches", (double)mismatches));
+    return ph;
+}
+
+/* Parses and runs each expression with a reused context, as a file is loaded */
+template <class T>
+static phase time_evaluate(basic_calculator<T> &calc, const vector<string> &corpus) {
+    phase ph("evaluate");
+    ph.latencies.reserve(corpus.size());
+    typename basic_calculator<T>::evaluator_context ctx;
+    volatile T sink = 0;
+    
+    bench_clock::time_point all = bench_clock::now();
+    for (size_t i = 0; i<corpus.size(); i++) {
+        bench_clock::time_point start = bench_clock::now();
+        try {
+            sink = sink + calc.evaluate(corpus[i].data(), corpus[i].length(), ctx);
+        }
+        catch (exception &e) {
+            ph.errors++;
+        }
+        ph.latencies.push_back(chrono::duration<double, nano>(bench_clock::now() - start).count());
+        ph.bytes += corpus[i].length() + 1;
+    }
+    ph.seconds = since(all);
+    ph.count = corpus.size();
+    return ph;
+}
+
+/* Evaluates the corpus once to warm a context up, then again timed. Once warm,
+ the context must not grow any of its buffers, so the second pass reports
+ the times one grew and every allocation made, which should both be 0.
+ */
+template <class T>
+static phase time_steady(basic_calculator<T> &calc, const vector<string> &corpus) {
+    phase ph("steady_state");
+    typename basic_calculator<T>::evaluator_context ctx;
+    volatile T sink = 0;
+    T result;
+    diagnostic error;
+    
+    for (size_t i = 0; i<corpus.size(); i++) {
+        calc.try_evaluate(corpus[i].data(), corpus[i].length(), ctx, result, error);
+    }
+    size_t warm = ctx.allocations();
+    size_t heap = heap_allocations;
+    
+    bench_clock::time_point all = bench_clock::now();
+    for (size_t i = 0; i<corpus.size(); i++) {
+        if (calc.try_evaluate(corpus[i].data(), corpus[i].length(), ctx, result, error)) { sink = sink + result; }
+        else { ph.errors++; }
+        ph.bytes += corpus[i].length() + 1;
+    }
+    ph.seconds = since(all);
+    heap = heap_allocations - heap;
+    ph.count = corpus.size();
+    ph.extra.push_back(make_pair(string("allocations"), (double)(ctx.allocations() - warm)));
+    ph.extra.push_back(make_pair(string("heap_allocations"), (double)heap));
+    return ph;
+}
+
+/* Changes the last digit of each valid expression after evaluating it, and
+ evaluates it again incrementally. Only the edit and the evaluation after it
+ are timed. Also reports the average number of characters parsed again and
+ of subtrees computed again for each edit.
+ */
+template <class T>
+static phase time_edit(basic_calculator<T> &calc, const vector<string> &corpus) {
+    phase ph("edit");
+    ph.latencies.reserve(corpus.size());
+    size_t reparsed = 0, recomputed = 0;
+    volatile T sink = 0;
+    
+    for (size_t i = 0; i<corpus.size(); i++) {
+        incremental_expression<T> exp(calc, corpus[i]);
+        size_t digit = corpus[i].find_last_of("0123456789");
+        if (!exp.valid() || digit == string::npos) { continue; }
+        try { sink = sink + exp.value(); } catch (exception &e) { }
+        
+        string replacement(1, corpus[i][digit] == '9' ? '1' : corpus[i][digit] + 1);
+        bench_clock::time_point start = bench_clock::now();
+        try {
+            exp.edit(digit, 1, replacement);
+            sink = sink + exp.value();
+        }
+        catch (exception &e) {
+            ph.errors++;
+        }
+        double ns = chrono::duration<double, nano>(bench_clock::now() - start).count();
+        ph.latencies.push_back(ns);
+        ph.seconds += ns / 1e9;
+        ph.bytes += corpus[i].length() + 1;
+        ph.count++;
+        reparsed += exp.reparsed();
+        recomputed += exp.recomputed();
+    }
+    
+    ph.extra.push_back(make_pair("reparsed_per_edit", ph.count ? (double)reparsed / ph.count : 0));
+    ph.extra.push_back(make_pair("recomputed_per_edit", ph.count ? (double)recomputed / ph.count : 0));
+    return ph;
+}
+
+/* Recomputes a sheet in parallel after each change of the cell every other
+ cell uses, and reads each cell of a copy of it computed one at a time by get
+ to check the results. X uses the changed cell and is started first, along
+ with many filler cells, while a long chain of cells leads to Y, which also
+ uses X, so Y is ready to start while the first cells are still being
+ started. Reports the cells whose values differ, which should be none.
+ */
+template <class T>
+static phase time_recompute(unsigned threads) {
+    const int chain = 3000, filler = 20000, rounds = 5;
+    phase ph("recompute");
+    cell_sheet<T> sheet, check;
+    vector<string> names;
+    size_t mismatches = 0;
+    
+    for (int s = 0; s<2; s++) {
+        cell_sheet<T> &cs = s ? check : sheet;
+        cs.set_value("c0", 1);
+        cs.set("X", "c0+1");
+        cs.set("z0", "c0+1");
+        for (int i = 1; i<chain; i++) {
+            cs.set("z" + to_string(i), "z" + to_string(i-1) + "+1");
+        }
+        for (int i = 0; i<filler; i++) { cs.set("f" + to_string(i), "c0*2"); }
+        cs.set("Y", "X+z" + to_string(chain-1));
+    }
+    names.push_back("X");
+    names.push_back("Y");
+    for (int i = 0; i<chain; i++) { names.push_back("z" + to_string(i)); }
+    for (int i = 0; i<filler; i++) { names.push_back("f" + to_string(i)); }
+    
+    for (int r = 0; r<rounds; r++) {
+        sheet.set_value("c0", r+1);
+        check.set_value("c0", r+1);
+        
+        bench_clock::time_point start = bench_clock::now();
+        sheet.recompute(max(threads, 2u));
+        ph.seconds += since(start);
+        ph.count += sheet.recomputed();
+        
+        for (size_t i = 0; i<names.size(); i++) {
+            if (sheet.get(names[i]) != check.get(names[i])) { mismatches++; }
+        }
+    }
+    
+    ph.extra.push_back(make_pair("mismatches", (double)mismatches));
+    return ph;
+}
+
+/* Loads the whole corpus file in each of the ways main can, printing the
+ results of the mapped load into a string. The shared load also reports how
+ many subexpressions were shared.
+ */
+template <class T>
+static void time_load(const string &fName, size_t count, size_t bytes, unsigned threads,
+                      vector<phase> &phases) {
+    const char *names[] = { "load_serial", "load_parallel", "load_mapped", "load_shared" };
+    
+    for (int mode = 0; mode<4; mode++) {
+        if (mode == 1 && threads <= 1) { continue; }
+        
+        phase ph(names[mode]);
+        ostringstream err;
+        ifstream readf;
+        
+        bench_clock::time_point start = bench_clock::now();
+        basic_calculator<T> calc;
+        if (mode == 3) { calc.add_shared(fName, readf, err); }
+        else {
+            calc = mode == 0 ? basic_calculator<T>(fName, readf, err)
+                 : mode == 1 ? basic_calculator<T>(fName, readf, err, threads)
+                 : basic_calculator<T>(fName, err, threads);
+        }
+        ph.seconds = since(start);
+        ph.count = count;
+        ph.bytes = bytes;
+        ph.errors = count - calc.size();
+        
+        if (mode == 3) {
+            const shared_dag<T> *dag = calc.get_dag();
+            ph.extra.push_back(make_pair("subexpressions", (double)dag->references()));
+            ph.extra.push_back(make_pair("nodes", (double)dag->nodes_created()));
+            ph.extra.push_back(make_pair("shared", (double)(dag->references() - dag->nodes_created())));
+        }
+        phases.push_back(ph);
+        
+        if (mode == 2) {
+            phase pr("print");
+            ostringstream out;
+            
+            start = bench_clock::now();
+            out << calc;
+            pr.seconds = since(start);
+            pr.count = calc.size();
+            pr.bytes = out.str().length();
+            phases.push_back(pr);
+            
+            string saved = fName + ".saved";
+            phase sv("save");
+            start = bench_clock::now();
+            calc.save(saved);
+            sv.seconds = since(start);
+            sv.count = calc.size();
+            
+            phase rl("reload");
+            start = bench_clock::now();
+            result_file<T> reloaded(saved);
+            size_t text = 0;
+            volatile T sink = 0;
+            for (size_t i = 0; i<reloaded.size(); i++) {
+                sink = sink + reloaded.get_result((int)i);
+                text += reloaded.get_expression((int)i).length();
+            }
+            rl.seconds = since(start);
+            rl.count = reloaded.size();
+            
+            ifstream size(saved.c_str(), ios::binary | ios::ate);
+            sv.bytes = rl.bytes = (size_t)size.tellg();
+            rl.extra.push_back(make_pair("text_bytes", (double)text));
+            phases.push_back(sv);
+            phases.push_back(rl);
+            remove(saved.c_str());
+        }
+    }
+}
+
+/******************************************************************************
+                                MAIN PROGRAM
+ ******************************************************************************/
+ 
+template <class T>
+static int run_bench(const workload_options &opt, unsigned threads, const char *type) {
+    vector<string> corpus = workload(opt).generate();
+    
+    // steady_state also evaluates expressions with unbound variables, errors
+    // like any other, whose names must not allocate either
+    workload_options named_opt = opt;
+    named_opt.variable_rate = max(opt.variable_rate, 0.1);
+    vector<string> named = workload(named_opt).generate();
+    
+    size_t bytes = 0;
+    for (size_t i = 0; i<corpus.size(); i++) { bytes += corpus[i].length() + 1; }
+    
+    // Corpus file for the load phases
+    char fName[] = "/tmp/calc_bench_XXXXXX";
+    int fd = mkstemp(fName);
+    if (fd < 0) {
+        cerr << "Unable to create corpus file" << endl;
+        return 1;
+    }
+    close(fd);
+    {
+        ofstream out(fName);
+        for (size_t i = 0; i<corpus.size(); i++) { out << corpus[i] << '\n'; }
+    }
+    
+    basic_calculator<T> calc;
+    vector<typename basic_calculator<T>::compiled_expression> programs;
+    vector<phase> phases;
+    
+    phases.push_back(time_parse(calc, corpus, programs));
+    phases.push_back(time_run("run", calc, corpus, programs));
+    
+    for (size_t i = 0; i<programs.size(); i++) {
+        if (!programs[i].code.empty()) { programs[i] = calc.optimize(programs[i]); }
+    }
+    phases.push_back(time_run("run_optimized", calc, corpus, programs));
+    phase native = time_native(calc, corpus, programs);
+    phases.push_back(native);
+    phases.push_back(time_evaluate(calc, corpus));
+    phase steady = time_steady(calc, named);
+    phases.push_back(steady);
+    phases.push_back(time_edit(calc, corpus));
+    phase recompute = time_recompute<T>(threads);
+    phases.push_back(recompute);
+    time_load<T>(fName, corpus.size(), bytes, threads, phases);
+    remove(fName);
+    
+    cout << "{" << endl;
+    cout << "  \"workload\": {\"type\": \"" << type << "\", \"count\": " << opt.count
+         << ", \"bytes\": " << bytes << ", \"depth\": " << opt.depth
+         << ", \"operands\": " << opt.operands << ", \"mix\": [" << opt.weights[0];
+    for (int i = 1; i<5; i++) { cout << ", " << opt.weights[i]; }
+    cout << "], \"digits\": " << opt.literal_digits << ", \"errors\": " << opt.error_rate
+         << ", \"repeat\": " << opt.repeat_rate << ", \"variables\": " << opt.variable_rate
+         << ", \"seed\": " << opt.seed
+         << ", \"threads\": " << threads << "}," << endl;
+    cout << "  \"phases\": [" << endl;
+    for (size_t i = 0; i<phases.size(); i++) {
+        print_phase(cout, phases[i], i+1 == phases.size());
+    }
+    cout << "  ]" << endl << "}" << endl;
+    
+    // Evaluating with a warm context must not allocate
+    if (steady.extra[0].second != 0 || steady.extra[1].second != 0) {
+        cerr << "steady_state: context grew " << steady.extra[0].second
+             << " times and " << steady.extra[1].second
+             << " allocations were made after warming up" << endl;
+        return 1;
+    }
+    
+    // Machine code must give the interpreter's results
+    if (native.extra[1].second != 0) {
+        cerr << "run_native: " << native.extra[1].second
+             << " results differ from the interpreter's" << endl;
+        return 1;
+    }
+    
+    // Cells computed in parallel must hold what get computes
+    if (recompute.extra[0].second != 0) {
+        cerr << "recompute: " << recompute.extra[0].second
+             << " cells differ from the ones computed by get" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, const char * argv[]) {
+    workload_options opt;
+    unsigned threads = 4;
+    bool dbl = false;
+    const char *corpus = NULL;
+    
+    for (int i = 1; i<argc; i++) {
+        string arg = argv[i];
+        const char *val = i+1 < argc ? argv[i+1] : NULL;
+        
+        if (arg == "-d") { dbl = true; continue; }
+        if (!val) {
+            cerr << "ERROR: Missing value for " << arg << endl;
+            return 1;
+        }
+        i++;
+        
+        if (arg == "--count") { opt.count = strtoul(val, NULL, 10); }
+        else if (arg == "--depth") { opt.depth = atoi(val); }
+        else if (arg == "--operands") { opt.operands = max(1, atoi(val)); }
+        else if (arg == "--digits") { opt.literal_digits = max(1, atoi(val)); }
+        else if (arg == "--errors") { opt.error_rate = atof(val); }
+        else if (arg == "--repeat") { opt.repeat_rate = atof(val); }
+        else if (arg == "--variables") { opt.variable_rate = atof(val); }
+        else if (arg == "--seed") { opt.seed = strtoull(val, NULL, 10) | 1; }
+        else if (arg == "--threads") { threads = atoi(val); }
+        else if (arg == "--corpus") { corpus = val; }
+        else if (arg == "--mix") {
+            if (sscanf(val, "%lf,%lf,%lf,%lf,%lf", &opt.weights[0], &opt.weights[1],
+                       &opt.weights[2], &opt.weights[3], &opt.weights[4]) != 5) {
+                cerr << "ERROR: --mix takes five comma separated weights" << endl;
+                return 1;
+            }
+        }
+        else {
+            cerr << "ERROR: Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    
+    if (corpus) { // Only write the corpus
+        vector<string> exps = workload(opt).generate();
+        ofstream out(corpus);
+        for (size_t i = 0; i<exps.size(); i++) { out << exps[i] << '\n'; }
+        return out.good() ? 0 : 1;
+    }
+    
+    return dbl ? run_bench<double>(opt, threads, "double") : run_bench<float>(opt, threads, "float");
+}
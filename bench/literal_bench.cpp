@@ -0,0 +1,112 @@
+/*******************************************************************************
+ Title          :   literal_bench.cpp
+ Author         :   Anna Cristina Karingal
+ Created on     :   Oct 17, 2026
+ 
+ Description    :   Microbenchmark of the numeric literal scanner against the
+                    stringstream extraction evaluate used before it. Both
+                    convert the same set of random literals; the results are
+                    checked to be identical and the time per literal of each
+                    is printed.
+ 
+ Usage          :   ./literal_bench [count]
+ 
+                    Where count is the number of literals to convert, one
+                    million by default.
+ 
+ Build with     :   g++ -std=c++14 -O2 -I.. -o literal_bench literal_bench.cpp
+                    ../literal.cpp
+ 
+ Last modified  :   Oct 17, 2026
+ 
+ *******************************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctype.h>
+
+#include "literal.h"
+using namespace std;
+
+/* Converts a literal the way evaluate did before the scanner: each character
+ is streamed into a stringstream, then a float is extracted from it.
+ */
+static size_t stream_number(const char *s, size_t length, float &value) {
+    stringstream opss;
+    opss << s[0];
+    
+    size_t j = 1;
+    while (j < length && (isdigit(s[j]) || s[j] == '.')) {
+        opss << s[j];
+        j++;
+    }
+    opss >> value;
+    return j;
+}
+
+/* Returns a random literal of up to 8 integer and 6 fraction digits */
+static string random_literal() {
+    string s;
+    int whole = 1 + rand() % 8;
+    for (int i = 0; i<whole; i++) { s += char('0' + rand() % 10); }
+    
+    if (rand() % 2) {
+        s += '.';
+        int fraction = rand() % 7;
+        for (int i = 0; i<fraction; i++) { s += char('0' + rand() % 10); }
+    }
+    return s;
+}
+
+/******************************************************************************
+                                MAIN PROGRAM
+ ******************************************************************************/
+
+int main(int argc, const char * argv[]) {
+    
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+    
+    // Literals are laid out one after the other, separated by spaces, as they
+    // would be in an expression
+    string text;
+    vector<size_t> start;
+    for (size_t i = 0; i<count; i++) {
+        start.push_back(text.length());
+        text += random_literal();
+        text += ' ';
+    }
+    
+    vector<float> scanned(count), streamed(count);
+    
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i<count; i++) {
+        scan_number(text.data() + start[i], text.length() - start[i], scanned[i]);
+    }
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    for (size_t i = 0; i<count; i++) {
+        stream_number(text.data() + start[i], text.length() - start[i], streamed[i]);
+    }
+    chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+    
+    // Both must agree exactly
+    size_t mismatches = 0;
+    for (size_t i = 0; i<count; i++) {
+        if (memcmp(&scanned[i], &streamed[i], sizeof(float)) != 0) { mismatches++; }
+    }
+    
+    double scan_ns = chrono::duration<double, nano>(t1 - t0).count() / count;
+    double stream_ns = chrono::duration<double, nano>(t2 - t1).count() / count;
+    
+    cout << "literals     " << count << endl;
+    cout << "scan_number  " << scan_ns << " ns/literal" << endl;
+    cout << "stringstream " << stream_ns << " ns/literal" << endl;
+    cout << "speedup      " << stream_ns / scan_ns << "x" << endl;
+    cout << "mismatches   " << mismatches << endl;
+    
+    return mismatches == 0 ? 0 : 1;
+}
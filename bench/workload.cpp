@@ -0,0 +1,128 @@
+/*****************************************************************************
+ Title:             workload.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Synthetic Workload Generator Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "workload.h"
+
+/* Default workload options */
+workload_options::workload_options()
+    : count(100000), depth(3), operands(8), literal_digits(4), variable_rate(0),
+      error_rate(0), repeat_rate(0), seed(1) {
+    weights[0] = weights[1] = weights[2] = weights[3] = 1;
+    weights[4] = 0.25;
+}
+
+/* Workload constructor */
+workload::workload(const workload_options &opt) : opt(opt), state(opt.seed) { }
+
+/* xorshift64* generator: fast, and the same on every platform */
+uint64_t workload::next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+double workload::uniform() {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Literal with up to literal_digits digits, half of them with a decimal point
+ somewhere inside
+ */
+void workload::literal(string &out) {
+    int digits = 1 + next() % opt.literal_digits;
+    int point = (next() % 2) ? (int)(next() % digits) : -1;
+    
+    for (int i = 0; i<digits; i++) {
+        out += char('0' + next() % 10);
+        if (i == point && i+1 < digits) { out += '.'; }
+    }
+}
+
+/* Picks an operator with probability proportional to its weight */
+char workload::op() {
+    static const char ops[] = "+-*/^";
+    
+    double total = 0;
+    for (int i = 0; i<5; i++) { total += opt.weights[i]; }
+    
+    double r = uniform() * total;
+    for (int i = 0; i<5; i++) {
+        if (r < opt.weights[i]) { return ops[i]; }
+        r -= opt.weights[i];
+    }
+    return '+';
+}
+
+/* A literal or variable, or at depth > 0 a chain of subexpressions joined by
+ operators, wrapped in parentheses when nested. Spaces are sprinkled between
+ tokens. Some variable names are too long to fit in a string without
+ allocating.
+ */
+void workload::expression(string &out, int depth, int &operands) {
+    static const char *names[] = { "x", "y", "rate", "principal_amount", "interest_rate_per_period" };
+    
+    if (depth == 0 || operands <= 1) {
+        if (uniform() < opt.variable_rate) { out += names[next() % 5]; }
+        else { literal(out); }
+        operands--;
+        return;
+    }
+    
+    int terms = 2 + next() % 3;
+    for (int i = 0; i<terms && operands > 0; i++) {
+        if (i > 0) {
+            if (next() % 2) { out += ' '; }
+            out += op();
+            if (next() % 2) { out += ' '; }
+        }
+        
+        bool nested = depth > 1 && next() % 2;
+        if (nested) { out += '('; }
+        expression(out, nested ? depth-1 : 0, operands);
+        if (nested) { out += ')'; }
+    }
+}
+
+/* Applies one of: an unmatched parenthesis, a division by zero, an invalid
+ character, a number with two decimal points or a missing operand.
+ */
+void workload::corrupt(string &exp) {
+    switch (next() % 5) {
+        case 0: exp = "(" + exp; break;
+        case 1: exp += "/0"; break;
+        case 2: exp.insert(next() % (exp.length()+1), 1, '#'); break;
+        case 3: exp += "+1.2.3"; break;
+        default: exp += "*"; break;
+    }
+}
+
+/* Generates each expression in turn, repeating or corrupting a share of them
+ */
+vector<string> workload::generate() {
+    vector<string> corpus;
+    corpus.reserve(opt.count);
+    
+    for (size_t i = 0; i<opt.count; i++) {
+        if (!corpus.empty() && uniform() < opt.repeat_rate) {
+            corpus.push_back(corpus[next() % corpus.size()]);
+            continue;
+        }
+        
+        string exp;
+        int operands = opt.operands;
+        expression(exp, opt.depth, operands);
+        
+        if (uniform() < opt.error_rate) { corrupt(exp); }
+        corpus.push_back(exp);
+    }
+    
+    return corpus;
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ Title:             workload.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Synthetic Workload Generator (Header File)
+                        - Generates corpora of random infix expressions with
+                            a controllable size, nesting depth, operator mix,
+                            literal length and rate of variables and of
+                            invalid expressions
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___workload__
+#define ___workload__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+using namespace std;
+
+// Shape of a generated corpus
+struct workload_options {
+    size_t count;           // Number of expressions
+    int depth;              // Deepest nesting of operations
+    int operands;           // Operands per expression, at most
+    double weights[5];      // Relative frequency of + - * / ^
+    int literal_digits;     // Digits in each literal, at most
+    double variable_rate;   // Fraction of operands that are variables
+    double error_rate;      // Fraction of expressions made invalid
+    double repeat_rate;     // Fraction of expressions copied from earlier ones
+    uint64_t seed;
+    
+    /* workload_options();
+     Constructor that sets a small corpus of shallow expressions without
+     variables or errors, with all operators equally likely except '^'.
+     */
+    workload_options();
+};
+
+class workload {
+    
+    workload_options opt;
+    uint64_t state;         // State of the random number generator
+    
+    /* uint64_t next();
+     Returns the next random number.
+     */
+    uint64_t next();
+    
+    /* double uniform();
+     Returns a random number in [0, 1).
+     */
+    double uniform();
+    
+    /* void literal(string &out);
+     Appends a random literal.
+     */
+    void literal(string &out);
+    
+    /* char op();
+     Returns a random operator, following the operator weights.
+     */
+    char op();
+    
+    /* void expression(string &out, int depth, int &operands);
+     Appends a random expression nested up to depth levels, using at most
+     operands literals and variables.
+     */
+    void expression(string &out, int depth, int &operands);
+    
+    /* void corrupt(string &exp);
+     Makes a valid expression invalid in one of the ways the calculator
+     checks for.
+     */
+    void corrupt(string &exp);
+    
+public:
+    
+    /* workload(const workload_options &opt);
+     Constructor for a generator of corpora of the given shape.
+     */
+    workload(const workload_options &opt);
+    
+    /* vector<string> generate();
+     Returns opt.count random expressions. The same options always give the
+     same expressions.
+     */
+    vector<string> generate();
+    
+};
+
+#endif
@@ -1,27 +1,41 @@
-
+ 
 /*****************************************************************************
  Title:             calculator.cpp
  Author:            Anna Cristina Karingal
  Created on:        Nov 9, 2014
  Description:       Calculator Class Implementation
  
- Last Modified:     Nov 18, 2014
+ Last Modified:     Oct 17, 2026
  
  *****************************************************************************/
 
 #include "calculator.h"
+#include "kernels.h"
+#include "literal.h"
+#include "optimizer.h"
+#include "tree_evaluator.h"
+#include "jit.h"
+#include "shared_dag.h"
+#include "cell_sheet.h"
+#include "result_file.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include <cstring>
 
 /* Calculator constructor that takes no parameters. Initializes empty vector
  for all_expressions.
  */
-calculator::calculator(){ }
+template <class T>
+basic_calculator<T>::basic_calculator() : dead_text(0), optimization(OPTIMIZE_OFF), tree_length(0) { }
 
 /* Calculator constructor that attempts to initialize all_expressions vector
  from user given file. Reads expression, tries to calculate expression result. 
  If successful, stores both expression and result in vector. If fails and
  expression is invalid, prints only expression to error stream.
  */
-calculator::calculator(string fName, ifstream &readf, ostream &err) throw(invalid_argument){
+template <class T>
+basic_calculator<T>::basic_calculator(string fName, ifstream &readf, ostream &err) throw(invalid_argument)
+    : dead_text(0), optimization(OPTIMIZE_OFF), tree_length(0) {
     
     readf.open(fName.c_str());
     
@@ -31,39 +45,591 @@ calculator::calculator(string fName, ifstream &readf, ostream &err) throw(invali
     }
     
     if (readf.is_open()) {
+        evaluator_context ctx;
+        string &line = ctx.text;
+        uint32_t line_number = 0;
         while (!readf.eof()) {
             // Read line
             evaluated_expression ee;
-            getline(readf, ee.exp);
+            {
+                CALC_PROFILE_SCOPE(PROFILE_READ);
+                getline(readf, line);
+                CALC_PROFILE_READ(line.length() + 1);
+            }
             
-            try {
-                // Attempt to evaluate expression
-                ee.result = evaluate(ee.exp);
-                
-                // No exception thrown, add to vector
-                all_expressions.push_back(ee);
+            // Attempt to evaluate expression
+            diagnostic error;
+            if (try_evaluate(line.data(), line.length(), ctx, ee.result, error)) {
+                // Valid, add text, unless a line had the same, and expression
+                all_expressions.push_back(intern_copy(line.data(), line.length()), ee.result);
             }
-            catch(...) {
-                // Failed to evaluate result, print to error stream instead
-                err << ee.exp << endl;
+            else {
+                // Failed to evaluate result, add it to the table of invalid
+                // lines instead
+                CALC_PROFILE_ERROR(error.kind);
+                invalid_expression ie;
+                ie.offset = text.length();
+                ie.length = line.length();
+                ie.line = line_number;
+                ie.column = (uint32_t)error.offset;
+                ie.kind = error.kind;
+                text += line;
+                invalid.push_back(ie);
             }
-            
+            line_number++;
         }
     }
     
     // Close file
     readf.close();
     
+    write_invalid(err, 0);
+}
+
+/* Calculator constructor that initializes all_expressions from user given file
+ using a pool of worker threads. Reads the whole file into the calculator's
+ text and evaluates it in place.
+ */
+template <class T>
+basic_calculator<T>::basic_calculator(string fName, ifstream &readf, ostream &err, unsigned threads, size_t cache_capacity, optimize_mode optimization, size_t tree_length) throw(invalid_argument)
+    : dead_text(0), optimization(optimization), tree_length(tree_length) {
+    
+    enable_cache(cache_capacity);
+    
+    readf.open(fName.c_str());
+    
+    // Throw an exception if file is invalid and cannot open
+    if (readf.fail()){
+        throw invalid_argument(fName);
+    }
+    
+    // Read entire file
+    {
+        CALC_PROFILE_SCOPE(PROFILE_READ);
+        stringstream contents;
+        contents << readf.rdbuf();
+        readf.close();
+        text = contents.str();
+        CALC_PROFILE_READ(text.length());
+    }
+    
+    load(text.data(), text.length(), 0, threads);
+    write_invalid(err, 0);
+}
+
+/* Calculator constructor that memory maps the user given file and evaluates it
+ in place. Throws exception if the file cannot be mapped.
+ */
+template <class T>
+basic_calculator<T>::basic_calculator(string fName, ostream &err, unsigned threads, size_t cache_capacity, optimize_mode optimization, size_t tree_length) throw(invalid_argument)
+    : dead_text(0), optimization(optimization), tree_length(tree_length) {
+    
+    enable_cache(cache_capacity);
+    
+    // Pages are read as they are first touched, while evaluating
+    {
+        CALC_PROFILE_SCOPE(PROFILE_READ);
+        input.reset(new mapped_file(fName));
+        CALC_PROFILE_READ(input->size());
+    }
+    
+    load(input->data(), input->size(), 0, threads);
+    write_invalid(err, 0);
+}
+
+/* Splits the buffer into lines the same way the single threaded constructor's
+ getline loop does: text after the last newline is a line too, even when empty.
+ The buffer is cut into chunks of about the same number of characters, each
+ ending just after a newline, so one chunk of very long lines is no more work
+ than any other, and each chunk is a task on the thread pool. Each task records
+ the valid and invalid lines of its chunk in its own slot; once all are done
+ the slots are read in order, adding results to the vector and invalid lines,
+ numbered from the start of the buffer, to the invalid table. Chunks of a mapped input file are
+ released once evaluated so the file is never held in memory all at once. A
+ line long enough to be evaluated as a tree forks its parts onto the same
+ pool, where workers that have finished their chunks pick them up.
+ */
+template <class T>
+void basic_calculator<T>::load(const char *buf, size_t length, size_t base, unsigned threads) {
+    
+    // Cut buffer into chunks
+    const size_t chunk_size = 64 * 1024;
+    vector<size_t> chunk_start;
+    chunk_start.push_back(0);
+    while (chunk_start.back() + chunk_size < length) {
+        size_t from = chunk_start.back() + chunk_size;
+        const char *newline = (const char *)memchr(buf + from, '\n', length - from);
+        if (newline == NULL) { break; }
+        chunk_start.push_back(newline - buf + 1);
+    }
+    size_t chunks = chunk_start.size();
+    chunk_start.push_back(length);
+    
+    // Valid and invalid expressions of each chunk, with invalid lines
+    // numbered from the start of the chunk, and its number of lines
+    vector<vector<evaluated_expression> > valid(chunks);
+    vector<vector<invalid_expression> > failed(chunks);
+    vector<uint32_t> lines(chunks);
+    
+    const bool mapped = input && buf == input->data();
+    
+    thread_pool pool(threads);
+    for (size_t c = 0; c<chunks; c++) {
+        pool.submit([this, buf, base, mapped, chunks, c, &pool, &chunk_start, &valid, &failed, &lines] {
+            evaluator_context ctx;
+            ctx.pool = &pool;
+            size_t pos = chunk_start[c];
+            size_t end = chunk_start[c+1];
+            uint32_t line = 0;
+            
+            while (pos <= end) {
+                const char *newline = (const char *)memchr(buf + pos, '\n', end - pos);
+                
+                // Only the last chunk has a line that does not end in newline
+                if (newline == NULL && c+1 < chunks) { break; }
+                size_t stop = newline ? newline - buf : end;
+                
+                evaluated_expression ee;
+                ee.offset = base + pos;
+                ee.length = stop - pos;
+                
+                // Attempt to evaluate expression
+                diagnostic error;
+                if (try_cached_evaluate(buf + pos, ee.length, ctx, ee.result, error)) {
+                    ee.hash = expression_store<T>::hash(buf + pos, ee.length);
+                    valid[c].push_back(ee);
+                }
+                else {
+                    CALC_PROFILE_ERROR(error.kind);
+                    invalid_expression ie;
+                    ie.offset = ee.offset;
+                    ie.length = ee.length;
+                    ie.line = line;
+                    ie.column = (uint32_t)error.offset;
+                    ie.kind = error.kind;
+                    failed[c].push_back(ie);
+                }
+                line++;
+                pos = stop + 1;
+            }
+            lines[c] = line;
+            
+            if (mapped) { input->release(chunk_start[c], end - chunk_start[c]); }
+        });
+    }
+    pool.wait();
+    
+    // Merge results in order of the file
+    size_t count = all_expressions.size();
+    for (size_t c = 0; c<chunks; c++) { count += valid[c].size(); }
+    all_expressions.reserve(count);
+    
+    uint32_t first_line = 0;
+    for (size_t c = 0; c<chunks; c++) {
+        for (size_t i = 0; i<valid[c].size(); i++) { append(valid[c][i]); }
+        
+        for (size_t i = 0; i<failed[c].size(); i++) {
+            failed[c][i].line += first_line;
+            invalid.push_back(failed[c][i]);
+        }
+        first_line += lines[c];
+    }
+}
+
+/* Writes the text of each invalid line, wherever it is, followed by a newline.
+ The stream is flushed once, after the last.
+ */
+template <class T>
+void basic_calculator<T>::write_invalid(ostream &err, size_t from) const {
+    CALC_PROFILE_SCOPE(PROFILE_OUTPUT);
+    for (size_t i = from; i<invalid.size(); i++) {
+        CALC_PROFILE_WRITTEN(invalid[i].length + 1);
+        err.write(expression_text(invalid[i].offset), invalid[i].length);
+        err << '\n';
+    }
+    err.flush();
+}
+
+/* Reads and evaluates one line at a time with a single evaluator context,
+ writing each to the result or error sink. Before reading a line, if no input
+ is ready to be read without waiting, the sinks are flushed so results are not
+ held back while the input is idle.
+ */
+template <class T>
+void basic_calculator<T>::stream(istream &in, ostream &out, ostream &err, size_t batch_lines) {
+    evaluator_context ctx;
+    string line;
+    output_sink results(out, batch_lines);
+    output_sink errors(err, batch_lines);
+    
+    while (true) {
+        if (in.rdbuf()->in_avail() <= 0) {
+            results.flush();
+            errors.flush();
+        }
+        {
+            CALC_PROFILE_SCOPE(PROFILE_READ);
+            if (!getline(in, line)) { break; }
+            CALC_PROFILE_READ(line.length() + 1);
+        }
+        
+        // Attempt to evaluate expression
+        T result;
+        diagnostic error;
+        if (try_cached_evaluate(line.data(), line.length(), ctx, result, error)) {
+            CALC_PROFILE_SCOPE(PROFILE_OUTPUT);
+            results.write_fixed(result, 2);
+            results.write(" = ", 3);
+            results.write(line.data(), line.length());
+            results.end_line();
+        }
+        else {
+            // Failed to evaluate result, print to error stream instead
+            CALC_PROFILE_ERROR(error.kind);
+            errors.write(line.data(), line.length());
+            errors.end_line();
+        }
+    }
+}
+
+/* Returns the number of characters before offset that are not spaces. The
+ normalized text of an expression keeps every such character, so this is the
+ same for every spacing of it.
+ */
+static size_t solid_offset(const char *exp, size_t length, size_t offset) {
+    size_t solid = 0;
+    for (size_t i = 0; i<offset && i<length; i++) {
+        if (exp[i] != ' ') { solid++; }
+    }
+    return solid;
+}
+
+/* Returns the offset of the character that has solid characters that are not
+ spaces before it, or length if there is none
+ */
+static size_t spaced_offset(const char *exp, size_t length, size_t solid) {
+    for (size_t i = 0; i<length; i++) {
+        if (exp[i] == ' ') { continue; }
+        if (solid == 0) { return i; }
+        solid--;
+    }
+    return length;
+}
+
+/* Evaluates the first length characters of exp through the cache, throwing the
+ exception of the error found, if any
+ */
+template <class T>
+T basic_calculator<T>::cached_evaluate(const char *exp, size_t length, evaluator_context &ctx) {
+    T result;
+    diagnostic error;
+    if (!try_cached_evaluate(exp, length, ctx, result, error)) { raise(error, exp, length); }
+    return result;
+}
+
+/* Looks the normalized expression up in the cache. On a miss, evaluates it
+ and caches either its result or its error. The same key is shared by every
+ spacing of an expression, so the offset of an error is cached as a count of
+ the characters before it that are not spaces.
+ */
+template <class T>
+bool basic_calculator<T>::try_cached_evaluate(const char *exp, size_t length, evaluator_context &ctx, T &result, diagnostic &error) {
+    if (!cache) { return try_evaluate(exp, length, ctx, result, error); }
+    
+    result_cache<T>::normalize(exp, length, ctx.key);
+    
+    if (cache->lookup(ctx.key, result, error)) {
+        if (error.kind == ERROR_NONE) { return true; }
+        error.offset = spaced_offset(exp, length, error.offset);
+        return false;
+    }
+    
+    if (try_evaluate(exp, length, ctx, result, error)) {
+        diagnostic none = { ERROR_NONE, 0, NULL };
+        cache->insert(ctx.key, result, none);
+        return true;
+    }
+    
+    diagnostic cached = error;
+    cached.offset = solid_offset(exp, length, error.offset);
+    cache->insert(ctx.key, 0, cached);
+    return false;
+}
+
+/* Replaces the result cache with a new one of the given capacity */
+template <class T>
+void basic_calculator<T>::enable_cache(size_t capacity) {
+    if (capacity == 0) { cache.reset(); }
+    else { cache.reset(new result_cache<T>(capacity)); }
+}
+
+/* Sets whether programs are optimized, and checked against the original */
+template <class T>
+void basic_calculator<T>::set_optimizer(optimize_mode mode) {
+    optimization = mode;
+}
+
+/* Sets the length from which expressions are evaluated as trees */
+template <class T>
+void basic_calculator<T>::set_tree_evaluation(size_t min_length) {
+    tree_length = min_length;
+}
+
+/* Returns the result cache, if any */
+template <class T>
+const result_cache<T> *basic_calculator<T>::get_cache() const {
+    return cache.get();
+}
+
+/* Reads the whole file onto the end of the calculator's text, then splits it
+ into lines the same way load does. Each line is compiled and merged into the
+ graph; lines that do not compile are invalid. Once the whole file is in the
+ graph, each node is evaluated once and the result of each line is read out of
+ its root node, in order.
+ */
+template <class T>
+void basic_calculator<T>::add_shared(string fName, ifstream &readf, ostream &err) throw(invalid_argument) {
+    
+    readf.open(fName.c_str());
+    
+    // Throw an exception if file is invalid and cannot open
+    if (readf.fail()){
+        throw invalid_argument(fName);
+    }
+    
+    // Read entire file
+    stringstream contents;
+    {
+        CALC_PROFILE_SCOPE(PROFILE_READ);
+        contents << readf.rdbuf();
+        readf.close();
+    }
+    
+    size_t begin = text.length();
+    size_t base = (input ? input->size() : 0) + begin;
+    text += contents.str();
+    const char *buf = text.data() + begin;
+    size_t length = text.length() - begin;
+    CALC_PROFILE_READ(length);
+    
+    if (!dag) { dag.reset(new shared_dag<T>()); }
+    
+    // Root node of each line, or -1 if it does not compile
+    vector<evaluated_expression> lines;
+    vector<int> roots;
+    size_t first_invalid = invalid.size();
+    
+    size_t pos = 0;
+    while (pos <= length) {
+        const char *newline = (const char *)memchr(buf + pos, '\n', length - pos);
+        size_t stop = newline ? newline - buf : length;
+        
+        evaluated_expression ee;
+        ee.offset = base + pos;
+        ee.length = stop - pos;
+        diagnostic error;
+        if (compile_checked(buf + pos, ee.length, scratch.program, scratch.operators, scratch.names, error)
+            && scratch.names.empty()) {
+            roots.push_back(dag->add(scratch.program));
+        }
+        else {
+            roots.push_back(-1);
+        }
+        lines.push_back(ee);
+        pos = stop + 1;
+    }
+    
+    dag->evaluate();
+    
+    for (size_t i = 0; i<lines.size(); i++) {
+        if (roots[i] >= 0 && !dag->failed(roots[i])) {
+            lines[i].result = dag->value(roots[i]);
+            lines[i].hash = expression_store<T>::hash(buf + lines[i].offset - base, lines[i].length);
+            append(lines[i]);
+        }
+        else {
+            // Failed to evaluate result, evaluate it alone to find the error
+            // and add it to the table of invalid lines instead
+            T unused;
+            diagnostic error;
+            try_evaluate(buf + lines[i].offset - base, lines[i].length, scratch, unused, error);
+            CALC_PROFILE_ERROR(error.kind);
+            
+            invalid_expression ie;
+            ie.offset = lines[i].offset;
+            ie.length = lines[i].length;
+            ie.line = (uint32_t)i;
+            ie.column = (uint32_t)error.offset;
+            ie.kind = error.kind;
+            invalid.push_back(ie);
+        }
+    }
+    
+    dag->clear();
+    write_invalid(err, first_invalid);
+}
+
+/* Returns the graph of add_shared, if any */
+template <class T>
+const shared_dag<T> *basic_calculator<T>::get_dag() const {
+    return dag.get();
+}
+
+/* Writes the header, then the results and the offsets of the expressions a
+ block at a time, then the text of each expression. The header is written
+ again at the end, once the size of the text is known.
+ */
+template <class T>
+void basic_calculator<T>::save(string fName) const throw(invalid_argument) {
+    CALC_PROFILE_SCOPE(PROFILE_OUTPUT);
+    ofstream out(fName.c_str(), ios::binary | ios::trunc);
+    if (out.fail()) { throw invalid_argument(fName); }
+    
+    const size_t count = all_expressions.size();
+    const size_t block = 4096;
+    
+    result_file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "CALCRES", 8);
+    h.byte_order = 0x01020304;
+    h.value_size = sizeof(T);
+    h.count = count;
+    h.results = sizeof(h);
+    h.offsets = (h.results + count * sizeof(T) + 7) / 8 * 8;
+    h.strings = h.offsets + (count + 1) * sizeof(uint64_t);
+    out.write((const char *)&h, sizeof(h));
+    
+    // Values are copied into zeroed memory so that padding, e.g. of long
+    // double, is written as zeros
+    vector<char> buffer(block * sizeof(T));
+    for (size_t i = 0; i<count; i += block) {
+        size_t n = min(block, count - i);
+        memset(&buffer[0], 0, n * sizeof(T));
+        for (size_t j = 0; j<n; j++) {
+            T result = all_expressions.result(i+j);
+            memcpy(&buffer[j * sizeof(T)], &result, sizeof(T));
+        }
+        out.write(&buffer[0], n * sizeof(T));
+    }
+    const char padding[8] = { 0 };
+    out.write(padding, h.offsets - (h.results + count * sizeof(T)));
+    
+    vector<uint64_t> offsets;
+    offsets.reserve(block + 1);
+    uint64_t offset = 0;
+    for (size_t i = 0; i<=count; i += block) {
+        offsets.clear();
+        for (size_t j = i; j<=count && j < i + block; j++) {
+            offsets.push_back(offset);
+            if (j < count) { offset += all_expressions.length(j); }
+        }
+        out.write((const char *)&offsets[0], offsets.size() * sizeof(uint64_t));
+    }
+    
+    for (size_t i = 0; i<count; i++) {
+        out.write(expression_text(all_expressions.offset(i)), all_expressions.length(i));
+    }
+    
+    h.strings_size = offset;
+    out.seekp(0);
+    out.write((const char *)&h, sizeof(h));
+    out.close();
+    if (out.fail()) { throw invalid_argument(fName); }
+    CALC_PROFILE_WRITTEN(h.strings + h.strings_size);
+}
+
+/* Returns the sheet of cells, making it if there is none */
+template <class T>
+cell_sheet<T> &basic_calculator<T>::cells() {
+    if (!sheet) { sheet.reset(new cell_sheet<T>()); }
+    return *sheet;
+}
+
+/* The mapped input file, if any, followed by the calculator's own text */
+template <class T>
+text_space basic_calculator<T>::space() const {
+    text_space s;
+    s.mapped = input ? input->data() : NULL;
+    s.mapped_size = input ? input->size() : 0;
+    s.own = text.data();
+    return s;
+}
+
+/* Returns pointer to the text at offset, either in the mapped input file or in
+ the calculator's own text.
+ */
+template <class T>
+const char *basic_calculator<T>::expression_text(size_t offset) const {
+    return space().at(offset);
+}
+
+/* Interns the text where it already is in the calculator's text */
+template <class T>
+void basic_calculator<T>::append(const evaluated_expression &ee) {
+    const char *exp = expression_text(ee.offset);
+    all_expressions.push_back(all_expressions.intern(exp, ee.length, ee.hash, ee.offset, space()), ee.result);
+}
+
+/* Looks the text up before copying it, so a repeated expression takes no more
+ text
+ */
+template <class T>
+uint32_t basic_calculator<T>::intern_copy(const char *exp, size_t length) {
+    uint32_t hash = expression_store<T>::hash(exp, length);
+    uint32_t id;
+    if (all_expressions.find(exp, length, hash, space(), id)) { return id; }
+    
+    size_t offset = (input ? input->size() : 0) + text.length();
+    text.append(exp, length);
+    return all_expressions.intern(exp, length, hash, offset, space());
+}
+
+/* Returns the number of invalid lines */
+template <class T>
+size_t basic_calculator<T>::invalid_size() const {
+    return invalid.size();
+}
+
+/* Returns the invalid line at id */
+template <class T>
+const typename basic_calculator<T>::invalid_expression &basic_calculator<T>::get_invalid(int id) const {
+    return invalid[id];
+}
+
+/* Returns the text of the invalid line at id */
+template <class T>
+string basic_calculator<T>::get_invalid_expression(int id) const {
+    return string(expression_text(invalid[id].offset), invalid[id].length);
 }
 
 /* Returns infix expression at exp_id */
-string calculator::get_expression(int exp_id) const{
-    return all_expressions[exp_id].exp;
+template <class T>
+string basic_calculator<T>::get_expression(int exp_id) const{
+    return string(expression_text(all_expressions.offset(exp_id)), all_expressions.length(exp_id));
 }
 
 /* Returns result of infix expression a exp_id */
-float calculator::get_result(int exp_id) const {
-    return all_expressions[exp_id].result;
+template <class T>
+T basic_calculator<T>::get_result(int exp_id) const {
+    return all_expressions.result(exp_id);
+}
+
+/* Returns the number of stored expressions */
+template <class T>
+size_t basic_calculator<T>::size() const {
+    return all_expressions.size();
+}
+
+/* Returns the array of results */
+template <class T>
+const T *basic_calculator<T>::get_results() const {
+    return all_expressions.result_data();
+}
+
+/* Returns the number of distinct texts */
+template <class T>
+size_t basic_calculator<T>::distinct_size() const {
+    return all_expressions.distinct();
 }
 
 /* Adds a given to the all_expressions vector as the last element of the vector.
@@ -71,18 +637,141 @@ float calculator::get_result(int exp_id) const {
  both expression and result in vector. If fails and expression is invalid,
  prints only expression to error stream and all_expressions is unchanged.
  */
-void calculator::add_new(string exp, ostream &err) {
-    evaluated_expression ee;
+template <class T>
+void basic_calculator<T>::add_new(string exp, ostream &err) {
+    T result = evaluate_new(exp);
+    
+    all_expressions.push_back(intern_copy(exp.data(), exp.length()), result);
+}
+
+/* Evaluates the new expression, then replaces the one at exp_id with it. If
+ the new expression is invalid, the exception is passed on and the old one is
+ kept.
+ */
+template <class T>
+void basic_calculator<T>::update(int exp_id, string exp, ostream &err) {
+    if (exp_id < 0 || (size_t)exp_id >= all_expressions.size()) {
+        throw out_of_range("No expression at this position");
+    }
+    
+    T result = evaluate_new(exp);
+    store(exp_id, exp.data(), exp.length(), result);
+}
+
+// Most compiled programs add_new and update keep when there is no cache
+static const size_t PROGRAM_CAPACITY = 256;
+
+// Runs of the same expression by add_new and update before it is translated
+// into machine code
+static const unsigned long HOT_THRESHOLD = 100;
+
+/* Evaluates an expression for add_new or update. Without a cache, the
+ programs of recent expressions are kept, and the one run least recently is
+ dropped to make room for a new one, so an interactive session or an
+ expression edited many times keeps at most PROGRAM_CAPACITY of them. Each is
+ run as a hot expression, so an expression evaluated HOT_THRESHOLD times runs
+ as machine code from then on, if values are doubles.
+ */
+template <class T>
+T basic_calculator<T>::evaluate_new(const string &exp) {
+    if (cache) {
+        // Look result up, evaluating only expressions not seen recently
+        return cached_evaluate(exp.data(), exp.length(), scratch);
+    }
+    else if (optimization == OPTIMIZE_VERIFY) {
+        // Run both programs each time to compare them
+        return evaluate(exp.data(), exp.length(), scratch);
+    }
+    
+    // Compile expression the first time it is seen, else reuse its program
+    typename map<string, program_entry>::iterator it = programs.entries.find(exp);
+    if (it == programs.entries.end()) {
+        compiled_expression prog = compile(exp);
+        if (optimization == OPTIMIZE_ON) { prog = optimize(prog); }
+        
+        // Make room by dropping the program run least recently
+        if (programs.entries.size() >= PROGRAM_CAPACITY) {
+            typename map<string, program_entry>::iterator oldest = programs.entries.begin();
+            for (typename map<string, program_entry>::iterator p = programs.entries.begin(); p != programs.entries.end(); ++p) {
+                if (p->second.used < oldest->second.used) { oldest = p; }
+            }
+            programs.entries.erase(oldest);
+        }
+        
+        program_entry entry;
+        entry.used = 0;
+        entry.hot.reset(new hot_expression<T>(*this, prog, HOT_THRESHOLD));
+        it = programs.entries.insert(make_pair(exp, entry)).first;
+    }
+    
+    it->second.used = ++programs.clock;
+    hot_expression<T> &hot = *it->second.hot;
+    if (!hot.variables().empty()) {
+        throw invalid_argument("Unbound variable " + hot.variables()[0]);
+    }
+    return hot.evaluate(NULL);
+}
+
+/* Points the expression at exp_id to its text, copied after all other text
+ unless an expression already has the same. If the text replaced is dropped
+ and was the calculator's own, a new text appended right after it is moved
+ down over it, and one at the end is cut off; anything else is left as it is
+ until half the text is dead, when the text is compacted.
+ */
+template <class T>
+void basic_calculator<T>::store(int exp_id, const char *exp, size_t length, T result) {
+    size_t base = input ? input->size() : 0;
+    size_t old_offset = all_expressions.offset(exp_id);
+    size_t old_length = all_expressions.length(exp_id);
+    
+    uint32_t id = intern_copy(exp, length);
+    if (!all_expressions.set(exp_id, id, result) || old_offset < base) { return; }
+    
+    size_t offset = all_expressions.offset(exp_id);
+    if (offset == old_offset + old_length && offset - base + length == text.length()) {
+        text.erase(old_offset - base, old_length);
+        all_expressions.move_text(id, old_offset);
+    }
+    else if (old_offset - base + old_length == text.length()) {
+        text.resize(old_offset - base);
+    }
+    else {
+        dead_text += old_length;
+        if (dead_text * 2 > text.length()) { compact_text(); }
+    }
+}
+
+/* Copies the ranges in use in the order of their ids, then of the invalid
+ lines. Ranges of the input file are left where they are.
+ */
+template <class T>
+void basic_calculator<T>::compact_text() {
+    size_t base = input ? input->size() : 0;
+    string packed;
+    packed.reserve(text.length() - dead_text);
+    
+    for (uint32_t id = 0; id<all_expressions.text_ids(); id++) {
+        size_t offset = all_expressions.text_offset(id);
+        if (offset == expression_store<T>::NO_TEXT || offset < base) { continue; }
+        all_expressions.move_text(id, base + packed.length());
+        packed.append(text, offset - base, all_expressions.text_length(id));
+    }
+    for (size_t i = 0; i<invalid.size(); i++) {
+        if (invalid[i].offset < base) { continue; }
+        size_t offset = invalid[i].offset;
+        invalid[i].offset = base + packed.length();
+        packed.append(text, offset - base, invalid[i].length);
+    }
     
-    ee.exp = exp;
-    ee.result = evaluate(ee.exp);
-    all_expressions.push_back(ee);
+    text.swap(packed);
+    dead_text = 0;
 }
 
 /* Compares character to list of known operators, returns true if ch == operator
  else returns false .
  */
-bool calculator::is_operator(char ch) {
+template <class T>
+bool basic_calculator<T>::is_operator(char ch) {
     
     if (ch == '+' || ch == '-' || ch == '/' || ch == '*' || ch == '^') {
         return true;
@@ -96,7 +785,8 @@ bool calculator::is_operator(char ch) {
 /* Returns assigned precedence value of a given operator character. Throws
  exception if character is not a known operator.
  */
-int calculator::precedence(char op) throw(invalid_argument){
+template <class T>
+int basic_calculator<T>::precedence(char op) throw(invalid_argument){
     
     if (op == '(') {
         return 0;
@@ -119,9 +809,10 @@ int calculator::precedence(char op) throw(invalid_argument){
  that order) and the top value off the operator stack o as op and return the
  result of the operation operand1 op operand2.
  */
-float calculator::execute(stack<float> &v, stack<char> &o) throw(underflow_error, invalid_argument) {
+template <class T>
+T basic_calculator<T>::execute(stack<T> &v, stack<char> &o) throw(underflow_error, invalid_argument) {
     
-    float operand1, operand2;
+    T operand1, operand2;
     char op;
     
     // If no operand to pop, throw exception
@@ -141,6 +832,16 @@ float calculator::execute(stack<float> &v, stack<char> &o) throw(underflow_error
     }
     
     // Perform the operation operand1 op operand2
+    return execute(op, operand1, operand2);
+    
+}
+
+/* Returns the result of the operation operand1 op operand2. Throws exception
+ on division by zero or if op is not a known operator.
+ */
+template <class T>
+T basic_calculator<T>::execute(char op, T operand1, T operand2) throw(invalid_argument) {
+    
     switch (op) {
         case '+':
             return operand1 + operand2;
@@ -163,228 +864,666 @@ float calculator::execute(stack<float> &v, stack<char> &o) throw(underflow_error
     
 }
 
+/* Returns the result of a single operand operator. A square and sqrt are
+ correctly rounded, while pow may be one unit in the last place off, so they
+ may differ from x^2 and x^0.5 in the last bit. Negative operands of a
+ square root are left to pow, which treats -0 and -inf differently from sqrt.
+ */
+template <class T>
+T basic_calculator<T>::execute(char op, T operand) throw(invalid_argument) {
+    
+    switch (op) {
+        case SQR:
+            return operand * operand;
+        case SQRT:
+            if (signbit(operand)) { return pow(operand, T(0.5)); }
+            return sqrt(operand);
+        default:
+            // invalid operator, throw exception
+            throw invalid_argument("Operator character expected");
+    }
+    
+}
+
+/* Sets the kind, offset and message of an error and returns false, so a
+ function that finds one can return it in a single statement
+ */
+static bool fail(diagnostic &error, error_kind kind, size_t offset, const char *message) {
+    error.kind = kind;
+    error.offset = offset;
+    error.message = message;
+    return false;
+}
+
+/* Pops the top operator off the operator stack o and appends it to the
+ program. Mirrors the checks execute makes on its stacks: the number of values
+ on the stack at run time only depends on the order of the instructions, so
+ depth tracks it exactly and operand underflow is caught here, at compile time.
+ The operator is left on the stack when it is in error, and reported where it
+ is in exp.
+ */
+template <class T>
+bool basic_calculator<T>::emit_operator(compiled_expression &prog, vector<int> &o, int &depth, const char *exp, diagnostic &error) {
+    
+    // Unmatched left parenthesis left on the stack
+    char op = exp[o.back()];
+    if (!is_operator(op)) {
+        return fail(error, ERROR_PARENTHESIS, o.back(), "Operator character expected");
+    }
+    
+    // If fewer than two operands, operator underflows
+    if (depth < 2) {
+        return fail(error, ERROR_OPERAND_UNDERFLOW, o.back(), "Trying to pop an empty stack");
+    }
+    
+    instruction ins;
+    ins.op = opcode(op);
+    ins.arg = o.back();
+    prog.code.push_back(ins);
+    o.pop_back();
+    
+    // Two operands are replaced by the result
+    depth--;
+    return true;
+}
+
 /* Takes an infix expression as a string exp, checks it for validity (e.g.
- checks for matching parentheses, correct number of operands vs. operators,
- division by zero errors) and returns the result of its evaluation. Does this
- using two stacks: one for operand values and one for operators. Reads each
- character of the string and determines whether it is a decimal value (or part
- of one), a parenthesis or an operator '+', '-', '*', '/', '^'.
-    If a set of characters is a float number containing only digits and no more
- than one decimal point, it is pushed to the value stack.
-    If a character is an operator, it is pushed to the operator stack if and
- only if the character already on the top of the operator stack is of lesser
- precedence. If the character on the top of the stack is of higher precedence,
- an operation is "executed", i.e. performed with this character on the top of
- the operator stack and the top two values of the value stack and all three
- elements are popped off their respective stacks.
-    If a character is a right parenthesis, it is popped onto the operator stack.
- If a character is a left parenthesis, operations are executed until the top of
- the operator stack contains a rigth parenthesis, in which case it is popped and
- we continue reading the rest of the string.
-    Once the string is read, executions are performed until the operator stack 
- is empty and the value stack contains only a single value. This value is what
- is returned by the function.
- */
-float calculator::evaluate(string exp, ostream &err){
-    // Use two stacks: one for valid operators, one for valid float values
-    stack<char> opStack;
-    stack<float> valStack;
+ checks for matching parentheses, correct number of operands vs. operators)
+ and translates it to postfix bytecode. Uses the same algorithm evaluate always
+ has, with a stack for operators, but instead of executing an operation when
+ an operator is popped, the operator is appended to the program.
+    If a set of characters is a T number containing only digits, no more
+ than one decimal point and an optional exponent, it is added to the constant
+ pool and an instruction to push it is appended to the program.
+    If a character is an operator, operators of greater or equal precedence on
+ the top of the operator stack are appended to the program, then the operator
+ is pushed to the stack.
+    If a character is a left parenthesis, it is pushed onto the operator stack.
+ If a character is a right parenthesis, operators are appended until the top of
+ the operator stack contains the matching left parenthesis, which is popped.
+    Once the string is read, the remaining operators are appended and the
+ program must leave exactly one value on the stack.
+ */
+template <class T>
+typename basic_calculator<T>::compiled_expression basic_calculator<T>::compile(string exp){
+    return compile(exp.data(), exp.length());
+}
+
+/* Compiles the first length characters of exp. Never reads past them, so exp
+ can be a line in the middle of a larger buffer.
+ */
+template <class T>
+typename basic_calculator<T>::compiled_expression basic_calculator<T>::compile(const char *exp, size_t length){
+    compiled_expression prog;
+    vector<int> opStack;
+    compile_into(exp, length, prog, opStack);
+    return prog;
+}
+
+/* Returns the number of letters, digits and underscores from i on */
+static size_t name_length(const char *exp, size_t i, size_t length) {
+    size_t j = 1;
+    while (i+j < length && (isalnum(exp[i+j]) || exp[i+j] == '_')) { j++; }
+    return j;
+}
+
+/* Compiles the first length characters of exp, throwing the exception of the
+ error found, if any
+ */
+template <class T>
+void basic_calculator<T>::compile_into(const char *exp, size_t length, compiled_expression &prog, vector<int> &opStack){
+    diagnostic error;
+    vector<int> names;
+    if (!compile_checked(exp, length, prog, opStack, names, error)) { raise(error, exp, length); }
+    
+    for (size_t k = 0; k<names.size(); k++) {
+        prog.variables.push_back(string(exp + names[k], name_length(exp, names[k], length)));
+    }
+}
+
+/* Compiles the first length characters of exp into prog, using opStack as the
+ operator stack. Both are cleared first but keep their capacity, so compiling
+ into the same ones again allocates nothing once they are big enough. The
+ operator stack holds where each operator is in exp rather than the operator
+ itself, so an error can be reported at the operator that caused it, and
+ variables are kept as where each is first used, so no name is copied.
+ */
+template <class T>
+bool basic_calculator<T>::compile_checked(const char *exp, size_t length, compiled_expression &prog, vector<int> &opStack, vector<int> &names, diagnostic &error){
+    CALC_PROFILE_SCOPE(PROFILE_COMPILE);
+    prog.code.clear();
+    prog.constants.clear();
+    prog.variables.clear();
+    opStack.clear();
+    names.clear();
+    
+    // Number of values on the stack when the program reaches this point
+    int depth = 0;
+    prog.max_depth = 0;
+    
+    // Where the first variable is, to report it if it is left unbound
+    error.kind = ERROR_NONE;
+    error.offset = 0;
+    error.message = NULL;
     
     // For each character in exp
-    for (int i = 0; i<exp.length(); i++) {
+    for (size_t i = 0; i<length; i++) {
         
         // If char is an operand,
-        // Push digits and decimal point to value stack as a single float
+        // Add digits, decimal point and exponent to the program as a single
+        // value
         if (isdigit(exp[i])){
             
-            stringstream opss;
-            opss << exp[i];
+            // Read the whole number and convert it to a value
+            T operand;
+            size_t bad;
+            size_t j = scan_number(exp + i, length - i, operand, bad);
+            if (j == 0) {
+                return fail(error, ERROR_BAD_LITERAL, i + bad, "Too many decimal points");
+            }
+            
+            instruction ins;
+            ins.op = PUSH;
+            ins.arg = (int)prog.constants.size();
+            prog.constants.push_back(operand);
+            prog.code.push_back(ins);
             
-            int j = 1;
-            int count_decimal = 0;
+            depth++;
+            if (depth > prog.max_depth) { prog.max_depth = depth; }
             
-            // Check next characters to see if they are part of the single float
-            while (isdigit(exp[i+j]) || exp[i+j] == '.'){
-                opss << exp[i+j];
-                
-                // VALIDITY CHECK: make sure only one decimal point in float
-                if (exp[i+j] == '.') {
-                    count_decimal ++;
-                    if (count_decimal > 1) {
-                        throw invalid_argument("Too many decimal points");
-                    }
+            // Increment i so next iteration checks next character after number
+            i = i + j-1 ;
+        }
+        
+        // If char starts a variable name, read the whole name and append an
+        // instruction to load its value to the program
+        else if (isalpha(exp[i]) || exp[i] == '_') {
+            
+            size_t j = name_length(exp, i, length);
+            
+            // Variables used more than once share a single binding. A name
+            // used before is as long as this one and starts the same, which
+            // reads no further than this one ends.
+            int index = -1;
+            for (size_t k = 0; k<names.size() && index < 0; k++) {
+                if (name_length(exp, names[k], length) == j && memcmp(exp + names[k], exp + i, j) == 0) {
+                    index = (int)k;
                 }
-                
-                j++;
             }
-            
-            // Push valid float to stack
-            float operand;
-            opss >> operand;
-            try {
-                valStack.push(operand); }
-            catch (...) {
-                // If push to stack fails, exit with errors
-                err << "Unable to allocate memory" << endl;
-                exit(-1);
+            if (index < 0) {
+                if (names.empty()) { error.offset = i; }
+                index = (int)names.size();
+                names.push_back((int)i);
             }
             
-            // Increment i so next iteration checks next character after float
+            instruction ins;
+            ins.op = LOAD;
+            ins.arg = index;
+            prog.code.push_back(ins);
+            
+            depth++;
+            if (depth > prog.max_depth) { prog.max_depth = depth; }
+            
+            // Increment i so next iteration checks next character after name
             i = i + j-1 ;
         }
         
-        // If char is a right parenthesis, push to operator stack
+        // If char is a left parenthesis, push to operator stack
         else if (exp[i] == '(') {
-            try {
-                opStack.push(exp[i]);
-            }
-            catch (...) {
-                // If push to stack fails, exit with errors
-                err << "Unable to allocate memory" << endl;
-                exit(-1);
-            }
-
+            opStack.push_back((int)i);
+            CALC_PROFILE_DEPTH(PROFILE_OPERATOR_STACK, opStack.size());
         }
         
-        // If char is an operator (non-parentheses)
+        // If char is an operator (non-parentheses), emit operations with
+        // greater or equal precedence, then push operator onto stack
         else if (is_operator(exp[i])){
-            
-            // If operator stack is empty, push operator on top
-            if (opStack.empty()) {
-                
-                try {
-                    opStack.push(exp[i]);
-                }
-                catch (...) {
-                    // If push to stack fails, exit with errors
-                    err << "Unable to allocate memory" << endl;
-                    exit(-1);
-                }
-
-            }
-            
-            // If stack is non-empty, if operator has greater precedence
-            // than top of stack, push operator on top
-            else if (precedence(exp[i]) > precedence(opStack.top())){
-                
-                try {
-                    opStack.push(exp[i]);
-                }
-                catch (...) {
-                    // If push to stack fails, exit with errors
-                    err << "Unable to allocate memory" << endl;
-                    exit(-1);
-                }
-
-            }
-            
-            // If operator has lower precedence, perform operations with higher
-            // precedence until operator has highest precedence
-            else {
-                while (!opStack.empty() && precedence(exp[i]) <= precedence(opStack.top())){
-                    float result = execute(valStack, opStack);
-                    
-                    try {
-                        valStack.push(result);
-                    }
-                    catch (...) {
-                        // If push to stack fails, exit with errors
-                        err << "Unable to allocate memory" << endl;
-                        exit(-1);
-                    }
-                }
-                
-                // Push operator onto stack
-                try {
-                    opStack.push(exp[i]);
-                }
-                catch (...) {
-                    // If push to stack fails, exit with errors
-                    err << "Unable to allocate memory" << endl;
-                    exit(-1);
-                }
-
+            while (!opStack.empty() && precedence(exp[i]) <= precedence(exp[opStack.back()])){
+                if (!emit_operator(prog, opStack, depth, exp, error)) { return false; }
             }
+            opStack.push_back((int)i);
+            CALC_PROFILE_DEPTH(PROFILE_OPERATOR_STACK, opStack.size());
         }
         
-        // If char is a left parenthesis, perform operation with top two values
-        // in value stack and top operator in operator stack, pop those off
-        // stacks and push result back to value stack.
-        // Do this until matching right parenthesis is reached.
-        
+        // If char is a right parenthesis, emit operations until matching left
+        // parenthesis is reached.
         else if (exp[i] == ')'){
-            while (!opStack.empty() && opStack.top()!= '('){
-                float result = execute(valStack, opStack);
-                try {
-                    valStack.push(result);
-                }
-                catch (...) {
-                    // If push to stack fails, exit with errors
-                    err << "Unable to allocate memory" << endl;
-                    exit(-1);
-                }
+            while (!opStack.empty() && exp[opStack.back()]!= '('){
+                if (!emit_operator(prog, opStack, depth, exp, error)) { return false; }
             }
-            // If end of stack reached and no matching right parenthesis is
+            // If end of stack reached and no matching left parenthesis is
             // found, expression is invalid.
-            if (opStack.empty()) { throw invalid_argument("No matching parenthesis"); }
+            if (opStack.empty()) {
+                return fail(error, ERROR_PARENTHESIS, i, "No matching parenthesis");
+            }
             else {
-                // Top of opStack is a right parenthesis
-                // Pop right parenthesis off stack
-                opStack.pop();
+                // Pop left parenthesis off stack
+                opStack.pop_back();
             }
         }
         
         // White space is a valid character, but does nothing
         else if (exp[i] == ' ') { }
         
-        // Invalid character, i.e. nonoperand and nonoperator, throw exception
+        // Invalid character, i.e. nonoperand and nonoperator
         else {
-            throw invalid_argument("Invalid character");
+            return fail(error, ERROR_INVALID_CHARACTER, i, "Invalid character");
         }
         
     }
     
-    // Finished reading entire exp string
-    // Pop operator and top two operands off stacks and perform operands
-    // Push result back onto value stack
-    // Do this until we have no more operators to use
+    // Finished reading entire exp string, emit remaining operators
     while (!opStack.empty()){
-        float result = execute(valStack, opStack);
-        try {
-            valStack.push(result);
+        if (!emit_operator(prog, opStack, depth, exp, error)) { return false; }
+    }
+    
+    // Program must leave a single value on the stack, its result
+    if (depth != 1) {
+        return fail(error, ERROR_OPERAND_COUNT, length, "Invalid number of operands");
+    }
+    return true;
+}
+
+/* Returns the index of a variable in the program's list of variables, or -1 if
+ the program does not use it.
+ */
+template <class T>
+int basic_calculator<T>::variable_index(const compiled_expression &prog, string name) const {
+    for (size_t i = 0; i<prog.variables.size(); i++) {
+        if (prog.variables[i] == name) { return (int)i; }
+    }
+    return -1;
+}
+
+/* Executes a compiled program that does not use any variables. */
+template <class T>
+T basic_calculator<T>::run(const compiled_expression &prog) throw(invalid_argument) {
+    if (!prog.variables.empty()) {
+        throw invalid_argument("Unbound variable " + prog.variables[0]);
+    }
+    return run(prog, (const T *)NULL);
+}
+
+/* Executes a compiled program with its variables bound to the values in vars.
+ */
+template <class T>
+T basic_calculator<T>::run(const compiled_expression &prog, const vector<T> &vars) throw(invalid_argument) {
+    if (vars.size() < prog.variables.size()) {
+        throw invalid_argument("Unbound variable " + prog.variables[vars.size()]);
+    }
+    return run(prog, vars.empty() ? (const T *)NULL : &vars[0]);
+}
+
+/* Executes a compiled program using a single value stack. Constants and values
+ of variables are pushed onto the stack and operators replace the top two
+ values with the result of execute. The last value left on the stack is the
+ result. Programs that fit use a stack on the call stack so nothing has to be
+ allocated.
+ */
+template <class T>
+T basic_calculator<T>::run(const compiled_expression &prog, const T *vars) throw(invalid_argument) {
+    T local[64];
+    vector<T> heap;
+    T *valStack = local;
+    if (prog.max_depth > 64) {
+        heap.resize(prog.max_depth);
+        valStack = &heap[0];
+    }
+    return run_on(prog, vars, valStack);
+}
+
+/* Executes a compiled program on a given value stack, throwing if it divides
+ by zero
+ */
+template <class T>
+T basic_calculator<T>::run_on(const compiled_expression &prog, const T *vars, T *valStack) throw(invalid_argument) {
+    T result;
+    size_t failed;
+    if (!run_checked(prog, vars, valStack, result, failed)) {
+        throw invalid_argument("Attempt to divide by zero");
+    }
+    return result;
+}
+
+/* Executes a compiled program on a given value stack of at least
+ prog.max_depth elements. Division by zero is the only error a compiled
+ program can have, so it is checked for before execute would throw.
+ */
+template <class T>
+bool basic_calculator<T>::run_checked(const compiled_expression &prog, const T *vars, T *valStack, T &result, size_t &failed) {
+    CALC_PROFILE_SCOPE(PROFILE_EXECUTE);
+    CALC_PROFILE_DEPTH(PROFILE_VALUE_STACK, prog.max_depth);
+    int top = 0;
+    
+    for (size_t i = 0; i<prog.code.size(); i++) {
+        const instruction &ins = prog.code[i];
+        CALC_PROFILE_OP(ins.op);
+        
+        if (ins.op == PUSH) {
+            valStack[top++] = prog.constants[ins.arg];
         }
-        catch (...) {
-            // If push to stack fails, exit with errors
-            err << "Unable to allocate memory" << endl;
-            exit(-1);
+        else if (ins.op == LOAD) {
+            valStack[top++] = vars[ins.arg];
+        }
+        else if (ins.op == SQR || ins.op == SQRT) {
+            valStack[top-1] = execute(ins.op, valStack[top-1]);
+        }
+        else {
+            top--;
+            if (ins.op == DIV && valStack[top] == 0) {
+                failed = i;
+                return false;
+            }
+            valStack[top-1] = execute(ins.op, valStack[top-1], valStack[top]);
         }
     }
     
-    // Top of the value stack is the result of all executions
-    // Check to see if it's the last value in the stack, else throw exception
-    float final_result;
-    if (valStack.size()!=1) { throw invalid_argument("Invalid number of operands"); }
-    else {
-        final_result = valStack.top();
-        valStack.pop(); // Stack is now empty
+    result = valStack[0];
+    return true;
+}
+
+/* Executes a compiled program over columns of variable values. Rows are done
+ in blocks small enough to stay in cache. Each stack slot is a column of a
+ block: variables point straight into the input columns, constants are filled
+ into a scratch column and operators write their result into the scratch
+ column of the slot they leave their result in.
+ */
+template <class T>
+void basic_calculator<T>::run_batch(const compiled_expression &prog, const vector<const T *> &columns, size_t rows, T *results, unsigned char *errors) throw(invalid_argument) {
+    if (columns.size() < prog.variables.size()) {
+        throw invalid_argument("Unbound variable " + prog.variables[columns.size()]);
     }
     
-    // Everything looks good, return final result.
-    return final_result;
+    CALC_PROFILE_SCOPE(PROFILE_EXECUTE);
+    CALC_PROFILE_DEPTH(PROFILE_VALUE_STACK, prog.max_depth);
+    
+    const size_t block = 1024;
+    vector<T> scratch(prog.max_depth * block);
+    vector<const T *> slots(prog.max_depth);
+    
+    memset(errors, 0, rows);
     
+    for (size_t start = 0; start<rows; start += block) {
+        size_t n = (rows - start < block) ? rows - start : block;
+        int top = 0;
+        
+        for (size_t i = 0; i<prog.code.size(); i++) {
+            const instruction &ins = prog.code[i];
+            CALC_PROFILE_OPS(ins.op, n);
+            
+            if (ins.op == PUSH) {
+                T *column = &scratch[top * block];
+                column_fill(prog.constants[ins.arg], column, n);
+                slots[top++] = column;
+            }
+            else if (ins.op == LOAD) {
+                slots[top++] = columns[ins.arg] + start;
+            }
+            else if (ins.op == SQR || ins.op == SQRT) {
+                const T *a = slots[top-1];
+                T *out = &scratch[(top-1) * block];
+                
+                if (ins.op == SQR) { column_mul(a, a, out, n); }
+                else { column_sqrt(a, out, n); }
+                slots[top-1] = out;
+            }
+            else {
+                top--;
+                const T *a = slots[top-1];
+                const T *b = slots[top];
+                T *out = &scratch[(top-1) * block];
+                
+                switch (ins.op) {
+                    case ADD: column_add(a, b, out, n); break;
+                    case SUB: column_sub(a, b, out, n); break;
+                    case MUL: column_mul(a, b, out, n); break;
+                    case DIV: column_div(a, b, out, errors + start, n); break;
+                    case POW: column_pow(a, b, out, n); break;
+                    default: throw invalid_argument("Operator character expected");
+                }
+                slots[top-1] = out;
+            }
+        }
+        
+        memcpy(results + start, slots[0], n * sizeof(T));
+    }
 }
 
+/* Takes an infix expression as a string exp, checks it for validity (e.g.
+ checks for matching parentheses, correct number of operands vs. operators,
+ division by zero errors) and returns the result of its evaluation. The
+ expression is compiled to postfix bytecode, which is then run.
+ */
+template <class T>
+T basic_calculator<T>::evaluate(string exp, ostream &err){
+    return run(compile(exp));
+}
 
-/* Friend function to the class that displays all expressions and their results
- in a formatted, user-friendly manner to the console by manipulating the output
- stream. No expressions and their results are changed.
+/* Evaluates the first length characters of exp */
+template <class T>
+T basic_calculator<T>::evaluate(const char *exp, size_t length){
+    return run(compile(exp, length));
+}
+
+/* Evaluates the first length characters of exp, throwing the exception of the
+ error found, if any
+ */
+template <class T>
+T basic_calculator<T>::evaluate(const char *exp, size_t length, evaluator_context &ctx){
+    T result;
+    diagnostic error;
+    if (!try_evaluate(exp, length, ctx, result, error)) { raise(error, exp, length); }
+    return result;
+}
+
+/* Evaluates the first length characters of exp, as a tree of parts if it is
+ long enough to be worth it, else on the context's stack
  */
+template <class T>
+bool basic_calculator<T>::try_evaluate(const char *exp, size_t length, evaluator_context &ctx, T &result, diagnostic &error){
+    if (tree_length != 0 && length >= tree_length) {
+        tree_evaluator<T> tree(*this);
+        return tree.evaluate(exp, length, ctx.pool, result, error);
+    }
+    return try_evaluate_stack(exp, length, ctx, result, error);
+}
 
-ostream &operator << (ostream &os, const calculator &c){
+/* Evaluates the first length characters of exp, compiling it into the
+ context's program with the context's operator stack and running it on the
+ context's value stack. Records whether any of them had to grow.
+ */
+template <class T>
+bool basic_calculator<T>::try_evaluate_stack(const char *exp, size_t length, evaluator_context &ctx, T &result, diagnostic &error){
+    if (!compile_checked(exp, length, ctx.program, ctx.operators, ctx.names, error)) {
+        ctx.track();
+        return false;
+    }
+    
+    if (!ctx.names.empty()) {
+        ctx.track();
+        return fail(error, ERROR_UNBOUND_VARIABLE, error.offset, "Unbound variable");
+    }
+    if (ctx.values.size() < (size_t)ctx.program.max_depth) {
+        ctx.values.resize(ctx.program.max_depth);
+    }
+    ctx.track();
     
-    for (int i=0; i<c.all_expressions.size(); i++) {
-        os << fixed << setprecision(2)  << c.get_result(i) << " = " << c.get_expression(i) << endl;
+    size_t failed;
+    if (optimization == OPTIMIZE_OFF) {
+        if (run_checked(ctx.program, NULL, &ctx.values[0], result, failed)) { return true; }
+        return fail(error, ERROR_DIVIDE_BY_ZERO, ctx.program.code[failed].arg, "Attempt to divide by zero");
     }
     
+    // Optimized program never needs a deeper stack than the original. When
+    // verifying, constants are not folded, or a line without variables would
+    // fold to the value the original computes and never test a rewrite.
+    if (!ctx.optimizer) { ctx.optimizer.reset(new expression_optimizer<T>()); }
+    ctx.optimizer->set_folding(optimization == OPTIMIZE_ON);
+    {
+        CALC_PROFILE_SCOPE(PROFILE_OPTIMIZE);
+        ctx.optimizer->optimize(ctx.program, ctx.optimized);
+    }
+    
+    if (optimization == OPTIMIZE_ON) {
+        if (run_checked(ctx.optimized, NULL, &ctx.values[0], result, failed)) { return true; }
+        size_t at = division_offset(ctx.program, &ctx.values[0], length);
+        return fail(error, ERROR_DIVIDE_BY_ZERO, at, "Attempt to divide by zero");
+    }
+    return run_verified(ctx.program, ctx.optimized, NULL, &ctx.values[0], result, error);
+}
+
+/* Runs a program and its optimized version on the same stack, one after the
+ other. They agree if both fail, or if both give the same value with the same
+ sign, or both NaN; the error or result is then passed on. Otherwise they
+ disagree, which is an error of its own.
+ */
+template <class T>
+bool basic_calculator<T>::run_verified(const compiled_expression &prog, const compiled_expression &optimized, const T *vars, T *valStack, T &result, diagnostic &error) {
+    T expected = 0;
+    size_t at, unused;
+    bool failed = !run_checked(prog, vars, valStack, expected, at);
+    bool optimized_failed = !run_checked(optimized, vars, valStack, result, unused);
+    
+    if (optimized_failed) {
+        if (failed) {
+            return fail(error, ERROR_DIVIDE_BY_ZERO, prog.code[at].arg, "Attempt to divide by zero");
+        }
+        return fail(error, ERROR_OPTIMIZER_MISMATCH, 0, "Optimized program fails");
+    }
+    
+    if (failed) { return fail(error, ERROR_OPTIMIZER_MISMATCH, 0, "Optimized program does not fail"); }
+    
+    bool same = (result == expected && signbit(result) == signbit(expected))
+        || (result != result && expected != expected);
+    if (!same) { return fail(error, ERROR_OPTIMIZER_MISMATCH, 0, "Optimized result differs"); }
+    
+    return true;
+}
+
+/* The optimized program keeps no offsets, so the original one is run to find
+ the division
+ */
+template <class T>
+size_t basic_calculator<T>::division_offset(const compiled_expression &prog, T *valStack, size_t length) {
+    T unused;
+    size_t failed;
+    if (run_checked(prog, NULL, valStack, unused, failed)) { return length; }
+    return prog.code[failed].arg;
+}
+
+/* Throws what the throwing functions have always thrown for each error:
+ underflow_error for operand underflow, logic_error when the optimizer and the
+ original program disagree and invalid_argument for everything else.
+ */
+template <class T>
+void basic_calculator<T>::raise(const diagnostic &error, const char *exp, size_t length) throw(logic_error, underflow_error) {
+    switch (error.kind) {
+        case ERROR_OPERAND_UNDERFLOW: throw underflow_error(error.message);
+        case ERROR_OPTIMIZER_MISMATCH: throw logic_error(error.message);
+        default: throw invalid_argument(error_message(error, exp, length));
+    }
+}
+
+/* Returns the message of the error, followed by the name of the variable for
+ an unbound one, read from where it is in exp
+ */
+template <class T>
+string basic_calculator<T>::error_message(const diagnostic &error, const char *exp, size_t length) {
+    if (error.kind != ERROR_UNBOUND_VARIABLE) { return error.message; }
+    
+    size_t j = error.offset;
+    while (j < length && (isalnum(exp[j]) || exp[j] == '_')) { j++; }
+    return string(error.message) + " " + string(exp + error.offset, j - error.offset);
+}
+
+/* Returns an optimized copy of a program */
+template <class T>
+typename basic_calculator<T>::compiled_expression basic_calculator<T>::optimize(const compiled_expression &prog) {
+    CALC_PROFILE_SCOPE(PROFILE_OPTIMIZE);
+    expression_optimizer<T> optimizer;
+    compiled_expression out;
+    optimizer.optimize(prog, out);
+    return out;
+}
+
+
+/* Evaluator context constructor. Reserves room for expressions of up to
+ capacity characters, operators and values.
+ */
+template <class T>
+basic_calculator<T>::evaluator_context::evaluator_context(size_t capacity) : pool(NULL), growths(0), reserved(0) {
+    operators.reserve(capacity);
+    values.resize(capacity);
+    program.code.reserve(capacity);
+    program.constants.reserve(capacity);
+    program.max_depth = 0;
+    text.reserve(capacity);
+    key.reserve(capacity);
+    reserved = capacity_used();
+}
+
+/* Returns the total capacity of the context's buffers */
+template <class T>
+size_t basic_calculator<T>::evaluator_context::capacity_used() const {
+    return operators.capacity() + values.capacity() + program.code.capacity()
+        + program.constants.capacity() + program.variables.capacity()
+        + names.capacity() + text.capacity() + key.capacity();
+}
+
+/* Counts an allocation if any buffer has grown since last checked */
+template <class T>
+void basic_calculator<T>::evaluator_context::track() {
+    size_t now = capacity_used();
+    if (now != reserved) {
+        growths++;
+        reserved = now;
+    }
+}
+
+/* Returns number of times a buffer had to grow */
+template <class T>
+size_t basic_calculator<T>::evaluator_context::allocations() const {
+    return growths;
+}
+
+/* Copies an expression's text into the context's text buffer */
+template <class T>
+const char *basic_calculator<T>::evaluator_context::store(const char *exp, size_t length) {
+    text.assign(exp, length);
+    track();
+    return text.data();
+}
+
+/* Formats every result into the sink's buffer, which is written to the stream
+ a batch of lines at a time
+ */
+template <class T>
+void basic_calculator<T>::write_results(ostream &os, output_format format) const {
+    CALC_PROFILE_SCOPE(PROFILE_OUTPUT);
+    
+    output_sink sink(os, OUTPUT_BATCH_LINES);
+    const T *results = all_expressions.result_data();
+    sink.begin_results(format);
+    for (size_t i=0; i<all_expressions.size(); i++) {
+        sink.write_result(results[i], expression_text(all_expressions.offset(i)), all_expressions.length(i), format);
+    }
+    sink.end_results(format);
+}
+
+/* Friend function to the class that displays all expressions and their results
+ in a formatted, user-friendly manner to the console through write_results. No
+ expressions and their results are changed.
+ */
+ 
+template <class T>
+ostream &operator << (ostream &os, const basic_calculator<T> &c){
+    c.write_results(os, OUTPUT_TEXT);
     return os;
-}
\ No newline at end of file
+}
+
+// Compile the calculator for each supported value type
+template class basic_calculator<float>;
+template class basic_calculator<double>;
+template class basic_calculator<long double>;
+template ostream &operator << (ostream &os, const basic_calculator<float> &c);
+template ostream &operator << (ostream &os, const basic_calculator<double> &c);
+template ostream &operator << (ostream &os, const basic_calculator<long double> &c);
@@ -8,8 +8,13 @@
                         - Receives string that contains the expression,
                             evaluates it and returns its value to the calling
                             program.
+                        - Reports why an invalid expression has no value and
+                            where, without throwing, and keeps a table of the
+                            invalid lines of the files it loads
+                        - Evaluates a very long expression on many threads,
+                            as a balanced tree, if enabled
  
- Last Modified:     Nov 18, 2014
+ Last Modified:     Oct 17, 2026
  
  *****************************************************************************/
 
@@ -25,36 +30,372 @@
 #include <math.h>
 #include <ctype.h>
 #include <vector>
+#include <map>
+#include <memory>
 #include <stdexcept>
 #include <cstdlib>
+#include <stdint.h>
+#include "mapped_file.h"
+#include "result_cache.h"
+#include "diagnostic.h"
+#include "expression_store.h"
+#include "output_sink.h"
 using namespace std;
 
-class calculator {
+template <class T> class basic_calculator;
+template <class T> class expression_optimizer;
+template <class T> class shared_dag;
+template <class T> class incremental_expression;
+template <class T> class cell_sheet;
+template <class T> class eval_server;
+template <class T> class tree_evaluator;
+template <class T> class hot_expression;
+class thread_pool;
+template <class T> ostream &operator << (ostream &os, const basic_calculator<T> &c);
+
+/* A calculator whose values are of type T. It is compiled ahead of time for
+ float, which is fastest, and for double and long double, which keep more
+ precision. calculator is the float one.
+ */
+template <class T>
+class basic_calculator {
     
     // A structure to hold an infix expression and it's corresponding result
+    // while a file is loaded. The expression is not copied, it is a range of
+    // the calculator's text.
     struct evaluated_expression{
-        string exp;
-        float result;
+        size_t offset;
+        size_t length;
+        T result;
+        uint32_t hash;      // Hash of the text, to intern it
+    };
+    
+    // Store of all evaluated expressions: their results in one array and the
+    // id of their text, each distinct text being kept once
+    expression_store<T> all_expressions;
+    
+public:
+    
+    // An invalid line of a file given to the file loading constructors or
+    // add_shared: a range of the calculator's text, the line of the file it
+    // was on and the error and where on the line it is, both from 0
+    struct invalid_expression {
+        size_t offset;
+        size_t length;
+        uint32_t line;
+        uint32_t column;
+        error_kind kind;
     };
     
-    // Vector to store all evaluated expressions
-    vector<evaluated_expression> all_expressions;
+private:
+    
+    // Table of every invalid line, in the order they were read
+    vector<invalid_expression> invalid;
+    
+    // Text of all expressions: the memory mapped input file, if any, followed
+    // by the text owned by the calculator. Offsets past the end of the input
+    // file refer to text.
+    shared_ptr<mapped_file> input;
+    string text;
+    
+    // Bytes of text dropped by the expression store since text was last
+    // compacted, which nothing refers to any more
+    size_t dead_text;
     
 public:
     
+    // Bytecode operations of a compiled expression. Operators use their own
+    // character so they can be handed straight to execute. SQR and SQRT take
+    // a single operand; only the optimizer emits them.
+    enum opcode { PUSH = 'c', LOAD = 'v', ADD = '+', SUB = '-', MUL = '*',
+        DIV = '/', POW = '^', SQR = 's', SQRT = 'r' };
+        
+    // Whether compiled programs are optimized before they are run by add_new
+    // and the file loading constructors. OPTIMIZE_VERIFY runs both programs
+    // and treats any difference in their results as an error; its optimized
+    // program is not constant folded, so the rewrites are what it tests.
+    enum optimize_mode { OPTIMIZE_OFF, OPTIMIZE_ON, OPTIMIZE_VERIFY };
+    
+    // A single bytecode instruction. For PUSH, arg is the index of the value
+    // in the constant pool, for LOAD the index of the variable. For operators
+    // compiled from text it is the offset of the operator in the text, so an
+    // error found when running it can be reported where it was written.
+    struct instruction {
+        opcode op;
+        int arg;
+    };
+    
+    // An infix expression compiled to a flat postfix program of instructions
+    // and the constants they refer to
+    struct compiled_expression {
+        vector<instruction> code;
+        vector<T> constants;
+        vector<string> variables;   // Names of variables, in order of binding
+        int max_depth;  // Largest number of values on the stack during run
+    };
+    
+    // Reusable buffers for evaluating one expression after another without
+    // allocating: the operator stack and variables used while compiling, the
+    // program it is compiled to, the value stack it runs on and the text of
+    // the expression.
+    // Each buffer only grows, so once the context has seen expressions as
+    // large as the ones it is given, evaluating allocates nothing.
+    class evaluator_context {
+        friend class basic_calculator;
+        
+        vector<int> operators;      // Offsets of the operators in the text
+        vector<int> names;          // Offsets of the variables in the text
+        compiled_expression program;
+        vector<T> values;
+        string text;
+        string key;         // Normalized text, for looking up the cache
+        
+        // Optimizer and the optimized program, made when first needed
+        shared_ptr<expression_optimizer<T> > optimizer;
+        compiled_expression optimized;
+        
+        // Pool the parts of very long expressions are forked onto, if any
+        thread_pool *pool;
+        
+        size_t growths;     // Number of times a buffer had to grow
+        size_t reserved;    // Total capacity of the buffers when last checked
+        
+        size_t capacity_used() const;
+        void track();
+        
+    public:
+        
+        /* evaluator_context(size_t capacity=256);
+         Constructor that reserves room in each buffer for expressions of up to
+         capacity characters.
+         */
+        evaluator_context(size_t capacity=256);
+        
+        /* size_t allocations() const;
+         Returns the number of times evaluating with this context had to grow
+         one of its buffers, i.e. allocate memory. Stays the same in steady
+         state.
+         */
+        size_t allocations() const;
+        
+        /* const char *store(const char *exp, size_t length);
+         Copies the text of an expression into the context, for callers whose
+         own buffer does not outlive the evaluation.
+            @return const char* [out]   copy of exp, valid until the next call
+         */
+        const char *store(const char *exp, size_t length);
+    };
+    
+private:
+    
+    // A compiled program, run by a hot expression so that it is translated
+    // into machine code once it has been run often enough, and when it was
+    // last run, in runs of evaluate_new
+    struct program_entry {
+        shared_ptr<hot_expression<T> > hot;
+        size_t used;
+    };
+    
+    // Compiled programs of the expressions most recently passed to add_new
+    // and update, a bounded number of them. Each hot expression runs its
+    // program with the calculator that compiled it, so a copy of the
+    // calculator starts without any.
+    struct program_cache {
+        map<string, program_entry> entries;
+        size_t clock;
+        
+        program_cache() : clock(0) { }
+        program_cache(const program_cache &) : clock(0) { }
+        program_cache &operator = (const program_cache &) {
+            entries.clear();
+            clock = 0;
+            return *this;
+        }
+    };
+    program_cache programs;
+    
+    // Results of recently evaluated expressions, if enabled, shared by copies
+    // of the calculator, and the buffers add_new evaluates with
+    shared_ptr<result_cache<T> > cache;
+    evaluator_context scratch;
+    
+    // Whether programs are optimized before they are run
+    optimize_mode optimization;
+    
+    // Expressions at least this long are evaluated as trees, 0 for none
+    size_t tree_length;
+    
+    // Counters of the graphs files added by add_shared were evaluated with
+    shared_ptr<shared_dag<T> > dag;
+    
+    // Named cells kept alongside all_expressions, made when first used
+    shared_ptr<cell_sheet<T> > sheet;
+    
+    /* bool emit_operator(compiled_expression &prog, vector<int> &o,
+                          int &depth, const char *exp, diagnostic &error);
+     Pops the top operator off o, the offset of its character in exp, and
+     appends it to prog, checking that the stack of values it will operate on
+     at run time is deep enough. Returns false with error set if not.
+     */
+    bool emit_operator(compiled_expression &prog, vector<int> &o, int &depth, const char *exp, diagnostic &error);
+    
+    /* bool compile_checked(const char *exp, size_t length,
+                            compiled_expression &prog, vector<int> &opStack,
+                            vector<int> &names, diagnostic &error);
+     Compiles exp into prog using opStack as the operator stack, reusing the
+     memory both already hold. Returns false with error set if exp is
+     invalid. Rather than filling prog.variables, which would copy every
+     name, names is set to where each variable is first used in exp, in
+     order of binding. On success, error.offset is where the first variable
+     is, if there is any, to report it unbound.
+     */
+    bool compile_checked(const char *exp, size_t length, compiled_expression &prog, vector<int> &opStack, vector<int> &names, diagnostic &error);
+    
+    /* void compile_into(const char *exp, size_t length,
+                         compiled_expression &prog, vector<int> &opStack);
+     Same as above, throwing the exception error describes instead.
+     */
+    void compile_into(const char *exp, size_t length, compiled_expression &prog, vector<int> &opStack);
+    
+    /* bool run_checked(const compiled_expression &prog, const T *vars,
+                        T *valStack, T &result, size_t &failed);
+     Executes prog on a value stack of at least prog.max_depth elements.
+     Returns false if it divides by zero, with failed the index of the
+     instruction that did.
+     */
+    bool run_checked(const compiled_expression &prog, const T *vars, T *valStack, T &result, size_t &failed);
+    
+    /* T run_on(const compiled_expression &prog, const T *vars,
+                    T *valStack);
+     Same as above, throwing an invalid_argument exception if prog divides by
+     zero.
+     */
+    T run_on(const compiled_expression &prog, const T *vars, T *valStack) throw(invalid_argument);
+    
+    /* bool run_verified(const compiled_expression &prog,
+                         const compiled_expression &optimized, const T *vars,
+                         T *valStack, T &result, diagnostic &error);
+     Runs prog and its optimized version and checks that they agree.
+     */
+    bool run_verified(const compiled_expression &prog, const compiled_expression &optimized, const T *vars, T *valStack, T &result, diagnostic &error);
+    
+    /* size_t division_offset(const compiled_expression &prog, T *valStack,
+                              size_t length);
+     Returns the offset of the operator that divides by zero when prog, which
+     has no variables, is run, or length if none does.
+     */
+    size_t division_offset(const compiled_expression &prog, T *valStack, size_t length);
+    
+    /* text_space space() const;
+     Returns where the calculator's text is, until it is next appended to.
+     */
+    text_space space() const;
+    
+    /* const char *expression_text(size_t offset) const;
+     Returns a pointer to the character at offset of the calculator's text.
+     */
+    const char *expression_text(size_t offset) const;
+    
+    /* void append(const evaluated_expression &ee);
+     Interns the text of ee, which is already in the calculator's text, and
+     appends it and its result to all_expressions.
+     */
+    void append(const evaluated_expression &ee);
+    
+    /* uint32_t intern_copy(const char *exp, size_t length);
+     Returns the id of the text of exp, appending a copy of it to the
+     calculator's text only if no expression has the same text.
+     */
+    uint32_t intern_copy(const char *exp, size_t length);
+    
+    /* bool try_cached_evaluate(const char *exp, size_t length,
+                               evaluator_context &ctx, T &result,
+                               diagnostic &error);
+     Looks up the cached result or error of exp. If it is not cached,
+     evaluates it and caches the outcome. Evaluates directly if the cache is
+     not enabled. Returns false with error set if exp is invalid.
+     */
+    bool try_cached_evaluate(const char *exp, size_t length, evaluator_context &ctx, T &result, diagnostic &error);
+    
+    /* bool try_evaluate_stack(const char *exp, size_t length,
+                               evaluator_context &ctx, T &result,
+                               diagnostic &error);
+     Same as try_evaluate, always compiling exp into a single program and
+     running it on the context's stack.
+     */
+    bool try_evaluate_stack(const char *exp, size_t length, evaluator_context &ctx, T &result, diagnostic &error);
+    
+    /* T cached_evaluate(const char *exp, size_t length,
+                        evaluator_context &ctx);
+     Same as above, returning the result or throwing the error.
+     */
+    T cached_evaluate(const char *exp, size_t length, evaluator_context &ctx);
+    
+    /* void load(const char *buf, size_t length, size_t base,
+                 unsigned threads);
+     Evaluates each line of buf in parallel and appends the valid ones to
+     all_expressions as ranges of the calculator's text, where buf begins at
+     offset base. Invalid lines are appended to the invalid table in order.
+     */
+    void load(const char *buf, size_t length, size_t base, unsigned threads);
+    
+    /* void write_invalid(ostream &err, size_t from) const;
+     Writes the text of each invalid line from the (from)th on to &err, one
+     per line.
+     */
+    void write_invalid(ostream &err, size_t from) const;
+    
+    /* static void raise(const diagnostic &error, const char *exp,
+                         size_t length);
+     Throws the exception the throwing functions report error with.
+     */
+    static void raise(const diagnostic &error, const char *exp, size_t length) throw(logic_error, underflow_error);
+    
+    /* T evaluate_new(const string &exp);
+     Evaluates an expression given to add_new or update, compiling it only the
+     first time it is seen or looking it up in the cache.
+     */
+    T evaluate_new(const string &exp);
+    
+    /* void store(int exp_id, const char *exp, size_t length, T result);
+     Replaces the text and result of the (exp_id)th expression. The new text
+     is appended to the calculator's text, unless it is already there. The
+     range of the text replaced is reused once no expression has it, so an
+     expression edited again and again does not make the text grow.
+     */
+    void store(int exp_id, const char *exp, size_t length, T result);
+    
+    /* void compact_text();
+     Moves every range of the calculator's own text still in use, by the
+     expression store or an invalid line, to the start of a text of its own,
+     leaving out what nothing refers to.
+     */
+    void compact_text();
+    
+    // Keeps an expression of all_expressions up to date as it is edited
+    friend class incremental_expression<T>;
+    
+    // Answers expressions from its clients through the cache
+    friend class eval_server<T>;
+    
+    // Evaluates each part of a very long expression on a stack
+    friend class tree_evaluator<T>;
+    
+public:
+
 /******************************************************************************
     Constructors
  ******************************************************************************/
     
-    /* calculator();
+    /* basic_calculator();
      Constructor for calculator that takes no parameters. Initializes
      all_expressions to an empty vector
      Precondition:      none
      Postcondition:     all_expressions is an initialized vector of 0 elements
      */
-    calculator();
+    basic_calculator();
     
-    /* calculator();
+    /* basic_calculator();
      Constructor for calculator that initializes all_expressions from user
      supplied file
         @param  string fName [in]       file name
@@ -67,9 +408,64 @@ public:
                         evaluated result.
      Postcondition:     all_expressions is an initialized vector of n
                         n evaluated_expressions. Any invalid infix expressions 
-                        are left unevaluated and sent to &err
+                        are left unevaluated and sent to &err, and are listed
+                        with their error by get_invalid
+     */
+    basic_calculator(string fName, ifstream &readf, ostream &err=cerr) throw(invalid_argument);
+    
+    /* basic_calculator(string fName, ifstream &readf, ostream &err,
+                        unsigned threads, size_t cache_capacity=0,
+                        optimize_mode optimization=OPTIMIZE_OFF,
+                        size_t tree_length=0);
+     Constructor for calculator that initializes all_expressions from user
+     supplied file, evaluating the file in parallel. The file is split into
+     chunks of lines that are evaluated by a pool of worker threads, then the
+     results are merged back in the order of the file.
+        @param  string fName [in]       file name
+        @param  ifstream &readf [in]    file stream to read file input from
+        @param  ostream &err [out]      output stream to output any errors
+        @param  unsigned threads [in]   number of worker threads, 0 for one
+                                            per core
+        @param  size_t cache_capacity [in]  if not 0, enables the result cache
+                                                with this capacity before the
+                                                file is evaluated
+        @param  optimize_mode optimization [in] whether to optimize each
+                                                    program before running it
+        @param  size_t tree_length [in] if not 0, lines of at least this many
+                                            characters are evaluated as
+                                            trees, their parts on all the
+                                            threads
+     Precondition:      Same as above.
+     Postcondition:     Same as above. all_expressions and the invalid infix
+                        expressions sent to &err are in the same order as in
+                        the file, whatever the number of threads.
+     */
+    basic_calculator(string fName, ifstream &readf, ostream &err, unsigned threads, size_t cache_capacity=0, optimize_mode optimization=OPTIMIZE_OFF, size_t tree_length=0) throw(invalid_argument);
+    
+    /* basic_calculator(string fName, ostream &err, unsigned threads,
+                        size_t cache_capacity=0,
+                        optimize_mode optimization=OPTIMIZE_OFF,
+                        size_t tree_length=0);
+     Constructor for calculator that initializes all_expressions from user
+     supplied file without reading it into memory. The file is memory mapped
+     and parsed in place, in parallel, and all_expressions refers to the text
+     of each expression in the mapping instead of holding a copy, so memory
+     use is about the size of the results, not of the file.
+        @param  string fName [in]       file name
+        @param  ostream &err [out]      output stream to output any errors
+        @param  unsigned threads [in]   number of worker threads, 0 for one
+                                            per core
+        @param  size_t cache_capacity [in]  if not 0, enables the result cache
+                                                with this capacity
+        @param  optimize_mode optimization [in] whether to optimize each
+                                                    program before running it
+        @param  size_t tree_length [in] same as above
+     Precondition:      &err is open and initialized, fName is the name and
+                        path of a valid input file of n infix expressions that
+                        is not changed while the calculator exists.
+     Postcondition:     Same as above.
      */
-    calculator(string fName, ifstream &readf, ostream &err=cerr) throw(invalid_argument);
+    basic_calculator(string fName, ostream &err, unsigned threads, size_t cache_capacity=0, optimize_mode optimization=OPTIMIZE_OFF, size_t tree_length=0) throw(invalid_argument);
     
 /******************************************************************************
      Accessors
@@ -91,10 +487,150 @@ public:
                         all_expressions as the last element of the vector. 
                         all_expressions now contains n+1 evaluated_expressions. 
                         If exp is not a valid infix expression, an exception is
-                        thrown and
+                        thrown and all_expressions is unchanged.
+                        The compiled program of exp is kept, so adding the same
+                        expression again only runs it.
      */
     void add_new(string exp, ostream &err=cerr);
     
+    /* void update(int exp_id, string exp, ostream &err=cerr);
+     Replaces the infix expression in the (exp_id)th position of the
+     all_expressions vector and its result, in place, instead of appending a
+     new one with add_new.
+        @param  int exp_id [in]         position of the expression to replace
+        @param  string exp [in]         new infix expression
+        @param  ostream &err [in/out]   output stream to output any errors
+     Precondition:      0 <= exp_id < size()
+     Postcondition:     If exp is a valid infix expression, it and its result
+                        are at the (exp_id)th position and every other element
+                        of all_expressions is unchanged. Else an exception is
+                        thrown and all_expressions is unchanged. Throws an
+                        out_of_range exception if there is no such position.
+                        For an expression being edited a little at a time,
+                        incremental_expression only evaluates what changed.
+     */
+    void update(int exp_id, string exp, ostream &err=cerr);
+    
+    /* void save(string fName) const;
+     Writes every expression of the all_expressions vector and its result to
+     a binary file: a column of the results, a table of where each
+     expression starts and the text of all expressions. Results are kept
+     exactly, and result_file reads any of them back without loading the
+     whole file.
+        @param  string fName [in]       name of the file to write
+     Precondition:      none
+     Postcondition:     fName holds all_expressions in order, else an
+                        invalid_argument exception holding fName is thrown if
+                        it cannot be written. all_expressions is unchanged.
+     */
+    void save(string fName) const throw(invalid_argument);
+    
+    /* void enable_cache(size_t capacity);
+     Keeps the results and errors of recently evaluated expressions, keyed by
+     their text without spaces, so that evaluating the same expression again
+     looks it up instead. Used by add_new and the file loading constructors.
+        @param  size_t capacity [in]    most expressions to remember, 0 to
+                                            disable the cache
+     Precondition:      none
+     Postcondition:     A new, empty cache of the given capacity is used, or
+                        none if capacity is 0.
+     */
+    void enable_cache(size_t capacity);
+    
+    /* void set_optimizer(optimize_mode mode);
+     Sets whether add_new, stream and evaluate with a context optimize each
+     compiled program before running it. With OPTIMIZE_VERIFY, both the optimized and the original
+     program are run and an expression whose results differ, or only one of
+     which fails, is treated as invalid, so comparing the output with that of
+     OPTIMIZE_OFF checks the optimizer.
+        @param  optimize_mode mode [in]     OPTIMIZE_OFF, OPTIMIZE_ON or
+                                                OPTIMIZE_VERIFY
+     Postcondition:     Expressions evaluated from now on use mode.
+     */
+    void set_optimizer(optimize_mode mode);
+    
+    /* void set_tree_evaluation(size_t min_length);
+     Sets which expressions are evaluated as balanced trees instead of on a
+     single stack: the expression is parsed into a balanced tree of parts by
+     cutting long sums at their + operators and long products at their *
+     operators, and the parts are compiled and evaluated as fork-join tasks
+     on the threads of the file loading constructors. Worth it for
+     expressions of megabytes; shorter ones are no faster.
+        @param  size_t min_length [in]  fewest characters of an expression
+                                            evaluated as a tree, 0 for none
+     Postcondition:     Expressions evaluated from now on that are at least
+                        min_length long may round differently, as their sums
+                        and products are added up in another order. Their
+                        results do not depend on the number of threads.
+     */
+    void set_tree_evaluation(size_t min_length);
+    
+    /* const result_cache<T> *get_cache() const;
+     Returns the result cache, to read its hit, miss and eviction counters, or
+     NULL if it is not enabled.
+     */
+    const result_cache<T> *get_cache() const;
+    
+    /* void add_shared(string fName, ifstream &readf, ostream &err=cerr);
+     Reads a file of infix expressions, one per line, and appends each valid
+     one and its result to all_expressions, like the file loading
+     constructors do. All the expressions of the file are compiled first and
+     merged into one graph in which each distinct subexpression is a single
+     node, so a subexpression shared by many lines, like (15.625-8.375)^2, is
+     evaluated only once.
+        @param  string fName [in]       file name
+        @param  ifstream &readf [in]    file stream to read file input from
+        @param  ostream &err [out]      output stream to output any errors
+     Precondition:      &readf and &err are open and initialized, fName is the
+                        name and path of a valid input file of n infix
+                        expressions.
+     Postcondition:     all_expressions holds n more evaluated_expressions, in
+                        the order of the file, less any invalid ones, which are
+                        sent to &err in order and listed by get_invalid.
+                        Throws an invalid_argument exception if the file
+                        cannot be opened.
+     */
+    void add_shared(string fName, ifstream &readf, ostream &err=cerr) throw(invalid_argument);
+    
+    /* const shared_dag<T> *get_dag() const;
+     Returns the graph add_shared used, to read how many subexpressions were
+     shared, or NULL if add_shared has not been called. Its nodes are freed
+     once each file has been evaluated; only its counters are kept.
+     */
+    const shared_dag<T> *get_dag() const;
+    
+    /* cell_sheet<T> &cells();
+     Returns the calculator's named cells, whose expressions can use the
+     values of other cells by name, e.g. total = price * (1 + tax). Cells are
+     kept apart from all_expressions, and only the cells depending on a cell
+     that changed are computed again when they are read.
+        @return cell_sheet<T>& [out]    cells of the calculator, shared by
+                                            its copies
+     Postcondition:     An empty sheet is made the first time.
+     */
+    cell_sheet<T> &cells();
+    
+    /* size_t invalid_size() const;
+     Returns the number of invalid lines in the files loaded so far.
+     */
+    size_t invalid_size() const;
+    
+    /* const invalid_expression &get_invalid(int id) const;
+     Returns the (id)th invalid line of the files loaded so far: which line of
+     its file it was, what is wrong with it and where on the line.
+        @param  int id [in]         position in the table of invalid lines
+        @return invalid_expression [out]    line, column and kind of error
+     Precondition:      0 <= id < invalid_size()
+     Postcondition:     The table is unchanged.
+     */
+    const invalid_expression &get_invalid(int id) const;
+    
+    /* string get_invalid_expression(int id) const;
+     Returns the text of the (id)th invalid line.
+     Precondition:      0 <= id < invalid_size()
+     */
+    string get_invalid_expression(int id) const;
+    
     /* string get_expression(int exp_id) const;
      Returns the infix expression that is in the (exp_id)th position of the 
     all_expressions vector.
@@ -109,11 +645,11 @@ public:
     */
     string get_expression(int exp_id) const;
     
-    /* float get result (int exp_id) const;
+    /* T get result (int exp_id) const;
      Returns the result of the infix expression that is in the (exp_id)th
      position of the all_expressions vector.
         @param  int exp_id [in]      position of the result to retrieve
-        @return  float [out]         result at the (exp_id)th position
+        @return  T [out]         result at the (exp_id)th position
      Precondition:       An evaluated_expression is a data structure containing
                         an infix expression and its correctly evaluated result.
                         all_expressions is a non-empty, initialized vector of
@@ -121,9 +657,29 @@ public:
      Postcondition:     all_expressions[i].result is returned, all_expressions
                         is unchanged.
      */
-    float get_result(int exp_id) const;
+    T get_result(int exp_id) const;
+    
+    /* size_t size() const;
+     Returns the number of valid expressions in the all_expressions vector.
+     Postcondition:     all_expressions is unchanged.
+     */
+    size_t size() const;
+    
+    /* const T *get_results() const;
+     Returns the results of every expression as one array, in order, to scan
+     them without reading any text.
+        @return T* [out]    size() results, valid until an expression is
+                                added, or NULL if there are none
+     */
+    const T *get_results() const;
+    
+    /* size_t distinct_size() const;
+     Returns the number of distinct texts of the expressions. Expressions with
+     the same text share it, however many there are.
+     */
+    size_t distinct_size() const;
     
-    /*  friend ostream &operator << (ostream &os, const calculator &c);
+    /*  friend ostream &operator << (ostream &os, const basic_calculator &c);
      Overloaded operator friend function that prints out all elements of the
      all_expressions vector with each element printed to the stream on a single
      line as "Result = Expression".
@@ -134,7 +690,45 @@ public:
                         &os in a single line as "Result = Expression". &c is 
                         unchanged.
      */
-    friend ostream &operator << (ostream &os, const calculator &c);
+    friend ostream &operator << <>(ostream &os, const basic_calculator &c);
+    
+    /* void write_results(ostream &os, output_format format=OUTPUT_TEXT)
+                          const;
+     Prints every element of the all_expressions vector with its result, as
+     operator << does, or as CSV or JSON. Results are formatted without the
+     stream's formatting and written a large batch of lines at a time.
+        @param  ostream &os [in/out]        outstream to print output to
+        @param  output_format format [in]   "Result = Expression" lines, CSV
+                                                with a header line, or a
+                                                JSON array of objects
+     Precondition:      &os is open and initialized
+     Postcondition:     Each element of all_expressions has been written to
+                        &os in order, with its result to 2 decimals, and &os
+                        is flushed. The formatting flags of &os are unchanged.
+     */
+    void write_results(ostream &os, output_format format=OUTPUT_TEXT) const;
+    
+    /* void stream(istream &in, ostream &out, ostream &err,
+                   size_t batch_lines=1024);
+     Evaluates each line read from in and writes it straight to out as
+     "Result = Expression", without storing it in all_expressions, so memory
+     use stays the same however long the input is. Output is written a batch
+     of lines at a time, or sooner whenever no more input is ready, so an
+     interactive user sees each result as it is entered.
+        @param  istream &in [in/out]        stream of infix expressions, one
+                                                per line
+        @param  ostream &out [out]          output stream for results
+        @param  ostream &err [out]          output stream for invalid
+                                                expressions
+        @param  size_t batch_lines [in]     lines to buffer before writing
+     Precondition:      &in, &out and &err are open and initialized,
+                        batch_lines > 0
+     Postcondition:     Every line of &in has been written to &out with its
+                        result in the format of operator <<, or to &err if it
+                        is invalid. all_expressions is unchanged. The result
+                        cache is used if it is enabled.
+     */
+    void stream(istream &in, ostream &out, ostream &err, size_t batch_lines=1024);
     
 /******************************************************************************
      Expression evaluation functions
@@ -149,7 +743,7 @@ public:
      Precondition:      ch is non-empty and initialized character
      Postcondition:     returns true if ch is either +, -, /, * or ^, else 
                         returns false
-     
+                        
      */
     bool is_operator(char ch);
     
@@ -165,17 +759,17 @@ public:
      */
     int precedence(char op) throw(invalid_argument);
     
-    /*  float execute(stack<float> &v, stack<char> &o);
+    /*  T execute(stack<T> &v, stack<char> &o);
      Pops the top two values off the value stack v, as operand2 and operand1 (in
      that order) and the top value off the operand stack o as op and returns the
      result of operand1 op operand2.
-        @param  stack<float> &v [in/out]    stack of operands
+        @param  stack<T> &v [in/out]    stack of operands
         @param  stack<char> &o [in/out]     stack of operators
-        @return float                       result of operation
+        @return T                       result of operation
      Precondition:      &o contains only characters of type '+', '-', '*', '/',
                         '(' or '^' and op can only be of type '+', '-', '*', '/'
                         or '^' (i.e. not a parenthesis). &v contains only valid
-                        float values. &o and &v contain on >= 1 and vn >= 2
+                        values of type T. &o and &v contain on >= 1 and vn >= 2
                         elements respectively. If top of &o=='/', top of &v!=0.
      Postcondition:     Returns result of operation operand1 op operand2 where
                         operand2 and operand1 were the top two values of &v in
@@ -183,23 +777,219 @@ public:
                         operand1 are popped off &v and op is popped off &o so 
                         &v and &o contain vn-2 and on-1 elements respectively.
      */
-    float execute(stack<float> &v, stack<char> &o) throw(underflow_error, invalid_argument);
-
-    /* float evaluate(string exp); 
+    T execute(stack<T> &v, stack<char> &o) throw(underflow_error, invalid_argument);
+    
+    /*  T execute(char op, T operand1, T operand2);
+     Returns the result of operand1 op operand2.
+        @param  char op [in]            operator to apply
+        @param  T operand1 [in]     left operand
+        @param  T operand2 [in]     right operand
+        @return T                   result of operation
+     Precondition:      op is one of '+', '-', '*', '/' or '^'. If op is '/',
+                        operand2 != 0.
+     Postcondition:     Returns result of operand1 op operand2, else throws an
+                        invalid_argument exception.
+     */
+    static T execute(char op, T operand1, T operand2) throw(invalid_argument);
+    
+    /*  T execute(char op, T operand);
+     Returns the result of a single operand operator: operand * operand for
+     SQR, the square root of operand for SQRT.
+     Postcondition:     Returns operand ^ 2 or operand ^ 0.5, correctly
+                        rounded, else throws an invalid_argument exception if
+                        op is not SQR or SQRT. Negative operands, including
+                        -0, give what pow gives.
+     */
+    static T execute(char op, T operand) throw(invalid_argument);
+    
+    /* compiled_expression compile(string exp);
+     Takes an infix expression as a string exp, checks it for validity and
+     translates it into a postfix program that can be run any number of times
+     without parsing exp again.
+        @param  string exp [in]                 string to validate and compile
+        @return compiled_expression [out]       postfix program of exp
+     Precondition:      exp is a valid infix expression containing only positive
+                        decimal numbers, variables, parentheses, white spaces
+                        and the operators '+', '-', '*', '/' or '^'. Numbers
+                        may have an exponent, e.g. 1.5e3. A variable
+                        is a letter or underscore followed by any number of
+                        letters, digits or underscores, e.g. x, rate or t0.
+     Postcondition:     returns the compiled program of exp if it is valid, else
+                        throws an exception. The names of the variables of exp
+                        are listed in prog.variables in order of first use.
+                        Division by zero is only detected when the program is
+                        run.
+     */
+    compiled_expression compile(string exp);
+    
+    /* compiled_expression compile(const char *exp, size_t length);
+     Same as above, for an expression given as the first length characters of
+     exp, which need not be null terminated.
+     */
+    compiled_expression compile(const char *exp, size_t length);
+    
+    /* int variable_index(const compiled_expression &prog, string name) const;
+     Returns the position a variable's value must be bound at when running prog.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @param  string name [in]                name of the variable
+        @return int [out]                       index of the variable in
+                                                    prog.variables, or -1
+     Precondition:      prog was returned by compile
+     Postcondition:     returns index of name in prog.variables, or -1 if prog
+                        does not use the variable. prog is unchanged.
+     */
+    int variable_index(const compiled_expression &prog, string name) const;
+    
+    /* compiled_expression optimize(const compiled_expression &prog);
+     Returns an optimized copy of a compiled program: constant subexpressions
+     are folded, the identities x*1, x/1, x+0, x-0 and x^1 are dropped and
+     x^2 and x^0.5 become a square and a square root, which are cheaper than
+     pow. Worth it for a program that is run many times.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @return compiled_expression [out]       optimized program
+     Precondition:      prog was returned by compile or optimize
+     Postcondition:     The result runs faster, or as fast, and gives the same
+                        results as prog for any values of its variables,
+                        except that x^2 and x^0.5 may differ in the last bit,
+                        as a square and sqrt are correctly rounded and pow
+                        may not be. It
+                        fails whenever prog does, so division by a constant
+                        zero is never folded. Its variables are bound in the
+                        same order.
+     */
+    compiled_expression optimize(const compiled_expression &prog);
+    
+    /* T run(const compiled_expression &prog);
+     Executes a compiled program that has no variables and returns its result.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @return T [out]                     result of the program
+     Precondition:      prog was returned by compile and prog.variables is
+                        empty
+     Postcondition:     returns the result of prog, else throws an
+                        invalid_argument exception if it divides by zero or
+                        uses a variable.
+     */
+    T run(const compiled_expression &prog) throw(invalid_argument);
+    
+    /* T run(const compiled_expression &prog, const vector<T> &vars);
+     Executes a compiled program with its variables bound to the given values
+     and returns its result. No parsing or allocation is done, so a program can
+     be run over millions of sets of values.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @param  vector<T> &vars [in]        value of each variable, in the
+                                                    order of prog.variables
+        @return T [out]                     result of the program
+     Precondition:      prog was returned by compile, vars holds at least
+                        prog.variables.size() values
+     Postcondition:     returns the result of prog, else throws an
+                        invalid_argument exception if it divides by zero or
+                        too few values are bound.
+     */
+    T run(const compiled_expression &prog, const vector<T> &vars) throw(invalid_argument);
+    
+    /* T run(const compiled_expression &prog, const T *vars);
+     Same as above, with the values of the variables given as an array of at
+     least prog.variables.size() floats.
+     */
+    T run(const compiled_expression &prog, const T *vars) throw(invalid_argument);
+    
+    /* void run_batch(const compiled_expression &prog,
+                      const vector<const T *> &columns, size_t rows,
+                      T *results, unsigned char *errors);
+     Executes a compiled program once for each of many rows of variable values
+     given as columns, one array per variable. Each operator is applied to
+     whole blocks of rows at a time by the vectorized column kernels.
+        @param  compiled_expression &prog [in]      program returned by compile
+        @param  vector<const T*> &columns [in]  values of each variable,
+                                                        in the order of
+                                                        prog.variables, each
+                                                        an array of rows values
+        @param  size_t rows [in]                    number of rows
+        @param  T *results [out]                result of each row
+        @param  unsigned char *errors [out]         error flag of each row
+     Precondition:      prog was returned by compile, columns holds at least
+                        prog.variables.size() arrays, results and errors hold
+                        at least rows elements
+     Postcondition:     results[i] holds the result of prog with its variables
+                        bound to row i of columns. errors[i] is 1 if row i
+                        divides by zero, in which case results[i] is undefined,
+                        else 0. Throws an invalid_argument exception if too few
+                        columns are given.
+     */
+    void run_batch(const compiled_expression &prog, const vector<const T *> &columns, size_t rows, T *results, unsigned char *errors) throw(invalid_argument);
+    
+    /* T evaluate(string exp); 
      Takes an infix expression as a string exp, checks it for validity (e.g. 
      checks for matching parentheses, correct number of operands vs. operators, 
      division by zero errors) and returns the result of its evaluation.
         @param  string exp [in]         string to validate and evaluate
         @param  ostream &err [in/out]   strema to output any errors to
-        @return float [out]             result of evaluation of valid string
+        @return T [out]             result of evaluation of valid string
      Precondition:      exp is a valid infix expression containing only positive
                         decimal numbers, parentheses, white spaces and the
                         operators '+', '-', '*', '/' or '^'. 
      Postcondition:     returns the result of the infix expression if it is 
                         valid, else throws an exception.
      */
-    float evaluate(string exp, ostream &err=cerr);
+    T evaluate(string exp, ostream &err=cerr);
+    
+    /* T evaluate(const char *exp, size_t length);
+     Same as above, for an expression given as the first length characters of
+     exp, which need not be null terminated.
+     */
+    T evaluate(const char *exp, size_t length);
+    
+    /* T evaluate(const char *exp, size_t length, evaluator_context &ctx);
+     Same as above, using the buffers of ctx instead of allocating new ones.
+     Evaluating many expressions with the same context does no heap allocation
+     once its buffers are large enough, which ctx.allocations() reports.
+        @param  char *exp [in]                  expression to evaluate
+        @param  size_t length [in]              number of characters in exp
+        @param  evaluator_context &ctx [in/out] buffers to evaluate with
+        @return T [out]                     result of evaluation
+     Precondition:      ctx is not used by another thread
+     Postcondition:     returns the result of the infix expression if it is 
+                        valid, else throws an exception.
+     */
+    T evaluate(const char *exp, size_t length, evaluator_context &ctx);
+    
+    /* bool try_evaluate(const char *exp, size_t length,
+                         evaluator_context &ctx, T &result, diagnostic &error);
+     Same as above, reporting an invalid expression by returning false instead
+     of throwing. Nothing is thrown or allocated for an invalid expression, so
+     files with many of them are evaluated as fast as valid ones.
+        @param  char *exp [in]                  expression to evaluate
+        @param  size_t length [in]              number of characters in exp
+        @param  evaluator_context &ctx [in/out] buffers to evaluate with
+        @param  T &result [out]                 result of evaluation
+        @param  diagnostic &error [out]         kind and offset of the error
+     Precondition:      ctx is not used by another thread
+     Postcondition:     Returns true with result set if exp is valid, else
+                        false with error set to the kind of error and the
+                        offset in exp of the character in error. result is
+                        then undefined.
+     */
+    bool try_evaluate(const char *exp, size_t length, evaluator_context &ctx, T &result, diagnostic &error);
+    
+    /* static string error_message(const diagnostic &error, const char *exp,
+                                   size_t length);
+     Returns the text of the exception evaluate throws for error, which was
+     found in the first length characters of exp, e.g. "Unbound variable x".
+     */
+    static string error_message(const diagnostic &error, const char *exp, size_t length);
     
 };
 
+// Compiled ahead of time in calculator.cpp
+extern template class basic_calculator<float>;
+extern template class basic_calculator<double>;
+extern template class basic_calculator<long double>;
+extern template ostream &operator << (ostream &os, const basic_calculator<float> &c);
+extern template ostream &operator << (ostream &os, const basic_calculator<double> &c);
+extern template ostream &operator << (ostream &os, const basic_calculator<long double> &c);
+
+// Calculator for throughput, and for accuracy
+typedef basic_calculator<float> calculator;
+typedef basic_calculator<double> double_calculator;
+
 #endif
\ No newline at end of file
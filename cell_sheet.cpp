@@ -0,0 +1,331 @@
+/*****************************************************************************
+ Title:             cell_sheet.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Cell Sheet Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "cell_sheet.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include <atomic>
+#include <limits>
+#include <ctype.h>
+
+/* Cell sheet constructor */
+template <class T>
+cell_sheet<T>::cell_sheet() : recomputed_count(0) { }
+
+/* Looks the name up */
+template <class T>
+int cell_sheet<T>::find(const string &name) const {
+    map<string, int>::const_iterator it = ids.find(name);
+    return it == ids.end() ? -1 : it->second;
+}
+
+/* Looks the name up, adding an undefined cell if there is none */
+template <class T>
+int cell_sheet<T>::find_or_add(const string &name) {
+    int c = find(name);
+    if (c >= 0) { return c; }
+    
+    cell cl;
+    cl.name = name;
+    cl.value = 0;
+    cl.defined = false;
+    cl.failed = false;
+    cl.dirty = true;
+    
+    c = (int)cells.size();
+    cells.push_back(cl);
+    ids[name] = c;
+    return c;
+}
+
+/* Follows the inputs of from, depth first, looking for target */
+template <class T>
+bool cell_sheet<T>::uses(int from, int target) const {
+    vector<int> stack(1, from);
+    vector<bool> seen(cells.size(), false);
+    
+    while (!stack.empty()) {
+        int c = stack.back();
+        stack.pop_back();
+        if (c == target) { return true; }
+        if (seen[c]) { continue; }
+        seen[c] = true;
+        stack.insert(stack.end(), cells[c].inputs.begin(), cells[c].inputs.end());
+    }
+    return false;
+}
+
+/* Marks the cell and its dependents. A cell that is already marked has its
+ dependents marked too, so the walk stops there.
+ */
+template <class T>
+void cell_sheet<T>::invalidate(int c) {
+    vector<int> stack(1, c);
+    
+    while (!stack.empty()) {
+        int n = stack.back();
+        stack.pop_back();
+        if (cells[n].dirty) { continue; }
+        cells[n].dirty = true;
+        stack.insert(stack.end(), cells[n].dependents.begin(), cells[n].dependents.end());
+    }
+}
+
+/* Depth first walk of the marked inputs, appending each cell once all of its
+ inputs have been
+ */
+template <class T>
+void cell_sheet<T>::schedule(int c, vector<int> &order) const {
+    if (!cells[c].dirty) { return; }
+    
+    // Each entry is a cell and the next of its inputs to visit
+    vector<pair<int, size_t> > stack(1, make_pair(c, (size_t)0));
+    vector<bool> seen(cells.size(), false);
+    seen[c] = true;
+    
+    while (!stack.empty()) {
+        int n = stack.back().first;
+        size_t &next = stack.back().second;
+        
+        if (next < cells[n].inputs.size()) {
+            int input = cells[n].inputs[next++];
+            if (cells[input].dirty && !seen[input]) {
+                seen[input] = true;
+                stack.push_back(make_pair(input, (size_t)0));
+            }
+        }
+        else {
+            order.push_back(n);
+            stack.pop_back();
+        }
+    }
+}
+
+/* Runs the program of the cell with its variables bound to the values of its
+ inputs. A failure of an input is passed on.
+ */
+template <class T>
+void cell_sheet<T>::compute(int c) {
+    cell &cl = cells[c];
+    cl.failed = false;
+    cl.dirty = false;
+    
+    if (!cl.defined) {
+        cl.failed = true;
+        cl.error = "Undefined cell " + cl.name;
+        return;
+    }
+    
+    T local[16];
+    vector<T> heap;
+    T *vars = local;
+    if (cl.inputs.size() > 16) {
+        heap.resize(cl.inputs.size());
+        vars = &heap[0];
+    }
+    
+    for (size_t i = 0; i<cl.inputs.size(); i++) {
+        const cell &input = cells[cl.inputs[i]];
+        if (input.failed) {
+            cl.failed = true;
+            cl.error = input.error;
+            return;
+        }
+        vars[i] = input.value;
+    }
+    
+    try {
+        cl.value = calc.run(cl.prog, vars);
+    }
+    catch (exception &e) {
+        CALC_PROFILE_EXCEPTION();
+        cl.failed = true;
+        cl.error = e.what();
+    }
+}
+
+/* Checks the name and that none of the cells the program uses already uses
+ this one, then points the graph's edges at the new inputs
+ */
+template <class T>
+void cell_sheet<T>::define(const string &name, const string &text, const program &prog) throw(invalid_argument) {
+    bool valid = !name.empty() && (isalpha(name[0]) || name[0] == '_');
+    for (size_t i = 1; i<name.length(); i++) {
+        if (!isalnum(name[i]) && name[i] != '_') { valid = false; }
+    }
+    if (!valid) { throw invalid_argument("Invalid cell name"); }
+    
+    int c = find(name);
+    for (size_t i = 0; i<prog.variables.size(); i++) {
+        int input = find(prog.variables[i]);
+        if (input >= 0 && c >= 0 && uses(input, c)) {
+            throw invalid_argument("Circular reference to cell " + name);
+        }
+        if (prog.variables[i] == name) {
+            throw invalid_argument("Circular reference to cell " + name);
+        }
+    }
+    
+    c = find_or_add(name);
+    
+    // Forget the old inputs
+    for (size_t i = 0; i<cells[c].inputs.size(); i++) {
+        vector<int> &deps = cells[cells[c].inputs[i]].dependents;
+        for (size_t j = 0; j<deps.size(); j++) {
+            if (deps[j] == c) {
+                deps[j] = deps.back();
+                deps.pop_back();
+                break;
+            }
+        }
+    }
+    
+    vector<int> inputs;
+    for (size_t i = 0; i<prog.variables.size(); i++) {
+        int input = find_or_add(prog.variables[i]);
+        cells[input].dependents.push_back(c);
+        inputs.push_back(input);
+    }
+    
+    cell &cl = cells[c];
+    cl.text = text;
+    cl.prog = prog;
+    cl.inputs = inputs;
+    cl.defined = true;
+    invalidate(c);
+}
+
+/* Compiles the expression and makes it the cell's */
+template <class T>
+void cell_sheet<T>::set(string name, string exp) throw(invalid_argument) {
+    define(name, exp, calc.compile(exp));
+}
+
+/* Makes a program that pushes the value, printed with enough digits to read
+ it back exactly
+ */
+template <class T>
+void cell_sheet<T>::set_value(string name, T value) throw(invalid_argument) {
+    program prog;
+    typename calculator_type::instruction ins;
+    ins.op = calculator_type::PUSH;
+    ins.arg = 0;
+    prog.code.push_back(ins);
+    prog.constants.push_back(value);
+    prog.max_depth = 1;
+    
+    ostringstream text;
+    text << setprecision(numeric_limits<T>::max_digits10) << value;
+    define(name, text.str(), prog);
+}
+
+/* Computes the changed cells the cell depends on, in order, then the cell */
+template <class T>
+T cell_sheet<T>::get(string name) throw(invalid_argument) {
+    int c = find(name);
+    if (c < 0) { throw invalid_argument("Unknown cell " + name); }
+    
+    vector<int> order;
+    schedule(c, order);
+    for (size_t i = 0; i<order.size(); i++) { compute(order[i]); }
+    recomputed_count = order.size();
+    
+    if (cells[c].failed) { throw invalid_argument(cells[c].error); }
+    return cells[c].value;
+}
+
+/* Counts the changed inputs of each changed cell and starts the cells that
+ have none. When a cell is done, each changed cell using it has one less to
+ wait for, and is started once it has none. Every other cell is up to date,
+ and only a cell's own task writes to it, so tasks share nothing else.
+ */
+template <class T>
+void cell_sheet<T>::recompute(unsigned threads) {
+    vector<int> changed;
+    for (size_t c = 0; c<cells.size(); c++) {
+        if (cells[c].dirty) { changed.push_back((int)c); }
+    }
+    recomputed_count = changed.size();
+    if (changed.empty()) { return; }
+    
+    // On one thread, as get would compute each cell
+    if (threads == 1) {
+        vector<int> order;
+        for (size_t i = 0; i<changed.size(); i++) {
+            order.clear();
+            schedule(changed[i], order);
+            for (size_t j = 0; j<order.size(); j++) { compute(order[j]); }
+        }
+        return;
+    }
+    
+    vector<atomic<int> > waiting(cells.size());
+    vector<bool> marked(cells.size(), false);
+    vector<int> ready;
+    for (size_t i = 0; i<changed.size(); i++) { marked[changed[i]] = true; }
+    for (size_t i = 0; i<changed.size(); i++) {
+        int count = 0;
+        const vector<int> &inputs = cells[changed[i]].inputs;
+        for (size_t j = 0; j<inputs.size(); j++) { count += marked[inputs[j]]; }
+        waiting[changed[i]].store(count);
+        if (count == 0) { ready.push_back(changed[i]); }
+    }
+    
+    thread_pool pool(threads);
+    function<void(int)> run_cell = [&](int c) {
+        compute(c);
+        const vector<int> &deps = cells[c].dependents;
+        for (size_t j = 0; j<deps.size(); j++) {
+            if (waiting[deps[j]].fetch_sub(1) == 1) {
+                int d = deps[j];
+                pool.submit([&run_cell, d]() { run_cell(d); });
+            }
+        }
+    };
+    
+    // Cells started by their last input reach 0 while these are submitted, so
+    // the ones to start are those that had none to begin with
+    for (size_t i = 0; i<ready.size(); i++) {
+        int c = ready[i];
+        pool.submit([&run_cell, c]() { run_cell(c); });
+    }
+    pool.wait();
+}
+
+/* Returns true if the cell exists */
+template <class T>
+bool cell_sheet<T>::contains(string name) const {
+    return find(name) >= 0;
+}
+
+/* Returns the text of the cell */
+template <class T>
+string cell_sheet<T>::expression(string name) const throw(invalid_argument) {
+    int c = find(name);
+    if (c < 0) { throw invalid_argument("Unknown cell " + name); }
+    return cells[c].text;
+}
+
+/* Returns the number of cells */
+template <class T>
+size_t cell_sheet<T>::size() const {
+    return cells.size();
+}
+
+/* Returns the number of cells last computed */
+template <class T>
+size_t cell_sheet<T>::recomputed() const {
+    return recomputed_count;
+}
+
+// Cell sheets of each calculator
+template class cell_sheet<float>;
+template class cell_sheet<double>;
+template class cell_sheet<long double>;
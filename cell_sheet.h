@@ -0,0 +1,172 @@
+/*****************************************************************************
+ Title:             cell_sheet.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Cell Sheet Class Definition (Header File)
+                        - Holds named cells, each an infix expression whose
+                            variables are the names of other cells
+                        - Keeps the graph of which cells use which, and
+                            rejects a cell that would use itself
+                        - When a cell changes, only the cells that use it,
+                            directly or not, are computed again, and only
+                            once their value is asked for
+                        - Computes cells that do not depend on each other on
+                            many threads at once
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___cell_sheet__
+#define ___cell_sheet__
+
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include "calculator.h"
+using namespace std;
+
+template <class T>
+class cell_sheet {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef typename calculator_type::compiled_expression program;
+    
+    // A named expression and its value. A cell that is used before it is
+    // set is added undefined.
+    struct cell {
+        string name;
+        string text;
+        program prog;
+        vector<int> inputs;         // Cell of each variable of prog, in order
+        vector<int> dependents;     // Cells using this one
+        T value;
+        string error;               // Why it has no value, if failed
+        bool defined;
+        bool failed;
+        bool dirty;                 // Must be computed again
+    };
+    
+    calculator_type calc;           // Compiles and runs the cells' programs
+    vector<cell> cells;
+    map<string, int> ids;
+    size_t recomputed_count;
+    
+    /* int find(const string &name) const;
+       int find_or_add(const string &name);
+     Return the index of a cell, or -1 if there is none, or add an undefined
+     one.
+     */
+    int find(const string &name) const;
+    int find_or_add(const string &name);
+    
+    /* bool uses(int from, int target) const;
+     Returns true if cell from uses cell target, directly or not.
+     */
+    bool uses(int from, int target) const;
+    
+    /* void invalidate(int c);
+     Marks a cell and every cell that uses it to be computed again.
+     */
+    void invalidate(int c);
+    
+    /* void schedule(int c, vector<int> &order) const;
+     Appends the cells that must be computed before c can be read, c last,
+     each after the cells it uses.
+     */
+    void schedule(int c, vector<int> &order) const;
+    
+    /* void compute(int c);
+     Computes a cell from the values of the cells it uses, which must be up to
+     date.
+     */
+    void compute(int c);
+    
+    /* void define(const string &name, const string &text, const program &prog);
+     Replaces the expression of a cell, after checking the cells it uses.
+     */
+    void define(const string &name, const string &text, const program &prog) throw(invalid_argument);
+    
+public:
+    
+    /* cell_sheet();
+     Constructor for a sheet with no cells.
+     */
+    cell_sheet();
+    
+    /* void set(string name, string exp);
+     Sets the expression of a cell, adding the cell if it is new.
+        @param  string name [in]    name of the cell, a letter or underscore
+                                        followed by letters, digits or
+                                        underscores
+        @param  string exp [in]     infix expression, whose variables are the
+                                        names of other cells
+     Precondition:      none
+     Postcondition:     The cell and every cell using it will be computed
+                        again when next read. A cell exp uses that does not
+                        exist is added undefined. Throws the exception compile
+                        throws if exp is invalid, or an invalid_argument
+                        exception if name is not a valid name or the cell
+                        would use itself, directly or not; the sheet is then
+                        unchanged.
+     */
+    void set(string name, string exp) throw(invalid_argument);
+    
+    /* void set_value(string name, T value);
+     Same as above, for a cell holding a value instead of an expression.
+     */
+    void set_value(string name, T value) throw(invalid_argument);
+    
+    /* T get(string name);
+     Returns the value of a cell, computing first the cells it uses that
+     changed since they were last computed, each after the cells it uses.
+        @param  string name [in]    name of the cell
+        @return T [out]             value of the cell
+     Postcondition:     Returns the result of the cell's expression with the
+                        values of the cells it uses, else throws an
+                        invalid_argument exception: if there is no such cell,
+                        if it or a cell it uses is undefined, or divides by
+                        zero.
+     */
+    T get(string name) throw(invalid_argument);
+    
+    /* void recompute(unsigned threads=1);
+     Computes every cell that changed since it was last computed. A cell is
+     started as soon as the cells it uses are done, so cells on independent
+     branches of the graph are computed at the same time.
+        @param  unsigned threads [in]   number of worker threads, 0 for one
+                                            per core
+     Postcondition:     Every cell is up to date, so get does not compute.
+     */
+    void recompute(unsigned threads=1);
+    
+    /* bool contains(string name) const;
+     Returns true if a cell of this name has been set or used.
+     */
+    bool contains(string name) const;
+    
+    /* string expression(string name) const;
+     Returns the expression of a cell, or an empty string if it is undefined.
+     */
+    string expression(string name) const throw(invalid_argument);
+    
+    /* size_t size() const;
+     Returns the number of cells.
+     */
+    size_t size() const;
+    
+    /* size_t recomputed() const;
+     Returns the number of cells computed by the last call to get or
+     recompute.
+     */
+    size_t recomputed() const;
+    
+};
+
+// Compiled ahead of time in cell_sheet.cpp
+extern template class cell_sheet<float>;
+extern template class cell_sheet<double>;
+extern template class cell_sheet<long double>;
+
+#endif
@@ -0,0 +1,525 @@
+/*****************************************************************************
+ Title:             constexpr_calculator.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Compile Time Calculator (Header Only)
+                        - Compiles an infix expression given as a string
+                            literal while the program is being built, with the
+                            same rules as basic_calculator::compile: the same
+                            precedence, left associative '^', variables and
+                            the same errors
+                        - Evaluates an expression without variables to a
+                            constant while the program is being built
+                        - Turns an expression with variables into a function
+                            with every operation inlined, no parsing and no
+                            loop over instructions
+                    
+                    For example:
+                    
+                        constexpr double area = constexpr_evaluate<double>(
+                                                    "3.14159 * 2.5^2");
+                        
+                        CONSTEXPR_EXPRESSION(distance, double,
+                                             "((x-3)^2 + (y-4)^2)^0.5");
+                        double vars[] = { 1, 2 };
+                        double d = distance::evaluate(vars);
+                    
+                    An invalid expression does not compile; the compiler
+                    reports the exception compile would have thrown.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___constexpr_calculator__
+#define ___constexpr_calculator__
+
+#include <cstddef>
+#include <stdint.h>
+#include <limits>
+#include <stdexcept>
+#include <math.h>
+using namespace std;
+
+// A single instruction. op is the character basic_calculator's opcode uses:
+// 'c' pushes constant arg, 'v' loads variable arg, an operator character
+// applies the operator to the top two values.
+struct constexpr_instruction {
+    char op;
+    int arg;
+};
+
+/******************************************************************************
+    Character classes and operators
+    Same as the ones compile uses, usable at compile time.
+ ******************************************************************************/
+
+constexpr bool constexpr_isdigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+constexpr bool constexpr_isalpha(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+constexpr bool constexpr_is_operator(char ch) {
+    return ch == '+' || ch == '-' || ch == '/' || ch == '*' || ch == '^';
+}
+
+/* Precedence of an operator, as basic_calculator::precedence assigns it. An
+ equal precedence also emits the operator on the stack, so '^' is left
+ associative.
+ */
+constexpr int constexpr_precedence(char op) {
+    return op == '(' ? 0
+         : (op == '+' || op == '-') ? 1
+         : (op == '*' || op == '/') ? 2
+         : op == '^' ? 3
+         : throw invalid_argument("Operator character expected");
+}
+
+/* pow that can be evaluated at compile time. GCC folds its builtins with
+ correctly rounded arithmetic and calls the library's pow at run time, as
+ execute does. Other compilers can only raise to whole powers at compile time.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+constexpr float constexpr_pow(float a, float b) { return __builtin_powf(a, b); }
+constexpr double constexpr_pow(double a, double b) { return __builtin_pow(a, b); }
+constexpr long double constexpr_pow(long double a, long double b) { return __builtin_powl(a, b); }
+#else
+template <class T>
+constexpr T constexpr_pow(T a, T b) {
+    if (b != (long long)b || b > 1024 || b < -1024) {
+        throw invalid_argument("Exponent must be a whole number at compile time");
+    }
+    long long n = (long long)b;
+    bool negative = n < 0;
+    if (negative) { n = -n; }
+    
+    T result = 1;
+    while (n) {
+        if (n & 1) { result *= a; }
+        a *= a;
+        n >>= 1;
+    }
+    return negative ? 1 / result : result;
+}
+#endif
+
+/* Returns the result of operand1 op operand2, as execute does */
+template <class T>
+constexpr T constexpr_execute(char op, T operand1, T operand2) {
+    switch (op) {
+        case '+': return operand1 + operand2;
+        case '-': return operand1 - operand2;
+        case '*': return operand1 * operand2;
+        case '/':
+            // Divide by zero error
+            if (operand2 == 0) { throw invalid_argument("Attempt to divide by zero"); }
+            return operand1 / operand2;
+        case '^': return constexpr_pow(operand1, operand2);
+        default: throw invalid_argument("Operator character expected");
+    }
+}
+
+/******************************************************************************
+    Literals
+ ******************************************************************************/
+
+/* Returns 10^n, exact for n <= 22 */
+constexpr double constexpr_power_of_ten(int n) {
+    double p = 1;
+    for (int i = 0; i<n; i++) { p *= 10; }
+    return p;
+}
+
+/* Returns 10^n as a long double, exact for n <= 27 */
+constexpr long double constexpr_long_power_of_ten(int n) {
+    long double p = 1;
+    for (int i = 0; i<n; i++) { p *= 10; }
+    return p;
+}
+
+/* Converts mantissa * 10^scale to T the way scan_number's fast path does, in
+ a single correctly rounded operation, when both are exact as doubles. A long
+ double holds any mantissa and powers of ten up to 10^27 exactly, so these are
+ found with a single operation too, which is correctly rounded for long double
+ and rounded a second time for the other types. Other literals, with more
+ than 19 significant digits or a large exponent, are approximated one power
+ of ten at a time. Both may differ from scan_number in the last bit. Out of
+ range values are clamped like scan_number's.
+ */
+template <class T>
+constexpr T constexpr_convert(uint64_t mantissa, int scale, bool exact) {
+    if (exact && mantissa <= (1ULL << 53) && scale >= -22 && scale <= 22 && sizeof(T) <= sizeof(double)) {
+        double p = constexpr_power_of_ten(scale < 0 ? -scale : scale);
+        double d = scale < 0 ? (double)mantissa / p : (double)mantissa * p;
+        return d > numeric_limits<T>::max() ? numeric_limits<T>::max() : (T)d;
+    }
+    
+    long double value = (long double)mantissa;
+    if (value == 0) { return 0; }
+    if (exact && scale >= -27 && scale <= 27) {
+        long double p = constexpr_long_power_of_ten(scale < 0 ? -scale : scale);
+        value = scale < 0 ? value / p : value * p;
+        return value > numeric_limits<T>::max() ? numeric_limits<T>::max() : (T)value;
+    }
+    
+    for (; scale > 0; scale--) {
+        value *= 10;
+        if (value > numeric_limits<T>::max()) { return numeric_limits<T>::max(); }
+    }
+    for (; scale < 0 && value != 0; scale++) { value /= 10; }
+    return (T)value;
+}
+
+/******************************************************************************
+    Compiled program
+ ******************************************************************************/
+
+/* An infix expression of at most N-1 characters compiled to a postfix program,
+ like basic_calculator::compiled_expression, in fixed size arrays so it can be
+ built and run at compile time.
+ */
+template <class T, size_t N>
+struct constexpr_program {
+
+    typedef T value_type;
+    
+    constexpr_instruction code[N];
+    T constants[N];
+    int length;             // Number of instructions
+    int max_depth;          // Largest number of values on the stack
+    
+    // Names of the variables, in order of first use, as ranges of text
+    char text[N];
+    int variable_start[N];
+    int variable_length[N];
+    int variable_count;
+    
+    /* constexpr int variable_index(const char (&name)[M]) const;
+     Returns the position a variable's value must be bound at, or -1 if the
+     expression does not use it.
+     */
+    template <size_t M>
+    constexpr int variable_index(const char (&name)[M]) const {
+        for (int v = 0; v<variable_count; v++) {
+            bool same = variable_length[v] == (int)M-1;
+            for (int k = 0; same && k<variable_length[v]; k++) {
+                same = text[variable_start[v] + k] == name[k];
+            }
+            if (same) { return v; }
+        }
+        return -1;
+    }
+    
+    /* constexpr T run(const T *vars) const;
+     Runs the program with its variables bound to vars, at compile time if
+     vars are constants.
+        @param  T *vars [in]    value of each variable, in order of first use
+        @return T [out]         result of the program
+     Postcondition:     returns the result, else throws an invalid_argument
+                        exception on division by zero, which stops
+                        compilation if run at compile time.
+     */
+    constexpr T run(const T *vars) const {
+        T stack[N] = {};
+        int top = 0;
+        
+        for (int i = 0; i<length; i++) {
+            if (code[i].op == 'c') { stack[top++] = constants[code[i].arg]; }
+            else if (code[i].op == 'v') { stack[top++] = vars[code[i].arg]; }
+            else {
+                top--;
+                stack[top-1] = constexpr_execute(code[i].op, stack[top-1], stack[top]);
+            }
+        }
+        
+        return stack[0];
+    }
+    
+    /* constexpr T evaluate() const;
+     Runs a program that has no variables.
+     */
+    constexpr T evaluate() const {
+        if (variable_count > 0) { throw invalid_argument("Unbound variable"); }
+        return run(NULL);
+    }
+    
+    /* constexpr int operand_start(int end) const;
+     Returns the index of the first instruction of the operand whose last
+     instruction is end: for a value, end itself, for an operator, the first
+     instruction of its left operand.
+     */
+    constexpr int operand_start(int end) const {
+        int needed = 1;
+        int i = end;
+        for (; i >= 0; i--) {
+            needed += (code[i].op == 'c' || code[i].op == 'v') ? -1 : 1;
+            if (needed == 0) { break; }
+        }
+        return i;
+    }
+};
+
+/* Pops the top operator off ops and appends it to the program, with the
+ checks emit_operator makes.
+ */
+template <class T, size_t N>
+constexpr void constexpr_emit(constexpr_program<T, N> &prog, char *ops, int &top, int &depth) {
+
+    // If no operator to pop, throw exception
+    if (top == 0) { throw underflow_error("Trying to pop an empty stack"); }
+    
+    // Unmatched left parenthesis left on the stack, checked before the
+    // operands as compile does
+    char op = ops[top-1];
+    if (!constexpr_is_operator(op)) { throw invalid_argument("Operator character expected"); }
+    
+    // If fewer than two operands, operator underflows
+    if (depth < 2) { throw underflow_error("Trying to pop an empty stack"); }
+    top--;
+    
+    prog.code[prog.length].op = op;
+    prog.code[prog.length].arg = 0;
+    prog.length++;
+    depth--;
+}
+
+/* template <class T, size_t N>
+   constexpr constexpr_program<T, N> constexpr_compile(const char (&exp)[N]);
+ Compiles a string literal with the shunting yard algorithm of compile.
+    @param  char exp[N] [in]    string literal of an infix expression
+    @return constexpr_program [out]     compiled program
+ Precondition:      exp is a valid infix expression as compile accepts it
+ Postcondition:     returns the program compile would return for exp, else
+                    throws the exception compile would throw, which stops
+                    compilation if exp is compiled at compile time.
+ */
+template <class T, size_t N>
+constexpr constexpr_program<T, N> constexpr_compile(const char (&exp)[N]) {
+    constexpr_program<T, N> prog = {};
+    char ops[N] = {};
+    int top = 0;
+    int depth = 0;
+    const int length = (int)N - 1;
+    
+    for (int k = 0; k<length; k++) { prog.text[k] = exp[k]; }
+    
+    for (int i = 0; i<length; i++) {
+    
+        // Number: digits and decimal point, then an optional exponent
+        if (constexpr_isdigit(exp[i])) {
+            uint64_t mantissa = 0;
+            int digits = 0, scale = 0, count_decimal = 0;
+            bool exact = true;
+            
+            int j = i;
+            for (; j<length && (constexpr_isdigit(exp[j]) || exp[j] == '.'); j++) {
+                if (exp[j] == '.') {
+                    if (++count_decimal > 1) { throw invalid_argument("Too many decimal points"); }
+                }
+                else {
+                    if (mantissa != 0 || exp[j] != '0') { digits++; }
+                    if (digits <= 19) {
+                        mantissa = mantissa * 10 + (exp[j] - '0');
+                        if (count_decimal) { scale--; }
+                    }
+                    else {
+                        exact = false;
+                        if (!count_decimal) { scale++; }
+                    }
+                }
+            }
+            
+            if (j < length && (exp[j] == 'e' || exp[j] == 'E')) {
+                int k = j+1;
+                bool negative = false;
+                if (k < length && (exp[k] == '+' || exp[k] == '-')) {
+                    negative = exp[k] == '-';
+                    k++;
+                }
+                if (k < length && constexpr_isdigit(exp[k])) {
+                    int exponent = 0;
+                    for (; k<length && constexpr_isdigit(exp[k]); k++) {
+                        if (exponent < 100000) { exponent = exponent * 10 + (exp[k] - '0'); }
+                    }
+                    scale += negative ? -exponent : exponent;
+                    j = k;
+                }
+            }
+            
+            prog.constants[prog.length] = constexpr_convert<T>(mantissa, scale, exact);
+            prog.code[prog.length].op = 'c';
+            prog.code[prog.length].arg = prog.length;
+            prog.length++;
+            
+            if (++depth > prog.max_depth) { prog.max_depth = depth; }
+            i = j-1;
+        }
+        
+        // Variable: letters, digits and underscores, not starting with a digit
+        else if (constexpr_isalpha(exp[i]) || exp[i] == '_') {
+            int j = i+1;
+            while (j < length && (constexpr_isalpha(exp[j]) || constexpr_isdigit(exp[j]) || exp[j] == '_')) { j++; }
+            
+            // Variables used more than once share a single binding
+            int index = -1;
+            for (int v = 0; v<prog.variable_count && index < 0; v++) {
+                bool same = prog.variable_length[v] == j-i;
+                for (int k = 0; same && k<j-i; k++) {
+                    same = exp[prog.variable_start[v] + k] == exp[i+k];
+                }
+                if (same) { index = v; }
+            }
+            if (index < 0) {
+                index = prog.variable_count++;
+                prog.variable_start[index] = i;
+                prog.variable_length[index] = j-i;
+            }
+            
+            prog.code[prog.length].op = 'v';
+            prog.code[prog.length].arg = index;
+            prog.length++;
+            
+            if (++depth > prog.max_depth) { prog.max_depth = depth; }
+            i = j-1;
+        }
+        
+        else if (exp[i] == '(') { ops[top++] = exp[i]; }
+        
+        // Emit operators of greater or equal precedence, then push operator
+        else if (constexpr_is_operator(exp[i])) {
+            while (top > 0 && constexpr_precedence(exp[i]) <= constexpr_precedence(ops[top-1])) {
+                constexpr_emit(prog, ops, top, depth);
+            }
+            ops[top++] = exp[i];
+        }
+        
+        // Emit operators until the matching left parenthesis
+        else if (exp[i] == ')') {
+            while (top > 0 && ops[top-1] != '(') { constexpr_emit(prog, ops, top, depth); }
+            if (top == 0) { throw invalid_argument("No matching parenthesis"); }
+            top--;
+        }
+        
+        else if (exp[i] == ' ') { }
+        
+        else { throw invalid_argument("Invalid character"); }
+    }
+    
+    while (top > 0) { constexpr_emit(prog, ops, top, depth); }
+    
+    // Program must leave a single value on the stack, its result
+    if (depth != 1) { throw invalid_argument("Invalid number of operands"); }
+    
+    return prog;
+}
+
+/* template <class T, size_t N>
+   constexpr T constexpr_evaluate(const char (&exp)[N]);
+ Compiles and evaluates an expression without variables. Used to initialize a
+ constexpr variable, the whole expression becomes a constant.
+ */
+template <class T, size_t N>
+constexpr T constexpr_evaluate(const char (&exp)[N]) {
+    return constexpr_compile<T>(exp).evaluate();
+}
+
+/******************************************************************************
+    Inlined evaluation
+    Each instruction of the program of P, a type with a static constexpr
+    member program, is a type whose eval function computes the value the
+    instruction leaves on the stack. An operator's operands are found at
+    compile time, so eval is a tree of inline calls: once the compiler has
+    inlined them it is straight line code over the variables.
+ ******************************************************************************/
+
+/* Applies an operator at run time. pow and division by zero behave as in
+ execute.
+ */
+template <class T, char Op> struct inline_operator;
+
+template <class T> struct inline_operator<T, '+'> {
+    static T apply(T a, T b) { return a + b; }
+};
+template <class T> struct inline_operator<T, '-'> {
+    static T apply(T a, T b) { return a - b; }
+};
+template <class T> struct inline_operator<T, '*'> {
+    static T apply(T a, T b) { return a * b; }
+};
+template <class T> struct inline_operator<T, '/'> {
+    static T apply(T a, T b) {
+        // Divide by zero error
+        if (b == 0) { throw invalid_argument("Attempt to divide by zero"); }
+        return a / b;
+    }
+};
+template <class T> struct inline_operator<T, '^'> {
+    static T apply(T a, T b) {
+        // Called through a pointer so that a constant exponent is not turned
+        // into multiplications, which can round differently from pow
+        static T (* volatile library_pow)(T, T) = pow;
+        return library_pow(a, b);
+    }
+};
+
+/* The value of the instruction at index I: an operator applied to the values
+ of its two operands
+ */
+template <class P, int I, char Op = P::program.code[I].op>
+struct inline_node {
+    typedef typename decltype(P::program)::value_type T;
+    static const int right = I-1;
+    static const int left = P::program.operand_start(right) - 1;
+    
+    static T eval(const T *vars) {
+        return inline_operator<T, Op>::apply(inline_node<P, left>::eval(vars), inline_node<P, right>::eval(vars));
+    }
+};
+
+/* A constant */
+template <class P, int I>
+struct inline_node<P, I, 'c'> {
+    typedef typename decltype(P::program)::value_type T;
+    static constexpr T value = P::program.constants[P::program.code[I].arg];
+    
+    static T eval(const T *) { return value; }
+};
+
+/* A variable */
+template <class P, int I>
+struct inline_node<P, I, 'v'> {
+    typedef typename decltype(P::program)::value_type T;
+    static const int index = P::program.code[I].arg;
+    
+    static T eval(const T *vars) { return vars[index]; }
+};
+
+/* The whole expression of P, whose value the last instruction leaves */
+template <class P>
+struct inline_expression {
+    typedef typename decltype(P::program)::value_type T;
+    
+    static T evaluate(const T *vars) {
+        return inline_node<P, P::program.length - 1>::eval(vars);
+    }
+};
+
+/* Defines a type name holding the program of a string literal exp of values
+ of type T, with a static function evaluate(const T *vars) that evaluates it
+ inline. Variables are bound in order of first use; name::program holds them
+ and variable_index finds them. The type is a template so that program can be
+ defined in a header as well. Use at namespace scope.
+ */
+#define CONSTEXPR_EXPRESSION(name, T, exp)                                      \
+template <class Unused = void>                                                 \
+struct name##_expression {                                                     \
+    static constexpr constexpr_program<T, sizeof(exp)> program = constexpr_compile<T>(exp); \
+    static T evaluate(const T *vars) { return inline_expression<name##_expression>::evaluate(vars); } \
+};                                                                             \
+template <class Unused>                                                        \
+constexpr constexpr_program<T, sizeof(exp)> name##_expression<Unused>::program; \
+typedef name##_expression<> name
+
+#endif
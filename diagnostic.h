@@ -0,0 +1,62 @@
+/*****************************************************************************
+ Title:             diagnostic.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Evaluation Error Codes (Header File)
+                        - Kinds of error that make an expression invalid
+                        - Where in the expression each was found
+ 
+                    Returned by the calculator's functions that do not throw,
+                    so invalid expressions cost no more than valid ones. The
+                    throwing functions throw the exception each describes.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___diagnostic__
+#define ___diagnostic__
+
+#include <cstddef>
+using namespace std;
+
+// Why an expression has no value
+enum error_kind {
+    ERROR_NONE,
+    ERROR_DIVIDE_BY_ZERO,
+    ERROR_PARENTHESIS,              // ')' without '(', or '(' never closed
+    ERROR_BAD_LITERAL,              // Number with two decimal points
+    ERROR_OPERAND_UNDERFLOW,        // Operator without two operands
+    ERROR_INVALID_CHARACTER,
+    ERROR_OPERAND_COUNT,            // Operands left without an operator
+    ERROR_UNBOUND_VARIABLE,
+    ERROR_OPTIMIZER_MISMATCH,       // Optimized program disagrees, verify mode
+    ERROR_KINDS
+};
+
+// An error and where it was found. offset is the character of the
+// expression that is in error, e.g. the '/' that divides by zero or the
+// second decimal point of a number, or the length of the expression if the
+// error is only found at its end. message is the text of the exception the
+// throwing functions report, without a variable's name; it is a string
+// literal, so making a diagnostic allocates nothing.
+struct diagnostic {
+    error_kind kind;
+    size_t offset;
+    const char *message;
+};
+
+/* const char *error_name(error_kind kind);
+ Returns a short description of an error kind, e.g. "division by zero".
+ */
+inline const char *error_name(error_kind kind) {
+    static const char *names[ERROR_KINDS] = {
+        "no error", "division by zero", "mismatched parenthesis", "bad literal",
+        "operand underflow", "invalid character", "wrong number of operands",
+        "unbound variable", "optimizer mismatch"
+    };
+    return (unsigned)kind < ERROR_KINDS ? names[kind] : "unknown error";
+}
+
+#endif
@@ -0,0 +1,472 @@
+/*****************************************************************************
+ Title:             eval_server.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Evaluation Server Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "eval_server.h"
+#include "profiler.h"
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Epoll ids of the listening socket and of the wake up event; clients follow
+static const unsigned long LISTEN_ID = 0;
+static const unsigned long WAKE_ID = 1;
+
+// A client sending a longer line is closed
+static const size_t MAX_LINE = 1 << 20;
+
+// A client is not read from while this many bytes of its answers are unsent
+static const size_t MAX_OUTPUT = 4 << 20;
+
+// Number of latencies kept for the percentiles
+static const size_t LATENCY_SAMPLES = 65536;
+
+/* Creates the sockets and starts watching them. Descriptors opened before a
+ failure are closed, as the destructor will not run.
+ */
+template <class T>
+eval_server<T>::eval_server(calculator_type &calc, string address, unsigned threads, size_t batch_size) throw(invalid_argument)
+    : calc(calc), batch_size(batch_size ? batch_size : 1), listen_fd(-1), epoll_fd(-1), wake_fd(-1),
+      stopping(false), next_id(WAKE_ID + 1), queued(0), served(0), next_latency(0), pool(threads) {
+      
+    try {
+        listen_on(address);
+        
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd < 0 || wake_fd < 0) { throw invalid_argument(address + ": " + strerror(errno)); }
+        
+        watch(listen_fd, LISTEN_ID, true, false, true);
+        watch(wake_fd, WAKE_ID, true, false, true);
+    }
+    catch (...) {
+        if (listen_fd >= 0) { close(listen_fd); }
+        if (epoll_fd >= 0) { close(epoll_fd); }
+        if (wake_fd >= 0) { close(wake_fd); }
+        if (!socket_path.empty()) { unlink(socket_path.c_str()); }
+        throw;
+    }
+}
+
+/* Waits for the batches still being evaluated, as they signal wake_fd, then
+ closes everything
+ */
+template <class T>
+eval_server<T>::~eval_server() {
+    pool.wait();
+    
+    typename map<unsigned long, client>::iterator it;
+    for (it = clients.begin(); it != clients.end(); ++it) { close(it->second.fd); }
+    
+    close(listen_fd);
+    close(epoll_fd);
+    close(wake_fd);
+    if (!socket_path.empty()) { unlink(socket_path.c_str()); }
+}
+
+/* An address with a colon is host:port, where an empty host is the loopback
+ address; anything else is the path of a Unix domain socket. A socket left
+ at the path by an earlier server is replaced.
+ */
+template <class T>
+void eval_server<T>::listen_on(const string &address) throw(invalid_argument) {
+    size_t colon = address.rfind(':');
+    
+    if (colon != string::npos) {
+        string host = address.substr(0, colon);
+        if (host.empty() || host == "localhost") { host = "127.0.0.1"; }
+        
+        char *end;
+        long port = strtol(address.c_str() + colon + 1, &end, 10);
+        if (colon + 1 == address.length() || *end != '\0' || port < 0 || port > 65535) {
+            throw invalid_argument(address + ": Invalid port");
+        }
+        
+        sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons((uint16_t)port);
+        if (inet_pton(AF_INET, host.c_str(), &sa.sin_addr) != 1) {
+            throw invalid_argument(address + ": Invalid host");
+        }
+        
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0) { throw invalid_argument(address + ": " + strerror(errno)); }
+        
+        int on = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(listen_fd, (sockaddr *)&sa, sizeof(sa)) < 0) {
+            throw invalid_argument(address + ": " + strerror(errno));
+        }
+    }
+    else {
+        sockaddr_un sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        if (address.empty() || address.length() >= sizeof(sa.sun_path)) {
+            throw invalid_argument(address + ": Invalid socket path");
+        }
+        memcpy(sa.sun_path, address.c_str(), address.length());
+        
+        struct stat st;
+        if (stat(address.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) { unlink(address.c_str()); }
+        
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0) { throw invalid_argument(address + ": " + strerror(errno)); }
+        if (bind(listen_fd, (sockaddr *)&sa, sizeof(sa)) < 0) {
+            throw invalid_argument(address + ": " + strerror(errno));
+        }
+        socket_path = address;
+    }
+    
+    if (listen(listen_fd, SOMAXCONN) < 0) { throw invalid_argument(address + ": " + strerror(errno)); }
+}
+
+/* Epoll is level triggered, so a descriptor keeps being reported until it has
+ been read from or written to
+ */
+template <class T>
+void eval_server<T>::watch(int fd, unsigned long id, bool in, bool out, bool add) {
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = (in ? (uint32_t)EPOLLIN : 0u) | (out ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.u64 = id;
+    epoll_ctl(epoll_fd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev);
+}
+
+/* Accepts until there is no one left waiting */
+template <class T>
+void eval_server<T>::accept_all() {
+    while (true) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) { continue; }
+            return;
+        }
+        
+        unsigned long id = next_id++;
+        client &c = clients[id];
+        c.fd = fd;
+        c.sent = 0;
+        c.reading = true;
+        c.writing = false;
+        c.closing = false;
+        watch(fd, id, true, false, true);
+    }
+}
+
+/* Reads what has arrived and splits off each whole line. A "#stats" line is
+ answered at once; any other is queued to be evaluated. Once the client stops
+ sending, an unfinished last line counts as a line.
+ */
+template <class T>
+void eval_server<T>::receive(unsigned long id) {
+    client &c = clients[id];
+    char buf[65536];
+    
+    // Input is no longer watched once the client stops sending, so this is a
+    // hang up or an error
+    if (c.closing) {
+        disconnect(id);
+        return;
+    }
+    
+    while (true) {
+        ssize_t n = read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            CALC_PROFILE_READ(n);
+            c.input.append(buf, n);
+            if ((size_t)n < sizeof(buf)) { break; }
+        }
+        else if (n == 0) {
+            c.closing = true;
+            break;
+        }
+        else if (errno == EINTR) {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        else {
+            disconnect(id);
+            return;
+        }
+    }
+    
+    clock_type::time_point now = clock_type::now();
+    size_t start = 0;
+    while (start < c.input.length()) {
+        size_t nl = c.input.find('\n', start);
+        if (nl == string::npos && !c.closing) { break; }
+        if (nl == string::npos) { nl = c.input.length(); }
+        
+        size_t end = nl;
+        if (end > start && c.input[end-1] == '\r') { end--; }
+        
+        shared_ptr<request> r(new request);
+        r->client_id = id;
+        r->text.assign(c.input, start, end - start);
+        r->received = now;
+        r->done = r->text == "#stats";
+        if (r->done) { r->answer = stats() + "\n"; }
+        else { arrived.push_back(r); }
+        c.pending.push_back(r);
+        
+        start = nl + 1;
+    }
+    c.input.erase(0, min(start, c.input.length()));
+    
+    if (c.input.length() > MAX_LINE) {
+        disconnect(id);
+        return;
+    }
+    
+    flush(id);
+}
+
+/* Hands the requests to the workers in batches. A worker evaluates its batch
+ with its own buffers, then passes it back and wakes the event loop.
+ */
+template <class T>
+void eval_server<T>::dispatch() {
+    if (arrived.empty()) { return; }
+    queued += arrived.size();
+    
+    for (size_t i = 0; i<arrived.size(); i += batch_size) {
+        size_t end = min(i + batch_size, arrived.size());
+        shared_ptr<batch> b(new batch(arrived.begin() + i, arrived.begin() + end));
+        
+        pool.submit([this, b]() {
+            evaluate_batch(calc, *b);
+            {
+                lock_guard<mutex> lock(done_lock);
+                finished.push_back(b);
+            }
+            uint64_t one = 1;
+            if (write(wake_fd, &one, sizeof(one)) < 0) { }
+        });
+    }
+    arrived.clear();
+}
+
+/* Takes the finished batches, records how long each request took and sends
+ the answers of each client they belong to
+ */
+template <class T>
+void eval_server<T>::collect() {
+    uint64_t count;
+    if (read(wake_fd, &count, sizeof(count)) < 0) { }
+    
+    vector<shared_ptr<batch> > done;
+    {
+        lock_guard<mutex> lock(done_lock);
+        done.swap(finished);
+    }
+    
+    clock_type::time_point now = clock_type::now();
+    set<unsigned long> answered;
+    for (size_t i = 0; i<done.size(); i++) {
+        batch &b = *done[i];
+        for (size_t j = 0; j<b.size(); j++) {
+            request &r = *b[j];
+            r.done = true;
+            answered.insert(r.client_id);
+            
+            double us = chrono::duration<double, micro>(now - r.received).count();
+            if (latencies.size() < LATENCY_SAMPLES) { latencies.push_back(us); }
+            else { latencies[next_latency] = us; }
+            next_latency = (next_latency + 1) % LATENCY_SAMPLES;
+        }
+        queued -= b.size();
+        served += b.size();
+    }
+    
+    set<unsigned long>::iterator it;
+    for (it = answered.begin(); it != answered.end(); ++it) {
+        if (clients.count(*it)) { flush(*it); }
+    }
+}
+
+/* Moves the answers that are done, up to the first that is not, to the output
+ and sends as much of it as the socket takes. The rest is sent when epoll
+ reports room for it. A client with too much unsent is not read from until
+ it catches up.
+ */
+template <class T>
+void eval_server<T>::flush(unsigned long id) {
+    client &c = clients[id];
+    
+    while (!c.pending.empty() && c.pending.front()->done) {
+        c.output += c.pending.front()->answer;
+        c.pending.pop_front();
+    }
+    
+    while (c.sent < c.output.length()) {
+        ssize_t n = send(c.fd, c.output.data() + c.sent, c.output.length() - c.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            CALC_PROFILE_WRITTEN(n);
+            c.sent += n;
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        else {
+            disconnect(id);
+            return;
+        }
+    }
+    if (c.sent == c.output.length()) {
+        c.output.clear();
+        c.sent = 0;
+    }
+    
+    if (c.closing && c.pending.empty() && c.output.empty()) {
+        disconnect(id);
+        return;
+    }
+    
+    size_t unsent = c.output.length() - c.sent;
+    bool reading = !c.closing && unsent < MAX_OUTPUT;
+    bool writing = unsent > 0;
+    if (reading != c.reading || writing != c.writing) {
+        c.reading = reading;
+        c.writing = writing;
+        watch(c.fd, id, reading, writing, false);
+    }
+}
+
+/* Closes the socket and forgets the client. Requests of it still being
+ evaluated are kept alive by their batch and dropped when it comes back.
+ */
+template <class T>
+void eval_server<T>::disconnect(unsigned long id) {
+    typename map<unsigned long, client>::iterator it = clients.find(id);
+    if (it == clients.end()) { return; }
+    close(it->second.fd);
+    clients.erase(it);
+}
+
+/* Builds the JSON object of the counters */
+template <class T>
+string eval_server<T>::stats() {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\"queue_depth\":%zu,\"requests\":%zu,\"connections\":%zu,\"p50_us\":%.1f,\"p99_us\":%.1f}",
+             queued + arrived.size(), served, clients.size(), latency(50), latency(99));
+    return buf;
+}
+
+/* Evaluates through the calculator's cache, printing each result with enough
+ digits to read it back exactly. Invalid expressions are answered with the
+ message evaluate would throw, without throwing it.
+ */
+template <class T>
+void eval_server<T>::evaluate_batch(calculator_type &calc, batch &b) {
+    typename calculator_type::evaluator_context ctx;
+    char buf[64];
+    
+    for (size_t i = 0; i<b.size(); i++) {
+        request &r = *b[i];
+        T result;
+        diagnostic error;
+        if (calc.try_cached_evaluate(r.text.data(), r.text.length(), ctx, result, error)) {
+            snprintf(buf, sizeof(buf), "%.*Lg\n", numeric_limits<T>::max_digits10, (long double)result);
+            r.answer = buf;
+        }
+        else {
+            CALC_PROFILE_ERROR(error.kind);
+            r.answer = "error: " + calculator_type::error_message(error, r.text.data(), r.text.length()) + "\n";
+        }
+    }
+}
+
+/* Waits for events until stopped. Requests read in one round are dispatched
+ together, so a client that sends many lines at once has them evaluated as
+ one batch.
+ */
+template <class T>
+void eval_server<T>::run() {
+    epoll_event events[64];
+    
+    while (!stopping.load()) {
+        int n = epoll_wait(epoll_fd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        
+        for (int i = 0; i<n; i++) {
+            unsigned long id = events[i].data.u64;
+            if (id == LISTEN_ID) { accept_all(); }
+            else if (id == WAKE_ID) { collect(); }
+            else {
+                if (!clients.count(id)) { continue; }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) { receive(id); }
+                if (clients.count(id) && (events[i].events & EPOLLOUT)) { flush(id); }
+            }
+        }
+        dispatch();
+    }
+    
+    pool.wait();
+    while (!clients.empty()) { disconnect(clients.begin()->first); }
+}
+
+/* Sets the flag and wakes the event loop; both are safe in a signal handler */
+template <class T>
+void eval_server<T>::stop() {
+    stopping.store(true);
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) { }
+}
+
+/* Returns the number of requests not yet answered */
+template <class T>
+size_t eval_server<T>::queue_depth() const {
+    return queued + arrived.size();
+}
+
+/* Returns the number of requests answered */
+template <class T>
+size_t eval_server<T>::requests() const {
+    return served;
+}
+
+/* Selects the percentile from a copy of the recorded latencies */
+template <class T>
+double eval_server<T>::latency(double p) const {
+    if (latencies.empty()) { return 0; }
+    vector<double> sorted(latencies);
+    size_t rank = (size_t)(p / 100 * (sorted.size() - 1) + 0.5);
+    if (rank >= sorted.size()) { rank = sorted.size() - 1; }
+    nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+// Servers of each calculator
+template class eval_server<float>;
+template class eval_server<double>;
+template class eval_server<long double>;
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ Title:             eval_server.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Evaluation Server Class Definition (Header File)
+                        - Long running server that evaluates infix
+                            expressions sent over a Unix domain socket or a
+                            TCP port of the local machine
+                        - A single thread waits for all connections at once
+                            with epoll; expressions that arrive together are
+                            evaluated in batches by a pool of worker threads
+                        - Clients may send many expressions without waiting;
+                            the answers come back in the order they were sent
+                        - Counts requests waiting to be evaluated and the
+                            50th and 99th percentile of their latency
+ 
+                    Requests and answers are lines of text. The answer to an
+                    expression is its result, printed with enough digits to
+                    read it back exactly, or "error: " and the reason it is
+                    invalid. The line "#stats" is answered with the counters
+                    of the server as a JSON object. Linux only.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___eval_server__
+#define ___eval_server__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include "calculator.h"
+#include "thread_pool.h"
+using namespace std;
+
+template <class T>
+class eval_server {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef chrono::steady_clock clock_type;
+    
+    // An expression received and its answer, shared by the client that sent
+    // it and the batch evaluating it
+    struct request {
+        unsigned long client_id;
+        string text;
+        string answer;
+        bool done;
+        clock_type::time_point received;
+    };
+    typedef vector<shared_ptr<request> > batch;
+    
+    // A connected client. Answers are sent in the order of its requests, so
+    // an answer waits in pending until every earlier one is done.
+    struct client {
+        int fd;
+        string input;               // Received, not yet a whole line
+        deque<shared_ptr<request> > pending;
+        string output;              // Answers not yet sent
+        size_t sent;                // Bytes of output already sent
+        bool reading;               // Watched for input
+        bool writing;               // Watched for room to send
+        bool closing;               // Client has stopped sending
+    };
+    
+    calculator_type &calc;
+    size_t batch_size;
+    
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                    // Signalled when a batch is done or on stop
+    string socket_path;             // Unix socket to remove, if any
+    atomic<bool> stopping;
+    
+    map<unsigned long, client> clients;
+    unsigned long next_id;
+    batch arrived;                  // Requests not yet handed to the workers
+    
+    // Batches the workers have finished, for the event loop to answer
+    mutex done_lock;
+    vector<shared_ptr<batch> > finished;
+    
+    size_t queued;                  // Requests given to workers, not answered
+    size_t served;
+    vector<double> latencies;       // Last answered requests, in microseconds
+    size_t next_latency;
+    
+    // Declared last so it is destroyed first, finishing its tasks while the
+    // rest of the server still exists
+    thread_pool pool;
+    
+    /* void listen_on(const string &address);
+     Creates the listening socket.
+     */
+    void listen_on(const string &address) throw(invalid_argument);
+    
+    /* void watch(int fd, unsigned long id, bool in, bool out, bool add);
+     Adds a descriptor to epoll, or changes the events it is watched for.
+     */
+    void watch(int fd, unsigned long id, bool in, bool out, bool add);
+    
+    /* void accept_all();
+     Accepts every waiting client.
+     */
+    void accept_all();
+    
+    /* void receive(unsigned long id);
+     Reads from a client and turns each whole line into a request.
+     */
+    void receive(unsigned long id);
+    
+    /* void dispatch();
+     Splits the requests that arrived into batches for the workers.
+     */
+    void dispatch();
+    
+    /* void collect();
+     Marks the requests of finished batches as done and sends answers.
+     */
+    void collect();
+    
+    /* void flush(unsigned long id);
+     Sends the answers of a client that are ready, in order, and closes it
+     once it has stopped sending and has every answer.
+     */
+    void flush(unsigned long id);
+    
+    /* void disconnect(unsigned long id);
+     Closes a client, dropping its answers.
+     */
+    void disconnect(unsigned long id);
+    
+    /* string stats();
+     Returns the counters as a JSON object.
+     */
+    string stats();
+    
+    /* static void evaluate_batch(calculator_type &calc, batch &b);
+     Evaluates each request of a batch and writes its answer.
+     */
+    static void evaluate_batch(calculator_type &calc, batch &b);
+    
+    // A server cannot be copied
+    eval_server(const eval_server &);
+    eval_server &operator = (const eval_server &);
+    
+public:
+
+/******************************************************************************
+    Constructors
+ ******************************************************************************/
+    
+    /* eval_server(basic_calculator<T> &calc, string address,
+                   unsigned threads=0, size_t batch_size=256);
+     Constructor that starts listening for clients.
+        @param  basic_calculator<T> &calc [in]  calculator to evaluate with,
+                                                    whose cache and optimizer
+                                                    are used
+        @param  string address [in]             path of a Unix domain socket
+                                                    to create, or host:port
+                                                    of a local TCP port, e.g.
+                                                    127.0.0.1:7070 or :7070
+        @param  unsigned threads [in]           number of worker threads, 0
+                                                    for one per core
+        @param  size_t batch_size [in]          most requests in a batch
+     Precondition:      calc exists as long as this object, batch_size > 0
+     Postcondition:     Clients can connect, else an invalid_argument
+                        exception holding the reason is thrown. Nothing is
+                        answered until run is called.
+     */
+    eval_server(calculator_type &calc, string address, unsigned threads=0, size_t batch_size=256) throw(invalid_argument);
+    
+    /* ~eval_server();
+     Destructor that closes every client and the socket.
+     */
+    ~eval_server();
+    
+/******************************************************************************
+    Accessors
+ ******************************************************************************/
+    
+    /* void run();
+     Answers clients until stop is called.
+     Postcondition:     Every client has been closed.
+     */
+    void run();
+    
+    /* void stop();
+     Makes run return. Safe to call from another thread or a signal handler.
+     */
+    void stop();
+    
+    /* size_t queue_depth() const;
+       size_t requests() const;
+     Return the number of requests being evaluated and the number answered.
+     */
+    size_t queue_depth() const;
+    size_t requests() const;
+    
+    /* double latency(double p) const;
+     Returns the p-th percentile, in microseconds, of the time from receiving
+     each of the last requests to having its answer ready to send.
+     */
+    double latency(double p) const;
+    
+};
+
+// Compiled ahead of time in eval_server.cpp
+extern template class eval_server<float>;
+extern template class eval_server<double>;
+extern template class eval_server<long double>;
+
+#endif
@@ -0,0 +1,185 @@
+/*****************************************************************************
+ Title:             expression_store.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Expression Store Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "expression_store.h"
+#include <cstring>
+
+/* Empty store with a small index */
+template <class T>
+expression_store<T>::expression_store() : slots(16, 0) { }
+
+/* FNV-1a */
+template <class T>
+uint32_t expression_store<T>::hash(const char *s, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i<length; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Probes linearly from the slot the hash points to. Texts are compared only
+ when their hashes are equal.
+ */
+template <class T>
+size_t expression_store<T>::slot_of(const char *s, size_t length, uint32_t hash, const text_space &space) const {
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    while (slots[i] != 0) {
+        const text_entry &e = texts[slots[i] - 1];
+        if (e.hash == hash && e.length == length && memcmp(space.at(e.offset), s, length) == 0) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Rebuilds the index at twice the size from the stored hashes */
+template <class T>
+void expression_store<T>::grow_index() {
+    vector<uint32_t> bigger(slots.size() * 2, 0);
+    size_t mask = bigger.size() - 1;
+    for (size_t id = 0; id<texts.size(); id++) {
+        if (texts[id].offset == NO_TEXT) { continue; }
+        size_t i = texts[id].hash & mask;
+        while (bigger[i] != 0) { i = (i + 1) & mask; }
+        bigger[i] = (uint32_t)id + 1;
+    }
+    slots.swap(bigger);
+}
+
+/* Probes from the slot the hash points to for the one holding id, empties it
+ and moves each text after it in the run back into the hole, unless the slot
+ its hash points to lies between the hole and where it is.
+ */
+template <class T>
+void expression_store<T>::drop(uint32_t id) {
+    size_t mask = slots.size() - 1;
+    size_t hole = texts[id].hash & mask;
+    while (slots[hole] != id + 1) { hole = (hole + 1) & mask; }
+    slots[hole] = 0;
+    
+    for (size_t i = (hole + 1) & mask; slots[i] != 0; i = (i + 1) & mask) {
+        size_t home = texts[slots[i] - 1].hash & mask;
+        bool stays = hole < i ? (home > hole && home <= i) : (home > hole || home <= i);
+        if (!stays) {
+            slots[hole] = slots[i];
+            slots[i] = 0;
+            hole = i;
+        }
+    }
+    
+    texts[id].offset = NO_TEXT;
+    free_ids.push_back(id);
+}
+
+/* Finds the text, or adds it, under the id of a dropped text if there is one,
+ and grows the index once it is half full
+ */
+template <class T>
+uint32_t expression_store<T>::intern(const char *s, size_t length, uint32_t hash, size_t offset, const text_space &space) throw(length_error) {
+    size_t i = slot_of(s, length, hash, space);
+    if (slots[i] != 0) { return slots[i] - 1; }
+    
+    if (length > UINT32_MAX) { throw length_error("Expression too long to store"); }
+    if (free_ids.empty() && texts.size() >= UINT32_MAX - 1) { throw length_error("Too many distinct expressions"); }
+    
+    text_entry e;
+    e.offset = offset;
+    e.length = (uint32_t)length;
+    e.hash = hash;
+    
+    uint32_t id;
+    if (free_ids.empty()) {
+        id = (uint32_t)texts.size();
+        texts.push_back(e);
+        uses.push_back(0);
+    }
+    else {
+        id = free_ids.back();
+        free_ids.pop_back();
+        texts[id] = e;
+    }
+    slots[i] = id + 1;
+    
+    if (texts.size() * 2 > slots.size()) { grow_index(); }
+    return id;
+}
+
+/* Looks the text up without adding it */
+template <class T>
+bool expression_store<T>::find(const char *s, size_t length, uint32_t hash, const text_space &space, uint32_t &id) const {
+    size_t i = slot_of(s, length, hash, space);
+    if (slots[i] == 0) { return false; }
+    id = slots[i] - 1;
+    return true;
+}
+
+/* Appends an expression */
+template <class T>
+void expression_store<T>::push_back(uint32_t id, T result) {
+    ids.push_back(id);
+    results.push_back(result);
+    uses[id]++;
+}
+
+/* Replaces an expression, counting the use of its new text before dropping
+ the old one, which may be the same
+ */
+template <class T>
+bool expression_store<T>::set(size_t i, uint32_t id, T result) {
+    uint32_t old = ids[i];
+    ids[i] = id;
+    results[i] = result;
+    uses[id]++;
+    
+    if (--uses[old] != 0) { return false; }
+    drop(old);
+    return true;
+}
+
+/* Reserves room in both columns */
+template <class T>
+void expression_store<T>::reserve(size_t count) {
+    ids.reserve(count);
+    results.reserve(count);
+}
+
+/* Return the number of expressions and of texts */
+template <class T>
+size_t expression_store<T>::size() const {
+    return ids.size();
+}
+
+template <class T>
+size_t expression_store<T>::distinct() const {
+    return texts.size() - free_ids.size();
+}
+
+/* Moves a text, which keeps its length and hash */
+template <class T>
+void expression_store<T>::move_text(uint32_t id, size_t offset) {
+    texts[id].offset = offset;
+}
+
+/* Adds up the capacity of every vector */
+template <class T>
+size_t expression_store<T>::memory() const {
+    return results.capacity() * sizeof(T) + ids.capacity() * sizeof(uint32_t)
+        + texts.capacity() * sizeof(text_entry) + slots.capacity() * sizeof(uint32_t)
+        + uses.capacity() * sizeof(uint32_t) + free_ids.capacity() * sizeof(uint32_t);
+}
+
+// Stores of each calculator
+template class expression_store<float>;
+template class expression_store<double>;
+template class expression_store<long double>;
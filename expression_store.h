@@ -0,0 +1,197 @@
+/*****************************************************************************
+ Title:             expression_store.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Expression Store Class Definition (Header File)
+                        - Keeps the evaluated expressions of a calculator as
+                            columns: a contiguous array of results and a
+                            32-bit text id for each expression
+                        - Interns the text of expressions: each distinct text
+                            is kept once, as a range of the calculator's text,
+                            and found again through a hash index, so repeated
+                            lines share a single entry
+                        - Counts the expressions using each text, and drops a
+                            text once none does, so its id is used again and
+                            the calculator can reuse its range
+ 
+                    A scan of every result only reads the results array, and
+                    each expression costs its result and 4 bytes of id, plus
+                    20 bytes and a slot of the index for each distinct text.
+                    Text is never copied: a range may be in a memory mapped
+                    file.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___expression_store__
+#define ___expression_store__
+
+#include <vector>
+#include <stdint.h>
+#include <stdexcept>
+using namespace std;
+
+// Where the calculator's text is: offsets below mapped_size are in the mapped
+// input file, the rest in the text the calculator owns
+struct text_space {
+    const char *mapped;
+    size_t mapped_size;
+    const char *own;
+    
+    /* const char *at(size_t offset) const;
+     Returns a pointer to the character at offset.
+     */
+    const char *at(size_t offset) const {
+        return offset < mapped_size ? mapped + offset : own + (offset - mapped_size);
+    }
+};
+
+template <class T>
+class expression_store {
+    
+    // A distinct text, and its hash to rebuild the index without reading it
+    struct text_entry {
+        size_t offset;
+        uint32_t length;
+        uint32_t hash;
+    };
+    
+    vector<T> results;
+    vector<uint32_t> ids;           // Text of each expression
+    vector<text_entry> texts;
+    vector<uint32_t> uses;          // Expressions using each text
+    vector<uint32_t> free_ids;      // Ids of dropped texts, to use again
+    
+    // Open addressing index of texts by hash: id + 1 of the text in each
+    // slot, or 0 if empty. Its size is a power of 2, at least twice the
+    // number of texts.
+    vector<uint32_t> slots;
+    
+    /* void grow_index();
+     Doubles the index and puts every text back in it.
+     */
+    void grow_index();
+    
+    /* size_t slot_of(const char *s, size_t length, uint32_t hash,
+                      const text_space &space) const;
+     Returns the slot holding the text equal to s, or the empty slot it would
+     go in.
+     */
+    size_t slot_of(const char *s, size_t length, uint32_t hash, const text_space &space) const;
+    
+    /* void drop(uint32_t id);
+     Takes a text no expression uses out of the index, and frees its id.
+     */
+    void drop(uint32_t id);
+    
+public:
+    
+    // Offset of a dropped text
+    static const size_t NO_TEXT = (size_t)-1;
+    
+    /* expression_store();
+     Constructor for an empty store.
+     */
+    expression_store();
+    
+    /* static uint32_t hash(const char *s, size_t length);
+     Returns the hash of a text, the same for equal texts wherever they are.
+     */
+    static uint32_t hash(const char *s, size_t length);
+    
+    /* uint32_t intern(const char *s, size_t length, uint32_t hash,
+                       size_t offset, const text_space &space);
+     Returns the id of the text equal to s. If there is none, the range of
+     the calculator's text at offset, which holds s, is added as a new one.
+        @param  char *s [in]            text of the expression
+        @param  size_t length [in]      number of characters of s
+        @param  uint32_t hash [in]      hash(s, length)
+        @param  size_t offset [in]      offset of s in the calculator's text,
+                                            or of where it will be appended
+        @param  text_space &space [in]  where the text of every id is
+        @return uint32_t [out]          id of the text
+     Postcondition:     Throws a length_error exception if s is 4 GB or more,
+                        or if there are already 2^32 - 1 texts.
+     */
+    uint32_t intern(const char *s, size_t length, uint32_t hash, size_t offset, const text_space &space) throw(length_error);
+    
+    /* bool find(const char *s, size_t length, uint32_t hash,
+                 const text_space &space, uint32_t &id) const;
+     Looks up the id of the text equal to s, without adding it.
+        @return bool [out]      false if there is no such text
+     */
+    bool find(const char *s, size_t length, uint32_t hash, const text_space &space, uint32_t &id) const;
+    
+    /* void push_back(uint32_t id, T result);
+     Appends an expression with the text of id and its result.
+     Precondition:      id was returned by intern
+     */
+    void push_back(uint32_t id, T result);
+    
+    /* bool set(size_t i, uint32_t id, T result);
+     Replaces the (i)th expression with the text of id and its result.
+        @return bool [out]      true if no expression uses the text replaced
+                                    any more, which is then dropped: its range
+                                    of the calculator's text is free
+     Precondition:      id was returned by intern, i < size()
+     */
+    bool set(size_t i, uint32_t id, T result);
+    
+    /* void reserve(size_t count);
+     Makes room for count expressions.
+     */
+    void reserve(size_t count);
+    
+    /* size_t size() const;
+       size_t distinct() const;
+     Return the number of expressions and of distinct texts.
+     */
+    size_t size() const;
+    size_t distinct() const;
+    
+    /* size_t text_ids() const;
+       size_t text_offset(uint32_t id) const;
+       size_t text_length(uint32_t id) const;
+     Return the number of text ids, in use or not, and the range of the
+     calculator's text of id, whose offset is NO_TEXT if it was dropped.
+     */
+    size_t text_ids() const { return texts.size(); }
+    size_t text_offset(uint32_t id) const { return texts[id].offset; }
+    size_t text_length(uint32_t id) const { return texts[id].length; }
+    
+    /* void move_text(uint32_t id, size_t offset);
+     Points id at an equal copy of its text at offset of the calculator's
+     text, once the calculator has moved it there.
+     */
+    void move_text(uint32_t id, size_t offset);
+    
+    /* T result(size_t i) const;
+       const T *result_data() const;
+     Return the result of the (i)th expression, and the array of all results
+     in order, size() of them.
+     */
+    T result(size_t i) const { return results[i]; }
+    const T *result_data() const { return results.empty() ? NULL : &results[0]; }
+    
+    /* size_t offset(size_t i) const;
+       size_t length(size_t i) const;
+     Return the range of the calculator's text the (i)th expression is.
+     */
+    size_t offset(size_t i) const { return texts[ids[i]].offset; }
+    size_t length(size_t i) const { return texts[ids[i]].length; }
+    
+    /* size_t memory() const;
+     Returns the bytes of memory the store uses, not counting the text.
+     */
+    size_t memory() const;
+    
+};
+
+// Compiled ahead of time in expression_store.cpp
+extern template class expression_store<float>;
+extern template class expression_store<double>;
+extern template class expression_store<long double>;
+
+#endif
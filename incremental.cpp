@@ -0,0 +1,505 @@
+/*****************************************************************************
+ Title:             incremental.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Incremental Expression Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "incremental.h"
+#include "literal.h"
+#include <ctype.h>
+
+/* Parses an expression given as text */
+template <class T>
+incremental_expression<T>::incremental_expression(calculator_type &calc, string exp)
+    : calc(calc), exp_id(-1), exp(exp), root(-1), unused(0), variable_nodes(0),
+      reparsed_count(0), recomputed_count(0) {
+    parse();
+}
+
+/* Parses an expression stored in the calculator */
+template <class T>
+incremental_expression<T>::incremental_expression(calculator_type &calc, int exp_id)
+    : calc(calc), exp_id(exp_id), exp(calc.get_expression(exp_id)), root(-1), unused(0),
+      variable_nodes(0), reparsed_count(0), recomputed_count(0) {
+    parse();
+}
+
+/* Returns the index of a variable, adding an unbound one if it is new */
+template <class T>
+int incremental_expression<T>::variable(const string &name) {
+    map<string, int>::iterator it = variable_ids.find(name);
+    if (it != variable_ids.end()) { return it->second; }
+    
+    int id = (int)names.size();
+    variable_ids[name] = id;
+    names.push_back(name);
+    bindings.push_back(T(0));
+    bound.push_back(false);
+    return id;
+}
+
+/* Pops an operator and its two operands and pushes the node applying it. As
+ values are popped, the fewest left before the innermost left parenthesis is
+ tracked, to tell whether its contents only use their own values.
+ */
+template <class T>
+void incremental_expression<T>::emit_operator() throw(underflow_error, invalid_argument) {
+    
+    // If no operator to pop, throw exception
+    if (operators.empty()) { throw underflow_error("Trying to pop an empty stack"); }
+    
+    // Unmatched left parenthesis left on the stack, checked before the
+    // operands as compile does
+    char op = operators.back();
+    if (!calc.is_operator(op)) {
+        throw invalid_argument("Operator character expected");
+    }
+    
+    // If fewer than two operands, operator underflows
+    if (values.size() < 2) { throw underflow_error("Trying to pop an empty stack"); }
+    operators.pop_back();
+    
+    node n;
+    n.op = op;
+    n.right = values.back();
+    values.pop_back();
+    n.left = values.back();
+    n.parent = -1;
+    n.arg = 0;
+    n.begin = n.end = 0;
+    n.value = 0;
+    n.failed = 0;
+    n.dirty = true;
+    
+    int index = (int)nodes.size();
+    nodes.push_back(n);
+    nodes[n.left].parent = index;
+    nodes[n.right].parent = index;
+    values.back() = index;
+    
+    if (!open_groups.empty() && values.size() < open_groups.back().low) {
+        open_groups.back().low = values.size();
+    }
+}
+
+/* Parses the text the way compile_into does, making a node where it would
+ append an instruction. A left parenthesis whose contents leave exactly one
+ more value, and never use a value from before it, encloses a whole subtree.
+ */
+template <class T>
+int incremental_expression<T>::build(size_t begin, size_t end) {
+    values.clear();
+    operators.clear();
+    open_groups.clear();
+    
+    for (size_t i = begin; i<end; i++) {
+        
+        // A number or a variable is a leaf
+        if (isdigit(exp[i]) || isalpha(exp[i]) || exp[i] == '_') {
+            node n;
+            n.left = n.right = n.parent = -1;
+            n.arg = 0;
+            n.value = 0;
+            n.failed = 0;
+            n.begin = i;
+            
+            if (isdigit(exp[i])) {
+                n.op = 'c';
+                n.end = i + scan_number(exp.data() + i, end - i, n.value);
+                n.dirty = false;
+            }
+            else {
+                size_t j = i+1;
+                while (j < end && (isalnum(exp[j]) || exp[j] == '_')) { j++; }
+                n.op = 'v';
+                n.arg = variable(exp.substr(i, j-i));
+                n.end = j;
+                n.dirty = true;
+                variable_nodes++;
+            }
+            
+            values.push_back((int)nodes.size());
+            nodes.push_back(n);
+            
+            // Increment i so next iteration checks next character after leaf
+            i = n.end - 1;
+        }
+        
+        else if (exp[i] == '(') {
+            operators.push_back('(');
+            open_group g;
+            g.open = i;
+            g.base = values.size();
+            g.low = values.size() + 1;
+            open_groups.push_back(g);
+        }
+        
+        // Emit operations with greater or equal precedence, then push
+        // operator onto stack
+        else if (calc.is_operator(exp[i])) {
+            while (!operators.empty() && calc.precedence(exp[i]) <= calc.precedence(operators.back())) {
+                emit_operator();
+            }
+            operators.push_back(exp[i]);
+        }
+        
+        // Emit operations until matching left parenthesis is reached
+        else if (exp[i] == ')') {
+            while (!operators.empty() && operators.back() != '(') {
+                emit_operator();
+            }
+            if (operators.empty()) { throw invalid_argument("No matching parenthesis"); }
+            operators.pop_back();
+            
+            open_group g = open_groups.back();
+            open_groups.pop_back();
+            if (values.size() == g.base + 1 && g.low > g.base) {
+                group gr;
+                gr.open = g.open;
+                gr.close = i;
+                gr.node = values.back();
+                groups.push_back(gr);
+            }
+            if (!open_groups.empty() && g.low < open_groups.back().low) {
+                open_groups.back().low = g.low;
+            }
+        }
+        
+        // White space is a valid character, but does nothing
+        else if (exp[i] == ' ') { }
+        
+        else {
+            throw invalid_argument("Invalid character");
+        }
+    }
+    
+    // Emit remaining operators
+    while (!operators.empty()) {
+        emit_operator();
+    }
+    
+    // Text must leave a single value, its result
+    if (values.size() != 1) { throw invalid_argument("Invalid number of operands"); }
+    return values.back();
+}
+
+/* Throws away the tree and parses the whole text. If it is not valid, the
+ exception is kept for value to throw.
+ */
+template <class T>
+void incremental_expression<T>::parse() {
+    nodes.clear();
+    groups.clear();
+    unused = 0;
+    variable_nodes = 0;
+    reparsed_count = exp.length();
+    
+    try {
+        root = build(0, exp.length());
+        error = exception_ptr();
+    }
+    catch (...) {
+        root = -1;
+        error = current_exception();
+        nodes.clear();
+        groups.clear();
+        variable_nodes = 0;
+    }
+}
+
+/* A number or variable is parsed again by itself if the characters on either
+ side of it cannot be part of it, so that it is read the same way in the whole
+ text, and it is still a single number or variable.
+ */
+template <class T>
+bool incremental_expression<T>::parse_token(size_t offset, size_t erased, size_t inserted) {
+    int leaf = -1;
+    for (size_t n = 0; n<nodes.size(); n++) {
+        if ((nodes[n].op == 'c' || nodes[n].op == 'v')
+            && nodes[n].begin <= offset && offset + erased <= nodes[n].end) {
+            leaf = (int)n;
+            break;
+        }
+    }
+    if (leaf < 0) { return false; }
+    
+    size_t begin = nodes[leaf].begin;
+    size_t end = nodes[leaf].end - erased + inserted;
+    if (end == begin) { return false; }
+    
+    // A digit, letter, underscore or decimal point next to it would join it,
+    // as would an exponent sign after a number ending in 'e'
+    if (begin > 0) {
+        char before = exp[begin-1];
+        if (isalnum(before) || before == '_' || before == '.') { return false; }
+        if ((before == '+' || before == '-') && begin > 1 && (exp[begin-2] == 'e' || exp[begin-2] == 'E')) {
+            return false;
+        }
+    }
+    if (end < exp.length()) {
+        char after = exp[end];
+        if (isalnum(after) || after == '_' || after == '.') { return false; }
+    }
+    
+    shift(offset + erased, erased, inserted);
+    
+    size_t first = nodes.size();
+    int parsed = build(begin, end);
+    if (parsed != (int)first || nodes.size() != first + 1 || nodes[first].end != end) {
+        // No longer a single number or variable
+        parse();
+        return true;
+    }
+    
+    // Put the new leaf in place of the old one
+    node n = nodes[first];
+    nodes.pop_back();
+    if (nodes[leaf].op == 'v') { variable_nodes--; }
+    n.parent = nodes[leaf].parent;
+    nodes[leaf] = n;
+    invalidate(leaf);
+    
+    reparsed_count = end - begin;
+    return true;
+}
+
+/* The contents of a group are parsed again by themselves if the edit is
+ between its parentheses. The parentheses keep the operators inside from
+ reaching outside, so if the contents are a valid expression by themselves,
+ they are a whole subtree in the whole text too.
+ */
+template <class T>
+bool incremental_expression<T>::parse_group(size_t offset, size_t erased, size_t inserted) {
+    int inner = -1;
+    for (size_t g = 0; g<groups.size(); g++) {
+        if (groups[g].open < offset && offset + erased <= groups[g].close
+            && (inner < 0 || groups[g].open > groups[inner].open)) {
+            inner = (int)g;
+        }
+    }
+    if (inner < 0) { return false; }
+    
+    size_t open = groups[inner].open;
+    size_t close = groups[inner].close;
+    int old = groups[inner].node;
+    
+    // Forget the groups inside and the old subtree
+    size_t kept = 0;
+    for (size_t g = 0; g<groups.size(); g++) {
+        if (!(groups[g].open > open && groups[g].close < close)) { groups[kept++] = groups[g]; }
+    }
+    groups.resize(kept);
+    release(old);
+    
+    shift(offset + erased, erased, inserted);
+    close = close - erased + inserted;
+    
+    int parsed = build(open + 1, close);
+    
+    // Replace the old subtree by the new one
+    int parent = nodes[old].parent;
+    nodes[parsed].parent = parent;
+    if (parent >= 0) {
+        if (nodes[parent].left == old) { nodes[parent].left = parsed; }
+        else { nodes[parent].right = parsed; }
+    }
+    if (root == old) { root = parsed; }
+    for (size_t g = 0; g<groups.size(); g++) {
+        if (groups[g].node == old) { groups[g].node = parsed; }
+    }
+    invalidate(parsed);
+    
+    reparsed_count = close - open - 1;
+    return true;
+}
+
+/* Adds inserted and takes away erased from each position at or after from */
+template <class T>
+void incremental_expression<T>::shift(size_t from, size_t erased, size_t inserted) {
+    for (size_t n = 0; n<nodes.size(); n++) {
+        if ((nodes[n].op == 'c' || nodes[n].op == 'v') && nodes[n].begin >= from) {
+            nodes[n].begin = nodes[n].begin - erased + inserted;
+            nodes[n].end = nodes[n].end - erased + inserted;
+        }
+    }
+    for (size_t g = 0; g<groups.size(); g++) {
+        if (groups[g].open >= from) { groups[g].open = groups[g].open - erased + inserted; }
+        if (groups[g].close >= from) { groups[g].close = groups[g].close - erased + inserted; }
+    }
+}
+
+/* Marks each node of the subtree unused */
+template <class T>
+void incremental_expression<T>::release(int n) {
+    pending.clear();
+    pending.push_back(n);
+    while (!pending.empty()) {
+        node &nd = nodes[pending.back()];
+        pending.pop_back();
+        if (nd.op == 'v') { variable_nodes--; }
+        if (nd.left >= 0) {
+            pending.push_back(nd.left);
+            pending.push_back(nd.right);
+        }
+        nd.op = 0;
+        unused++;
+    }
+}
+
+/* Marks the path up to the root, stopping at a node that is already marked,
+ whose path is marked too
+ */
+template <class T>
+void incremental_expression<T>::invalidate(int n) {
+    if (nodes[n].op == 'v') { nodes[n].dirty = true; }
+    for (n = nodes[n].parent; n >= 0 && !nodes[n].dirty; n = nodes[n].parent) {
+        nodes[n].dirty = true;
+    }
+}
+
+/* Walks down from the root into marked nodes only, computing each one after
+ its operands
+ */
+template <class T>
+void incremental_expression<T>::recompute() {
+    recomputed_count = 0;
+    pending.clear();
+    pending.push_back(root);
+    
+    while (!pending.empty()) {
+        node &nd = nodes[pending.back()];
+        if (!nd.dirty) {
+            pending.pop_back();
+            continue;
+        }
+        
+        if (nd.op == 'v') {
+            nd.value = bindings[nd.arg];
+            nd.failed = bound[nd.arg] ? 0 : UNBOUND;
+        }
+        else {
+            const node &a = nodes[nd.left];
+            const node &b = nodes[nd.right];
+            if (a.dirty || b.dirty) {
+                if (a.dirty) { pending.push_back(nd.left); }
+                if (b.dirty) { pending.push_back(nd.right); }
+                continue;
+            }
+            
+            nd.failed = a.failed > b.failed ? a.failed : b.failed;
+            if (!nd.failed && nd.op == '/' && b.value == 0) { nd.failed = NO_VALUE; }
+            if (!nd.failed) { nd.value = calculator_type::execute(nd.op, a.value, b.value); }
+        }
+        
+        nd.dirty = false;
+        pending.pop_back();
+        recomputed_count++;
+    }
+}
+
+/* Replaces the calculator's expression if this one is valid and has a value
+ without variables, as add_new would only store such an expression
+ */
+template <class T>
+void incremental_expression<T>::update_calculator() {
+    if (exp_id < 0 || root < 0 || variable_nodes > 0) { return; }
+    
+    recompute();
+    if (nodes[root].failed) { return; }
+    calc.store(exp_id, exp.data(), exp.length(), nodes[root].value);
+}
+
+/* Edits the text, then parses again the smallest part of it that is enough.
+ Once more nodes are unused than used, everything is parsed again, which also
+ frees them.
+ */
+template <class T>
+void incremental_expression<T>::edit(size_t offset, size_t erase, string insert) throw(out_of_range) {
+    if (offset > exp.length()) { throw out_of_range("Edit past the end of the expression"); }
+    if (erase > exp.length() - offset) { erase = exp.length() - offset; }
+    
+    exp.replace(offset, erase, insert);
+    
+    bool done = false;
+    if (root >= 0 && unused <= nodes.size() / 2) {
+        try {
+            done = parse_token(offset, erase, insert.length())
+                || parse_group(offset, erase, insert.length());
+        }
+        catch (...) {
+            // Not valid by itself: only the whole text tells why, or whether
+            // it is valid after all
+            done = false;
+        }
+    }
+    if (!done) { parse(); }
+    
+    update_calculator();
+}
+
+/* Binds a variable and marks each use of it */
+template <class T>
+void incremental_expression<T>::bind(string name, T value) {
+    int id = variable(name);
+    bindings[id] = value;
+    bound[id] = true;
+    
+    for (size_t n = 0; n<nodes.size(); n++) {
+        if (nodes[n].op == 'v' && nodes[n].arg == id) { invalidate((int)n); }
+    }
+}
+
+/* Returns the value of the root, or throws why there is none. The unbound
+ variable reported is the first one in the text.
+ */
+template <class T>
+T incremental_expression<T>::value() {
+    if (root < 0) { rethrow_exception(error); }
+    
+    recompute();
+    const node &r = nodes[root];
+    if (r.failed == UNBOUND) {
+        int first = -1;
+        for (size_t n = 0; n<nodes.size(); n++) {
+            if (nodes[n].op == 'v' && !bound[nodes[n].arg]
+                && (first < 0 || nodes[n].begin < nodes[first].begin)) {
+                first = (int)n;
+            }
+        }
+        throw invalid_argument("Unbound variable " + names[nodes[first].arg]);
+    }
+    if (r.failed) { throw invalid_argument("Attempt to divide by zero"); }
+    return r.value;
+}
+
+/* Returns true if the text parsed */
+template <class T>
+bool incremental_expression<T>::valid() const {
+    return root >= 0;
+}
+
+/* Returns the text */
+template <class T>
+const string &incremental_expression<T>::text() const {
+    return exp;
+}
+
+/* Return the counters of the last edit and the last evaluation */
+template <class T>
+size_t incremental_expression<T>::reparsed() const {
+    return reparsed_count;
+}
+
+template <class T>
+size_t incremental_expression<T>::recomputed() const {
+    return recomputed_count;
+}
+
+// Incremental expressions of each calculator
+template class incremental_expression<float>;
+template class incremental_expression<double>;
+template class incremental_expression<long double>;
@@ -0,0 +1,246 @@
+/*****************************************************************************
+ Title:             incremental.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Incremental Expression Class Definition (Header File)
+                        - Keeps the parse tree of an infix expression, with
+                            the span of text of each number and variable and
+                            the value of each subtree
+                        - After an edit to the text, parses again only the
+                            number, variable or parenthesized group that was
+                            edited, and recomputes only the subtrees on the
+                            path from it to the root
+                        - Optionally keeps an expression stored in a
+                            calculator up to date as it is edited
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___incremental__
+#define ___incremental__
+
+#include <vector>
+#include <map>
+#include <exception>
+#include <stdexcept>
+#include "calculator.h"
+using namespace std;
+
+/* An infix expression that is edited a little at a time, e.g. as it is typed,
+ and evaluated after each edit. Its results and errors are the same as those
+ of basic_calculator::evaluate on its text. Not safe to use from many threads
+ at once.
+ */
+template <class T>
+class incremental_expression {
+    
+    typedef basic_calculator<T> calculator_type;
+    
+    // A subtree: a constant, a variable, or an operator applied to two other
+    // nodes. Nodes of subtrees that were parsed again are left unused.
+    struct node {
+        char op;                // 'c', 'v', an operator, or 0 if unused
+        int left, right;        // Index of each operand node, or -1
+        int parent;             // Index of the node using this one, or -1
+        int arg;                // Index of the variable
+        size_t begin, end;      // Text of a constant or variable
+        T value;
+        char failed;            // 0, or NO_VALUE or UNBOUND as below
+        bool dirty;             // value must be computed again
+    };
+    
+    // Why a node has no value. An unbound variable is reported before a
+    // division by zero, as run does.
+    enum { NO_VALUE = 1, UNBOUND = 2 };
+    
+    // Parentheses whose contents are a whole subtree on their own, so the
+    // contents can be parsed again by themselves
+    struct group {
+        size_t open, close;     // Position of each parenthesis
+        int node;
+    };
+    
+    // A left parenthesis while parsing: the values before it, and the fewest
+    // there have been since
+    struct open_group {
+        size_t open;
+        size_t base;
+        size_t low;
+    };
+    
+    calculator_type &calc;
+    int exp_id;                 // Expression of calc kept up to date, or -1
+    
+    string exp;
+    vector<node> nodes;
+    vector<group> groups;
+    int root;                   // -1 if the text is not a valid expression
+    exception_ptr error;        // Why it is not valid
+    size_t unused;              // Nodes left unused
+    size_t variable_nodes;      // Variables in the tree
+    
+    // Variables by name, and the value bound to each
+    map<string, int> variable_ids;
+    vector<string> names;
+    vector<T> bindings;
+    vector<bool> bound;
+    
+    // Buffers for parsing
+    vector<int> values;
+    vector<char> operators;
+    vector<open_group> open_groups;
+    vector<int> pending;
+    
+    size_t reparsed_count;
+    size_t recomputed_count;
+    
+    /* int build(size_t begin, size_t end);
+     Parses the text from begin to end into new nodes, exactly as compile
+     would parse it by itself, and records its groups.
+        @return int [out]   node of the whole text
+     Postcondition:     Throws the exception compile would throw if the text
+                        is not a valid expression.
+     */
+    int build(size_t begin, size_t end);
+    
+    /* void emit_operator();
+     Pops the top operator and makes a node of it and the top two values, as
+     basic_calculator::emit_operator does.
+     */
+    void emit_operator() throw(underflow_error, invalid_argument);
+    
+    /* int variable(const string &name);
+     Returns the index of a variable, adding it if it is new.
+     */
+    int variable(const string &name);
+    
+    /* void parse();
+     Parses the whole text again.
+     */
+    void parse();
+    
+    /* bool parse_token(size_t offset, size_t erased, size_t inserted);
+       bool parse_group(size_t offset, size_t erased, size_t inserted);
+     Parse again only the number or variable, or the contents of the
+     innermost group, that an edit of the text fell in, if that gives the
+     same tree as parsing the whole text would.
+        @return bool [out]  false if the edit was not made inside one, or the
+                                result has to be checked by parsing the whole
+                                text
+     */
+    bool parse_token(size_t offset, size_t erased, size_t inserted);
+    bool parse_group(size_t offset, size_t erased, size_t inserted);
+    
+    /* void shift(size_t from, size_t erased, size_t inserted);
+     Moves the spans of text after an edit.
+     */
+    void shift(size_t from, size_t erased, size_t inserted);
+    
+    /* void release(int n);
+     Leaves a subtree unused.
+     */
+    void release(int n);
+    
+    /* void invalidate(int n);
+     Marks a node and the path from it to the root to be computed again.
+     */
+    void invalidate(int n);
+    
+    /* void recompute();
+     Computes the value of each node marked to be computed again.
+     */
+    void recompute();
+    
+    /* void update_calculator();
+     Stores the text and result in the calculator, if the expression is kept
+     there and has a result.
+     */
+    void update_calculator();
+    
+public:
+    
+    /* incremental_expression(basic_calculator<T> &calc, string exp);
+     Constructor that parses an expression. An invalid expression is kept, so
+     that it can be edited into a valid one.
+        @param  basic_calculator<T> &calc [in]  calculator whose operators
+                                                    are used
+        @param  string exp [in]                 infix expression, which may
+                                                    have variables
+     Precondition:      calc exists as long as this object
+     */
+    incremental_expression(calculator_type &calc, string exp);
+    
+    /* incremental_expression(basic_calculator<T> &calc, int exp_id);
+     Constructor that parses the expression calc stores at exp_id and keeps it
+     up to date: after each edit that leaves a valid expression without
+     variables, calc.update is done in place with the new text and result.
+        @param  basic_calculator<T> &calc [in/out]  calculator storing the
+                                                        expression
+        @param  int exp_id [in]                     position of the expression
+     Precondition:      calc exists as long as this object, 0 <= exp_id <
+                        calc.size()
+     */
+    incremental_expression(calculator_type &calc, int exp_id);
+    
+    /* void edit(size_t offset, size_t erase, string insert);
+     Replaces erase characters of the text, starting at offset, by insert.
+     Only the number, variable or parenthesized group the edit falls in is
+     parsed again, unless the edit changes how the text around it is parsed,
+     and every subtree containing it is marked to be computed again.
+        @param  size_t offset [in]      position of the first character to
+                                            replace
+        @param  size_t erase [in]       number of characters to replace
+        @param  string insert [in]      characters to put in their place
+     Precondition:      offset <= text().length()
+     Postcondition:     text() holds the edited text. Throws an out_of_range
+                        exception if offset is past its end.
+     */
+    void edit(size_t offset, size_t erase, string insert) throw(out_of_range);
+    
+    /* void bind(string name, T value);
+     Sets the value of a variable. Only the subtrees using it are computed
+     again.
+     */
+    void bind(string name, T value);
+    
+    /* T value();
+     Returns the result of the expression, computing only the subtrees marked
+     since the last call.
+        @return T [out]     result of the expression
+     Postcondition:     Returns the same result as evaluate on text() with its
+                        variables bound, else throws the same exception:
+                        the exception compile throws, or an invalid_argument
+                        exception on division by zero or for an unbound
+                        variable.
+     */
+    T value();
+    
+    /* bool valid() const;
+     Returns true if the text is a valid expression, whatever its value.
+     */
+    bool valid() const;
+    
+    /* const string &text() const;
+     Returns the text of the expression.
+     */
+    const string &text() const;
+    
+    /* size_t reparsed() const;
+       size_t recomputed() const;
+     Return the number of characters parsed by the last edit and the number of
+     nodes computed by the last call to value, which are small compared to the
+     length of the text for edits inside a number or a group.
+     */
+    size_t reparsed() const;
+    size_t recomputed() const;
+    
+};
+
+// Compiled ahead of time in incremental.cpp
+extern template class incremental_expression<float>;
+extern template class incremental_expression<double>;
+extern template class incremental_expression<long double>;
+
+#endif
@@ -0,0 +1,361 @@
+/*****************************************************************************
+ Title:             jit.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Native Code Compiler Class Implementations
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "jit.h"
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include <math.h>
+
+// Machine code is only generated for x86-64 on systems with mmap
+#if defined(__x86_64__) && defined(__unix__)
+#define JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+typedef basic_calculator<double> double_calculator_type;
+
+/******************************************************************************
+    Code generation
+ ******************************************************************************/
+ 
+#ifdef JIT_X86_64
+
+/* Operators the generated code calls instead of inlining. They are the
+ interpreter's own, so the results are the same, and they never throw, so no
+ exception has to pass through generated code.
+ */
+static double call_pow(double a, double b) {
+    return double_calculator_type::execute(double_calculator_type::POW, a, b);
+}
+
+static double call_sqrt(double a) {
+    return double_calculator_type::execute(double_calculator_type::SQRT, a);
+}
+
+// Instruction bytes used below
+enum {
+    PREFIX_F2 = 0xF2, PREFIX_66 = 0x66,     // Scalar double, packed double
+    MOVSD_LOAD = 0x10, MOVSD_STORE = 0x11, MOVAPD = 0x28, UCOMISD = 0x2E,
+    ADDSD = 0x58, MULSD = 0x59, SUBSD = 0x5C, DIVSD = 0x5E,
+    RBX = 3, RSP = 4                        // Base registers of memory operands
+};
+
+// Bytes of stack for spilling values around calls, one slot per register
+static const int spill_size = 16 * 8;
+
+/* Accumulates machine code and the constants it loads. Constants are placed
+ after the code and loaded relative to the instruction pointer; their
+ displacements are filled in once the size of the code is known.
+ */
+struct x86_assembler {
+    vector<unsigned char> code;
+    vector<double> constants;
+    vector<pair<size_t, int> > fixups;  // Displacement offset, constant index
+    vector<size_t> error_jumps;         // Offsets of jumps to the error exit
+    
+    void byte(unsigned char b) { code.push_back(b); }
+    
+    void dword(unsigned int d) {
+        for (int i = 0; i<4; i++) { byte((d >> (8*i)) & 0xFF); }
+    }
+    
+    int constant(double value) {
+        constants.push_back(value);
+        return (int)constants.size() - 1;
+    }
+    
+    /* SSE instruction on two registers: op xmm(reg), xmm(rm) */
+    void sse(unsigned char prefix, unsigned char op, int reg, int rm) {
+        byte(prefix);
+        if (reg >= 8 || rm >= 8) { byte(0x40 | (reg >= 8 ? 4 : 0) | (rm >= 8 ? 1 : 0)); }
+        byte(0x0F);
+        byte(op);
+        byte(0xC0 | (reg & 7) << 3 | (rm & 7));
+    }
+    
+    /* SSE instruction on a register and a constant */
+    void sse_constant(unsigned char prefix, unsigned char op, int reg, int index) {
+        byte(prefix);
+        if (reg >= 8) { byte(0x44); }
+        byte(0x0F);
+        byte(op);
+        byte((reg & 7) << 3 | 5);
+        fixups.push_back(make_pair(code.size(), index));
+        dword(0);
+    }
+    
+    /* SSE instruction on a register and the memory at base + disp */
+    void sse_memory(unsigned char prefix, unsigned char op, int reg, int base, int disp) {
+        byte(prefix);
+        if (reg >= 8) { byte(0x44); }
+        byte(0x0F);
+        byte(op);
+        byte(0x80 | (reg & 7) << 3 | base);
+        if (base == RSP) { byte(0x24); }
+        dword(disp);
+    }
+    
+    /* push rbx; mov rbx, rdi; sub rsp, spill_size. rbx keeps the variables
+     across calls and the stack stays aligned to 16 bytes for them.
+     */
+    void prologue() {
+        byte(0x53);
+        byte(0x48); byte(0x89); byte(0xFB);
+        byte(0x48); byte(0x81); byte(0xEC); dword(spill_size);
+    }
+    
+    /* add rsp, spill_size; pop rbx; ret */
+    void epilogue() {
+        byte(0x48); byte(0x81); byte(0xC4); dword(spill_size);
+        byte(0x5B);
+        byte(0xC3);
+    }
+    
+    /* Calls a function of one or two doubles on the values in xmm(a) and
+     xmm(a+1), leaving its result in xmm(a). Every value below a is saved
+     first, since a call may change any SSE register.
+     */
+    void call(const void *function, int a, int operands) {
+        for (int i = 0; i<a; i++) { sse_memory(PREFIX_F2, MOVSD_STORE, i, RSP, 8*i); }
+        
+        if (a != 0) { sse(PREFIX_66, MOVAPD, 0, a); }
+        if (operands == 2 && a != 0) { sse(PREFIX_66, MOVAPD, 1, a+1); }
+        
+        // mov rax, function; call rax
+        byte(0x48); byte(0xB8);
+        uint64_t address = (uint64_t)function;
+        for (int i = 0; i<8; i++) { byte((address >> (8*i)) & 0xFF); }
+        byte(0xFF); byte(0xD0);
+        
+        if (a != 0) { sse(PREFIX_66, MOVAPD, a, 0); }
+        for (int i = 0; i<a; i++) { sse_memory(PREFIX_F2, MOVSD_LOAD, i, RSP, 8*i); }
+    }
+    
+    /* Jumps to the error exit if xmm(reg) is zero. NaN compares unordered,
+     which also sets the zero flag, so it is skipped first.
+     */
+    void jump_if_zero(int reg, int zero) {
+        sse_constant(PREFIX_66, UCOMISD, reg, zero);
+        byte(0x7A); byte(0x06);             // jp over the je
+        byte(0x0F); byte(0x84);             // je error
+        error_jumps.push_back(code.size());
+        dword(0);
+    }
+};
+
+#endif
+
+/* Translates each instruction in order. Stack slot i is register xmm(i), so
+ the program's own stack discipline decides which registers are used. The
+ error exit returns NaN.
+ */
+native_function::native_function(const basic_calculator<double>::compiled_expression &prog) throw(invalid_argument)
+    : code(NULL), length(0), entry(NULL) {
+    
+#ifdef JIT_X86_64
+    typedef double_calculator_type calc;
+    
+    if (prog.max_depth > 16) { throw invalid_argument("Expression too deep to compile"); }
+    
+    x86_assembler as;
+    int zero = -1;
+    int top = 0;
+    
+    as.prologue();
+    
+    for (size_t i = 0; i<prog.code.size(); i++) {
+        const calc::instruction &ins = prog.code[i];
+        
+        switch (ins.op) {
+            case calc::PUSH:
+                as.sse_constant(PREFIX_F2, MOVSD_LOAD, top++, as.constant(prog.constants[ins.arg]));
+                break;
+            case calc::LOAD:
+                as.sse_memory(PREFIX_F2, MOVSD_LOAD, top++, RBX, 8*ins.arg);
+                break;
+            case calc::ADD:
+                as.sse(PREFIX_F2, ADDSD, top-2, top-1);
+                top--;
+                break;
+            case calc::SUB:
+                as.sse(PREFIX_F2, SUBSD, top-2, top-1);
+                top--;
+                break;
+            case calc::MUL:
+                as.sse(PREFIX_F2, MULSD, top-2, top-1);
+                top--;
+                break;
+            case calc::DIV:
+                if (zero < 0) { zero = as.constant(0); }
+                as.jump_if_zero(top-1, zero);
+                as.sse(PREFIX_F2, DIVSD, top-2, top-1);
+                top--;
+                break;
+            case calc::POW:
+                as.call((const void *)&call_pow, top-2, 2);
+                top--;
+                break;
+            case calc::SQR:
+                as.sse(PREFIX_F2, MULSD, top-1, top-1);
+                break;
+            case calc::SQRT:
+                as.call((const void *)&call_sqrt, top-1, 1);
+                break;
+            default:
+                throw invalid_argument("Operator character expected");
+        }
+    }
+    
+    // Result is in xmm0
+    as.epilogue();
+    
+    // Error exit
+    size_t error = as.code.size();
+    as.sse_constant(PREFIX_F2, MOVSD_LOAD, 0, as.constant(numeric_limits<double>::quiet_NaN()));
+    as.epilogue();
+    
+    // Resolve jumps and constant addresses. Displacements are relative to the
+    // end of the instruction, which each of them ends.
+    size_t code_size = (as.code.size() + 7) & ~(size_t)7;
+    for (size_t i = 0; i<as.error_jumps.size(); i++) {
+        int disp = (int)(error - (as.error_jumps[i] + 4));
+        memcpy(&as.code[as.error_jumps[i]], &disp, 4);
+    }
+    for (size_t i = 0; i<as.fixups.size(); i++) {
+        int disp = (int)(code_size + 8*as.fixups[i].second - (as.fixups[i].first + 4));
+        memcpy(&as.code[as.fixups[i].first], &disp, 4);
+    }
+    
+    // Copy into a writable mapping, then make it executable instead
+    length = code_size + 8*as.constants.size();
+    void *mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) { throw invalid_argument("Unable to allocate code"); }
+    
+    memset(mapping, 0xCC, code_size);
+    memcpy(mapping, &as.code[0], as.code.size());
+    if (!as.constants.empty()) {
+        memcpy((char *)mapping + code_size, &as.constants[0], 8*as.constants.size());
+    }
+    
+    if (mprotect(mapping, length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mapping, length);
+        throw invalid_argument("Unable to allocate code");
+    }
+    
+    code = mapping;
+    entry = (function_type)mapping;
+#else
+    throw invalid_argument("Native code not supported");
+#endif
+}
+
+/* Native function destructor. Unmaps the code. */
+native_function::~native_function() {
+#ifdef JIT_X86_64
+    if (code) { munmap(code, length); }
+#endif
+}
+
+/* Runs the code */
+double native_function::operator()(const double *vars) const {
+    return entry(vars);
+}
+
+/* Returns the code as a function pointer */
+native_function::function_type native_function::get() const {
+    return entry;
+}
+
+/* Returns whether code can be generated */
+bool native_function::supported() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+/******************************************************************************
+    Tiered evaluation
+ ******************************************************************************/
+ 
+/* Runs machine code. Only double programs are translated; for any other type
+ this is never called.
+ */
+static inline double run_native(const native_function &f, const double *vars) {
+    return f(vars);
+}
+
+template <class T>
+static inline T run_native(const native_function &, const T *) {
+    return numeric_limits<T>::quiet_NaN();
+}
+
+/* Hot expression constructor. Compiles and optimizes the expression. */
+template <class T>
+hot_expression<T>::hot_expression(calculator_type &calc, string exp, unsigned long threshold)
+    : calc(calc), count(0), threshold(threshold), tried(false) {
+    prog = calc.optimize(calc.compile(exp));
+}
+
+/* Hot expression constructor for a compiled program */
+template <class T>
+hot_expression<T>::hot_expression(calculator_type &calc, const program &prog, unsigned long threshold)
+    : calc(calc), prog(prog), count(0), threshold(threshold), tried(false) { }
+    
+/* Returns names of variables */
+template <class T>
+const vector<string> &hot_expression<T>::variables() const {
+    return prog.variables;
+}
+
+/* Only double programs can be translated */
+template <class T>
+void hot_expression<T>::tier_up() { }
+
+/* Translates the program, or keeps interpreting it if it cannot be */
+template <>
+void hot_expression<double>::tier_up() {
+    try {
+        native.reset(new native_function(prog));
+    }
+    catch (invalid_argument &e) { }
+}
+
+/* Runs the machine code if there is any, else interprets the program and
+ translates it once it has been run threshold times. NaN from machine code is
+ either an error or a real NaN result; the interpreter tells which.
+ */
+template <class T>
+T hot_expression<T>::evaluate(const T *vars) {
+    if (native) {
+        T result = run_native(*native, vars);
+        if (result == result) { return result; }
+    }
+    else if (!tried && ++count >= threshold) {
+        tried = true;
+        tier_up();
+        if (native) { return evaluate(vars); }
+    }
+    
+    return calc.run(prog, vars);
+}
+
+/* Returns whether the expression runs as machine code */
+template <class T>
+bool hot_expression<T>::is_native() const {
+    return (bool)native;
+}
+
+// Compile hot expressions for each value type the calculator supports
+template class hot_expression<float>;
+template class hot_expression<double>;
+template class hot_expression<long double>;
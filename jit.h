@@ -0,0 +1,169 @@
+/*****************************************************************************
+ Title:             jit.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Native Code Compiler Class Definitions (Header File)
+                        - Translates a compiled program of double values into
+                            x86-64 machine code, a function that takes the
+                            values of its variables and returns its result
+                        - Runs an expression in the interpreter until it has
+                            been evaluated often enough to be worth
+                            translating, then runs the machine code
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___jit__
+#define ___jit__
+
+#include <memory>
+#include <stdexcept>
+#include "calculator.h"
+using namespace std;
+
+class native_function {
+
+public:
+    
+    // Signature of the generated code
+    typedef double (*function_type)(const double *vars);
+    
+private:
+    
+    void *code;             // Executable mapping holding code and constants
+    size_t length;          // Size of the mapping in bytes
+    function_type entry;
+    
+    // Machine code cannot be copied, only shared
+    native_function(const native_function &);
+    native_function &operator = (const native_function &);
+    
+public:
+    
+    /* native_function(const basic_calculator<double>::compiled_expression
+                       &prog);
+     Constructor that translates a program into machine code. Each value of
+     the run time stack is kept in an SSE register and each instruction
+     becomes one or two machine instructions; pow and square roots are called.
+        @param  compiled_expression &prog [in]  program returned by compile or
+                                                    optimize
+     Precondition:      none
+     Postcondition:     operator() computes the same result as running prog.
+                        Division by zero returns NaN. Throws an
+                        invalid_argument exception if the program cannot be
+                        translated: the processor is not x86-64 or the program
+                        needs more than 16 stack values.
+     */
+    native_function(const basic_calculator<double>::compiled_expression &prog) throw(invalid_argument);
+    
+    /* ~native_function();
+     Destructor that frees the machine code.
+     */
+    ~native_function();
+    
+    /* double operator()(const double *vars) const;
+     Runs the machine code.
+        @param  double *vars [in]   value of each variable, in the order of
+                                        prog.variables
+        @return double [out]        result, or NaN if the program divides by
+                                        zero
+     */
+    double operator()(const double *vars) const;
+    
+    /* function_type get() const;
+     Returns the machine code as a function pointer, valid while this object
+     exists.
+     */
+    function_type get() const;
+    
+    /* static bool supported();
+     Returns true if machine code can be generated on this platform.
+     */
+    static bool supported();
+    
+};
+
+/* An expression that is interpreted until it has been evaluated threshold
+ times, then translated into machine code, if T is double and the program can
+ be translated. Not safe to use from many threads at once.
+ */
+template <class T>
+class hot_expression {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef typename calculator_type::compiled_expression program;
+    
+    calculator_type &calc;
+    program prog;
+    unsigned long count;        // Evaluations so far
+    unsigned long threshold;
+    bool tried;                 // Translation has been attempted
+    shared_ptr<native_function> native;
+    
+    /* void tier_up();
+     Translates the program into machine code if it is possible.
+     */
+    void tier_up();
+    
+public:
+    
+    /* hot_expression(basic_calculator<T> &calc, string exp,
+                      unsigned long threshold=1000);
+     Constructor that compiles and optimizes an expression.
+        @param  basic_calculator<T> &calc [in]  calculator to compile and
+                                                    interpret the expression
+                                                    with
+        @param  string exp [in]                 infix expression, which may
+                                                    have variables
+        @param  unsigned long threshold [in]    evaluations before the
+                                                    expression is translated
+     Precondition:      calc exists as long as this object
+     Postcondition:     The expression is ready to evaluate, else an exception
+                        is thrown as by compile.
+     */
+    hot_expression(calculator_type &calc, string exp, unsigned long threshold=1000);
+    
+    /* hot_expression(basic_calculator<T> &calc, const program &prog,
+                      unsigned long threshold=1000);
+     Same as above, for a program already compiled, and optimized if it is to
+     be, which is used as it is.
+     */
+    hot_expression(calculator_type &calc, const program &prog, unsigned long threshold=1000);
+    
+    /* const vector<string> &variables() const;
+     Returns the names of the variables, in the order their values are given.
+     */
+    const vector<string> &variables() const;
+    
+    /* T evaluate(const T *vars);
+     Evaluates the expression with its variables bound to vars.
+        @param  T *vars [in]    value of each variable, in the order of
+                                    variables()
+        @return T [out]         result of the expression
+     Precondition:      vars holds at least variables().size() values
+     Postcondition:     Returns the same result as running the program in the
+                        interpreter, or throws the same invalid_argument
+                        exception. Whenever the machine code returns NaN, e.g.
+                        on division by zero, the interpreter is run again to
+                        tell an error from a NaN result.
+     */
+    T evaluate(const T *vars);
+    
+    /* bool is_native() const;
+     Returns true once the expression runs as machine code.
+     */
+    bool is_native() const;
+    
+};
+
+// Only double expressions are translated
+template <> void hot_expression<double>::tier_up();
+
+// Compiled ahead of time in jit.cpp
+extern template class hot_expression<float>;
+extern template class hot_expression<double>;
+extern template class hot_expression<long double>;
+
+#endif
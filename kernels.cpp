@@ -0,0 +1,238 @@
+/*****************************************************************************
+ Title:             kernels.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Column Kernels Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "kernels.h"
+#include <math.h>
+
+// AVX2 code is compiled for every x86 build and only selected at run time if
+// the processor supports it. SSE2 is part of every x86-64 processor.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define KERNELS_SSE
+#endif
+
+/******************************************************************************
+    Vector implementations
+    Each processes as many whole vectors of rows as fit in n and returns the
+    number of rows done. The caller finishes the remaining rows one by one.
+    There are float and double versions; any other type matches the generic
+    versions, which do no rows.
+ ******************************************************************************/
+
+template <class T> static size_t avx2_fill(T, T *, size_t) { return 0; }
+template <class T> static size_t avx2_add(const T *, const T *, T *, size_t) { return 0; }
+template <class T> static size_t avx2_sub(const T *, const T *, T *, size_t) { return 0; }
+template <class T> static size_t avx2_mul(const T *, const T *, T *, size_t) { return 0; }
+template <class T> static size_t avx2_div(const T *, const T *, T *, unsigned char *, size_t) { return 0; }
+template <class T> static size_t avx2_sqrt(const T *, T *, size_t) { return 0; }
+
+template <class T> static size_t sse_fill(T, T *, size_t) { return 0; }
+template <class T> static size_t sse_add(const T *, const T *, T *, size_t) { return 0; }
+template <class T> static size_t sse_sub(const T *, const T *, T *, size_t) { return 0; }
+template <class T> static size_t sse_mul(const T *, const T *, T *, size_t) { return 0; }
+template <class T> static size_t sse_div(const T *, const T *, T *, unsigned char *, size_t) { return 0; }
+template <class T> static size_t sse_sqrt(const T *, T *, size_t) { return 0; }
+
+/* Square root of a single row, as the SQRT operator computes it */
+template <class T>
+static inline T scalar_sqrt(T a) {
+    return signbit(a) ? pow(a, T(0.5)) : sqrt(a);
+}
+
+/* Flags each row whose bit is set in a mask of zero divisors */
+static inline void flag_zeros(int zeros, unsigned char *errors) {
+    while (zeros) {
+        errors[__builtin_ctz(zeros)] = 1;
+        zeros &= zeros-1;
+    }
+}
+
+// Defines a vector implementation of a binary operator for one type, where W
+// is the number of rows in a vector of type V
+#define VECTOR_BINARY(target, name, T, W, V, load, store, intrinsic)            \
+target static size_t name(const T *a, const T *b, T *out, size_t n) {         \
+    size_t i = 0;                                                              \
+    for (; i+W <= n; i += W) {                                                 \
+        V r = intrinsic(load(a+i), load(b+i));                                 \
+        store(out+i, r);                                                       \
+    }                                                                          \
+    return i;                                                                  \
+}
+
+#define VECTOR_FILL(target, name, T, W, V, store, set1)                        \
+target static size_t name(T value, T *out, size_t n) {                        \
+    V v = set1(value);                                                         \
+    size_t i = 0;                                                              \
+    for (; i+W <= n; i += W) { store(out+i, v); }                              \
+    return i;                                                                  \
+}
+
+// Divides whole vectors of rows, flagging the rows of any vector that has a
+// zero divisor
+#define VECTOR_DIV(target, name, T, W, V, load, store, div, zero, eq, mask)    \
+target static size_t name(const T *a, const T *b, T *out,                     \
+                          unsigned char *errors, size_t n) {                   \
+    const V z = zero();                                                        \
+    size_t i = 0;                                                              \
+    for (; i+W <= n; i += W) {                                                 \
+        V divisor = load(b+i);                                                 \
+        int zeros = mask(eq(divisor, z));                                      \
+        store(out+i, div(load(a+i), divisor));                                 \
+        flag_zeros(zeros, errors + i);                                         \
+    }                                                                          \
+    return i;                                                                  \
+}
+
+// Takes the square root of whole vectors of rows. Rows of a vector with a
+// negative value, including -0, are left to the scalar square root of the
+// calculator, which gives what pow gives for them.
+#define VECTOR_SQRT(target, name, T, W, V, load, store, sqrt, mask)            \
+target static size_t name(const T *a, T *out, size_t n) {                     \
+    size_t i = 0;                                                              \
+    for (; i+W <= n; i += W) {                                                 \
+        V v = load(a+i);                                                       \
+        if (mask(v)) {                                                         \
+            for (size_t j = i; j<i+W; j++) { out[j] = scalar_sqrt(a[j]); }     \
+        }                                                                      \
+        else { store(out+i, sqrt(v)); }                                        \
+    }                                                                          \
+    return i;                                                                  \
+}
+
+#ifdef KERNELS_AVX2
+
+/* Returns true if the processor supports AVX2. Checked once. */
+static bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#define AVX2 __attribute__((target("avx2")))
+
+static inline __attribute__((target("avx2"))) __m256 avx2_eq_ps(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline __attribute__((target("avx2"))) __m256d avx2_eq_pd(__m256d a, __m256d b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+
+VECTOR_FILL(AVX2, avx2_fill, float, 8, __m256, _mm256_storeu_ps, _mm256_set1_ps)
+VECTOR_BINARY(AVX2, avx2_add, float, 8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps)
+VECTOR_BINARY(AVX2, avx2_sub, float, 8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps)
+VECTOR_BINARY(AVX2, avx2_mul, float, 8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps)
+VECTOR_DIV(AVX2, avx2_div, float, 8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_div_ps, _mm256_setzero_ps, avx2_eq_ps, _mm256_movemask_ps)
+VECTOR_SQRT(AVX2, avx2_sqrt, float, 8, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sqrt_ps, _mm256_movemask_ps)
+
+VECTOR_FILL(AVX2, avx2_fill, double, 4, __m256d, _mm256_storeu_pd, _mm256_set1_pd)
+VECTOR_BINARY(AVX2, avx2_add, double, 4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd)
+VECTOR_BINARY(AVX2, avx2_sub, double, 4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_sub_pd)
+VECTOR_BINARY(AVX2, avx2_mul, double, 4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_mul_pd)
+VECTOR_DIV(AVX2, avx2_div, double, 4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_div_pd, _mm256_setzero_pd, avx2_eq_pd, _mm256_movemask_pd)
+VECTOR_SQRT(AVX2, avx2_sqrt, double, 4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_sqrt_pd, _mm256_movemask_pd)
+
+#endif
+
+#ifdef KERNELS_SSE
+
+#define SSE
+
+VECTOR_FILL(SSE, sse_fill, float, 4, __m128, _mm_storeu_ps, _mm_set1_ps)
+VECTOR_BINARY(SSE, sse_add, float, 4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps)
+VECTOR_BINARY(SSE, sse_sub, float, 4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_sub_ps)
+VECTOR_BINARY(SSE, sse_mul, float, 4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps)
+VECTOR_DIV(SSE, sse_div, float, 4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_div_ps, _mm_setzero_ps, _mm_cmpeq_ps, _mm_movemask_ps)
+VECTOR_SQRT(SSE, sse_sqrt, float, 4, __m128, _mm_loadu_ps, _mm_storeu_ps, _mm_sqrt_ps, _mm_movemask_ps)
+
+VECTOR_FILL(SSE, sse_fill, double, 2, __m128d, _mm_storeu_pd, _mm_set1_pd)
+VECTOR_BINARY(SSE, sse_add, double, 2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd)
+VECTOR_BINARY(SSE, sse_sub, double, 2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_sub_pd)
+VECTOR_BINARY(SSE, sse_mul, double, 2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_mul_pd)
+VECTOR_DIV(SSE, sse_div, double, 2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_div_pd, _mm_setzero_pd, _mm_cmpeq_pd, _mm_movemask_pd)
+VECTOR_SQRT(SSE, sse_sqrt, double, 2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_sqrt_pd, _mm_movemask_pd)
+
+#endif
+
+/* Selects the widest vector implementation available, if any, and returns the
+ number of rows it processed.
+ */
+#if defined(KERNELS_AVX2) && defined(KERNELS_SSE)
+#define DISPATCH(avx2_call, sse_call) (has_avx2() ? avx2_call : sse_call)
+#elif defined(KERNELS_AVX2)
+#define DISPATCH(avx2_call, sse_call) (has_avx2() ? avx2_call : 0)
+#elif defined(KERNELS_SSE)
+#define DISPATCH(avx2_call, sse_call) (sse_call)
+#else
+#define DISPATCH(avx2_call, sse_call) (0)
+#endif
+
+/******************************************************************************
+    Column operations
+    Vector implementation first, scalar loop for the rest of the rows.
+ ******************************************************************************/
+
+template <class T>
+void column_fill(T value, T *out, size_t n) {
+    size_t i = DISPATCH(avx2_fill(value, out, n), sse_fill(value, out, n));
+    for (; i<n; i++) { out[i] = value; }
+}
+
+template <class T>
+void column_add(const T *a, const T *b, T *out, size_t n) {
+    size_t i = DISPATCH(avx2_add(a, b, out, n), sse_add(a, b, out, n));
+    for (; i<n; i++) { out[i] = a[i] + b[i]; }
+}
+
+template <class T>
+void column_sub(const T *a, const T *b, T *out, size_t n) {
+    size_t i = DISPATCH(avx2_sub(a, b, out, n), sse_sub(a, b, out, n));
+    for (; i<n; i++) { out[i] = a[i] - b[i]; }
+}
+
+template <class T>
+void column_mul(const T *a, const T *b, T *out, size_t n) {
+    size_t i = DISPATCH(avx2_mul(a, b, out, n), sse_mul(a, b, out, n));
+    for (; i<n; i++) { out[i] = a[i] * b[i]; }
+}
+
+template <class T>
+void column_div(const T *a, const T *b, T *out, unsigned char *errors, size_t n) {
+    size_t i = DISPATCH(avx2_div(a, b, out, errors, n), sse_div(a, b, out, errors, n));
+    for (; i<n; i++) {
+        // Divide by zero error, flag row
+        if (b[i] == 0) { errors[i] = 1; }
+        out[i] = a[i] / b[i];
+    }
+}
+
+template <class T>
+void column_pow(const T *a, const T *b, T *out, size_t n) {
+    for (size_t i = 0; i<n; i++) { out[i] = pow(a[i], b[i]); }
+}
+
+template <class T>
+void column_sqrt(const T *a, T *out, size_t n) {
+    size_t i = DISPATCH(avx2_sqrt(a, out, n), sse_sqrt(a, out, n));
+    for (; i<n; i++) { out[i] = scalar_sqrt(a[i]); }
+}
+
+// Compile the kernels for each value type the calculator supports
+#define INSTANTIATE_KERNELS(T)                                                  \
+template void column_fill(T value, T *out, size_t n);                          \
+template void column_add(const T *a, const T *b, T *out, size_t n);            \
+template void column_sub(const T *a, const T *b, T *out, size_t n);            \
+template void column_mul(const T *a, const T *b, T *out, size_t n);            \
+template void column_div(const T *a, const T *b, T *out, unsigned char *errors, size_t n); \
+template void column_pow(const T *a, const T *b, T *out, size_t n);            \
+template void column_sqrt(const T *a, T *out, size_t n);
+
+INSTANTIATE_KERNELS(float)
+INSTANTIATE_KERNELS(double)
+INSTANTIATE_KERNELS(long double)
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ Title:             kernels.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Column Kernels (Header File)
+                        - Applies each of the calculator's operators to whole
+                            columns of values at once
+                        - Compiled for float, double and long double columns
+                        - Uses AVX2 or SSE when the processor supports them,
+                            else falls back to a scalar loop. long double
+                            columns always use the scalar loop.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___kernels__
+#define ___kernels__
+
+#include <cstddef>
+using namespace std;
+
+/******************************************************************************
+    Column operations
+ ******************************************************************************/
+
+/*  template <class T> void column_fill(T value, T *out, size_t n);
+ Sets every element of a column to the same value.
+    @param  T value [in]            value to copy
+    @param  T *out [out]            column of n elements
+    @param  size_t n [in]           number of elements
+ Precondition:      out holds at least n elements
+ Postcondition:     out[i] == value for every i < n
+ */
+template <class T> void column_fill(T value, T *out, size_t n);
+
+/*  template <class T>
+    void column_add(const T *a, const T *b, T *out, size_t n);
+    void column_sub(const T *a, const T *b, T *out, size_t n);
+    void column_mul(const T *a, const T *b, T *out, size_t n);
+ Computes out[i] = a[i] op b[i] for each row i.
+    @param  T *a [in]               left operands
+    @param  T *b [in]               right operands
+    @param  T *out [out]            results, may be the same column as a or b
+    @param  size_t n [in]           number of rows
+ Precondition:      a, b and out hold at least n elements
+ Postcondition:     out[i] holds a[i] op b[i] for every i < n
+ */
+template <class T> void column_add(const T *a, const T *b, T *out, size_t n);
+template <class T> void column_sub(const T *a, const T *b, T *out, size_t n);
+template <class T> void column_mul(const T *a, const T *b, T *out, size_t n);
+
+/*  template <class T>
+    void column_div(const T *a, const T *b, T *out, unsigned char *errors,
+                    size_t n);
+ Computes out[i] = a[i] / b[i] for each row i. Rows that divide by zero are
+ flagged in errors instead of stopping the whole column.
+    @param  T *a [in]                   dividends
+    @param  T *b [in]                   divisors
+    @param  T *out [out]                results, may be the same column as a
+                                            or b
+    @param  unsigned char *errors [out] error flag of each row
+    @param  size_t n [in]               number of rows
+ Precondition:      a, b, out and errors hold at least n elements
+ Postcondition:     out[i] holds a[i] / b[i] for every i < n. errors[i] is set
+                    to 1 if b[i] == 0, in which case out[i] is undefined, and
+                    is unchanged otherwise.
+ */
+template <class T> void column_div(const T *a, const T *b, T *out, unsigned char *errors, size_t n);
+
+/*  template <class T>
+    void column_pow(const T *a, const T *b, T *out, size_t n);
+ Computes out[i] = a[i] ^ b[i] for each row i. There is no vector instruction
+ for pow, so this is always a scalar loop.
+    @param  T *a [in]               bases
+    @param  T *b [in]               exponents
+    @param  T *out [out]            results, may be the same column as a or b
+    @param  size_t n [in]           number of rows
+ Precondition:      a, b and out hold at least n elements
+ Postcondition:     out[i] holds pow(a[i], b[i]) for every i < n
+ */
+template <class T> void column_pow(const T *a, const T *b, T *out, size_t n);
+
+/*  template <class T> void column_sqrt(const T *a, T *out, size_t n);
+ Computes out[i] = a[i] ^ 0.5 for each row i, the way the SQRT operator of a
+ compiled program does.
+    @param  T *a [in]               operands
+    @param  T *out [out]            results, may be the same column as a
+    @param  size_t n [in]           number of rows
+ Precondition:      a and out hold at least n elements
+ Postcondition:     out[i] holds the square root of a[i] for every i < n, or
+                    pow(a[i], 0.5) if a[i] is negative
+ */
+template <class T> void column_sqrt(const T *a, T *out, size_t n);
+
+#endif
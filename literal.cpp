@@ -0,0 +1,168 @@
+/*****************************************************************************
+ Title:             literal.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Numeric Literal Scanner Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "literal.h"
+#include "profiler.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+// Powers of ten that are exact as a double
+static const double exact_powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+    1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Returns true if d lies exactly halfway between two floats */
+static bool float_midpoint(double d) {
+    float f = (float)d;
+    if (isinf(f)) { return false; }
+    double gap = nextafterf(f, d > f ? HUGE_VALF : -HUGE_VALF) - (double)f;
+    return gap != 0 && fabs(d - f) * 2 == fabs(gap);
+}
+
+/* Converts mantissa * 10^scale, both exact as doubles, with one operation.
+ Returns false if the result might not be correctly rounded.
+    For double and long double, the single operation rounds correctly. For
+ float it is done in double and rounded again, which is still correct unless
+ the double landed exactly halfway between two floats.
+ */
+static bool fast_convert(uint64_t mantissa, int scale, double &value) {
+    if (scale < 0) { value = (double)mantissa / exact_powers[-scale]; }
+    else { value = (double)mantissa * exact_powers[scale]; }
+    return true;
+}
+
+static bool fast_convert(uint64_t mantissa, int scale, long double &value) {
+    if (scale < 0) { value = (long double)mantissa / exact_powers[-scale]; }
+    else { value = (long double)mantissa * exact_powers[scale]; }
+    return true;
+}
+
+static bool fast_convert(uint64_t mantissa, int scale, float &value) {
+    double d;
+    fast_convert(mantissa, scale, d);
+    if (float_midpoint(d) || d > numeric_limits<float>::max()) { return false; }
+    
+    value = (float)d;
+    return true;
+}
+
+/* Converts a null terminated number with the C library */
+static void slow_convert(const char *s, float &value) { value = strtof(s, NULL); }
+static void slow_convert(const char *s, double &value) { value = strtod(s, NULL); }
+static void slow_convert(const char *s, long double &value) { value = strtold(s, NULL); }
+
+/* Reads the number, throwing if scanning it finds an error */
+template <class T>
+size_t scan_number(const char *s, size_t length, T &value) throw(invalid_argument) {
+    size_t bad;
+    size_t j = scan_number(s, length, value, bad);
+    if (j == 0) { throw invalid_argument("Too many decimal points"); }
+    return j;
+}
+
+/* Reads the number in one pass: the digits are accumulated into an integer
+ mantissa and the position of the decimal point and the exponent into a power
+ of ten. If the mantissa fits exactly in a double and the power of ten is
+ exact too, fast_convert finds the correctly rounded value with a single
+ operation. Any other number is converted by the C library from a copy of its
+ characters.
+ */
+template <class T>
+size_t scan_number(const char *s, size_t length, T &value, size_t &bad) {
+    CALC_PROFILE_SCOPE(PROFILE_NUMBER);
+    
+    uint64_t mantissa = 0;
+    int digits = 0;         // Significant digits in mantissa
+    int scale = 0;          // Power of ten to apply to the mantissa
+    bool exact = true;      // Mantissa holds every digit
+    int count_decimal = 0;
+    
+    size_t j = 0;
+    while (j < length && (isdigit(s[j]) || s[j] == '.')) {
+        
+        // VALIDITY CHECK: make sure only one decimal point in number
+        if (s[j] == '.') {
+            count_decimal ++;
+            if (count_decimal > 1) {
+                bad = j;
+                return 0;
+            }
+        }
+        else {
+            if (mantissa != 0 || s[j] != '0') { digits++; }
+            if (digits <= 19) {
+                mantissa = mantissa * 10 + (s[j] - '0');
+                if (count_decimal) { scale--; }
+            }
+            else {
+                exact = false;
+            }
+        }
+        j++;
+    }
+    
+    // Optional exponent, only if there is at least one digit after the 'e'
+    // and its sign
+    if (j < length && (s[j] == 'e' || s[j] == 'E')) {
+        size_t k = j+1;
+        bool negative = false;
+        if (k < length && (s[k] == '+' || s[k] == '-')) {
+            negative = (s[k] == '-');
+            k++;
+        }
+        
+        if (k < length && isdigit(s[k])) {
+            int exponent = 0;
+            while (k < length && isdigit(s[k])) {
+                // Keep reading past huge exponents, which are out of range
+                if (exponent < 100000) { exponent = exponent * 10 + (s[k] - '0'); }
+                k++;
+            }
+            scale += negative ? -exponent : exponent;
+            j = k;
+        }
+    }
+    
+    // Fast path: single correctly rounded operation
+    if (exact && mantissa <= (1ULL << 53) && scale >= -22 && scale <= 22) {
+        if (fast_convert(mantissa, scale, value)) { return j; }
+    }
+    
+    // Slow path: convert the characters, copying them to a null terminated
+    // buffer on the call stack unless the number is very long
+    char buffer[64];
+    if (j < sizeof(buffer)) {
+        memcpy(buffer, s, j);
+        buffer[j] = '\0';
+        slow_convert(buffer, value);
+    }
+    else {
+        slow_convert(string(s, j).c_str(), value);
+    }
+    
+    // Out of range, clamp as stream extraction does
+    if (isinf(value)) { value = numeric_limits<T>::max(); }
+    
+    return j;
+}
+
+// Compile the scanner for each value type the calculator supports
+template size_t scan_number(const char *s, size_t length, float &value) throw(invalid_argument);
+template size_t scan_number(const char *s, size_t length, double &value) throw(invalid_argument);
+template size_t scan_number(const char *s, size_t length, long double &value) throw(invalid_argument);
+template size_t scan_number(const char *s, size_t length, float &value, size_t &bad);
+template size_t scan_number(const char *s, size_t length, double &value, size_t &bad);
+template size_t scan_number(const char *s, size_t length, long double &value, size_t &bad);
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ Title:             literal.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Numeric Literal Scanner (Header File)
+                        - Reads a positive decimal number, with an optional
+                            exponent, from the start of a string and converts
+                            it in a single pass
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___literal__
+#define ___literal__
+
+#include <cstddef>
+#include <stdexcept>
+using namespace std;
+
+/*  template <class T>
+    size_t scan_number(const char *s, size_t length, T &value);
+ Reads the number at the start of s and converts it to a value of type T,
+ which is float, double or long double. A number is a
+ digit followed by digits and at most one decimal point, then optionally an
+ exponent: 'e' or 'E', an optional sign and at least one digit, e.g. 1.5e3.
+ Numbers with up to 15 digits and small exponents are converted with a single
+ floating point operation; others are handed to the C library. Both give the
+ correctly rounded value.
+    @param  char *s [in]            characters to read, need not be null
+                                        terminated
+    @param  size_t length [in]      number of characters in s
+    @param  T &value [out]          value of the number
+    @return size_t [out]            number of characters that make up the
+                                        number
+ Precondition:      length > 0 and s[0] is a digit
+ Postcondition:     value holds the number and its length is returned, else
+                    an invalid_argument exception is thrown if it has more than
+                    one decimal point. Numbers too large for T are clamped
+                    to the largest value of T.
+ */
+template <class T>
+size_t scan_number(const char *s, size_t length, T &value) throw(invalid_argument);
+
+/*  template <class T>
+    size_t scan_number(const char *s, size_t length, T &value, size_t &bad);
+ Same as above, without throwing: returns 0 and sets bad to the offset of the
+ second decimal point if the number has more than one.
+ */
+template <class T>
+size_t scan_number(const char *s, size_t length, T &value, size_t &bad);
+
+#endif
@@ -11,7 +11,17 @@
  Purpose        :   To demonstrate usage of the stl::stack template class and
                     C++ exception handling
  
- Usage          :   ./calculator myFile.txt command2>error
+ Usage          :   ./calculator [-j threads] [-m] [-c size] [-s lines] [-d | -L]
+                        [-O | -V] [-S] [-e] [-b length] [-w saved]
+                        [-f format] [-p | -t trace] myFile.txt
+                        command2>error
+                                OR
+                    ./calculator -r [-d | -L] [-f format] saved
+                                OR
+                    ./calculator -u tolerance [-n samples] [-d | -L] myFile.txt
+                                OR
+                    ./calculator -l address [-j threads] [-c size] [-d | -L]
+                        [-O | -V]
                                 OR
                     ./calculator command2>error
  
@@ -19,10 +29,63 @@
                     with one expression on each line and error is the name of
                     the error log file. If no file name is given, user enters
                     infix expressions via the command line
+                    With -j, the file is evaluated by the given number of
+                    threads, or one per core if threads is 0. With -m, the
+                    file is memory mapped and evaluated in place instead of
+                    being read into memory. With -c, the results of up to size
+                    recent expressions are cached, so repeated expressions
+                    are not evaluated again. With -s, each result is printed
+                    as soon as it is evaluated instead of all at the end, and
+                    nothing is kept in memory; output is written lines at a
+                    time. Values are floats, or doubles with -d and long
+                    doubles with -L. With -O, each expression is optimized
+                    before it is run; x^2 and x^0.5 may then differ in the
+                    last bit. With -V, both the optimized, without folding
+                    constants, and the original expression are run and any
+                    expression whose results differ is treated as invalid.
+                    With -S, each subexpression shared by lines of the file
+                    is evaluated only once. With -e, each invalid line is
+                    printed as myFile.txt:line:column: followed by what is
+                    wrong with it and the line, instead of the line alone.
+                    With -b, each
+                    line of at least length characters is cut at the + of its
+                    long sums and the * of its long products into a balanced
+                    tree of parts, compiled and evaluated by all the threads
+                    of -j; its result may differ by rounding. With
+                    -w, the expressions and their exact results are also
+                    saved to the binary file saved, except
+                    with -s. With -r, the results saved to a file by -w with
+                    the same value type are printed without evaluating
+                    anything. With -f csv or -f json, the results are printed
+                    as CSV with a result,expression header line or as a JSON
+                    array of {"result", "expression"} objects, instead of
+                    under the RESULTS heading. -f has no effect with -s.
+                    With -l, the calculator runs as a server until
+                    interrupted, answering each line sent to the Unix domain
+                    socket address, or to the local TCP port address if it
+                    is host:port, with its result or "error: " and why it is
+                    invalid; -j then gives the number of worker threads.
+                    With -u, every literal of each line of the file is taken
+                    to be uncertain by tolerance, relative to its value, and
+                    the bounds of each result, and its mean and standard
+                    deviation over samples random draws, 10000 unless given
+                    by -n, are printed as [lo, hi] mean +/- stddev.
+                    If built with -DCALC_PROFILE, -p prints the time spent in
+                    each phase, the operators executed, the deepest stacks,
+                    the exceptions and the bytes read and written to the
+                    error stream at exit, and -t writes them with a timeline
+                    of every phase to trace, a Chrome trace JSON file.
+                    Otherwise -p and -t exit with an error.
  
- Build with     :   g++ -o calculator main.cpp calculator.cpp
+ Build with     :   g++ -std=c++14 -pthread -o calculator main.cpp calculator.cpp
+                    kernels.cpp thread_pool.cpp mapped_file.cpp literal.cpp
+                    result_cache.cpp output_sink.cpp optimizer.cpp
+                    shared_dag.cpp jit.cpp cell_sheet.cpp result_file.cpp
+                    eval_server.cpp profiler.cpp uncertainty.cpp
+                    expression_store.cpp tree_evaluator.cpp
+                    Add -DCALC_PROFILE to count and time each phase.
  
- Last modified  :   Nov 18, 2014
+ Last modified  :   Oct 17, 2026
  
  *******************************************************************************/
 
@@ -30,30 +93,211 @@
 #include <fstream>
 #include <cstdlib>
 #include <stdexcept>
+#include <vector>
+#include <signal.h>
 
 #include "calculator.h"
+#include "result_file.h"
+#include "eval_server.h"
+#include "uncertainty.h"
+#include "profiler.h"
 using namespace std;
 
+// Options given on the command line
+struct options {
+    bool parallel;      // -j: evaluate file on threads
+    unsigned threads;
+    bool mapped;        // -m: memory map file
+    size_t cache;       // -c: capacity of result cache, 0 for none
+    size_t stream;      // -s: lines per write in streaming mode, 0 for off
+    int optimize;       // -O: optimize programs, -V: also check them
+    bool shared;        // -S: evaluate shared subexpressions of file once
+    bool diagnose;      // -e: print where and why each line is invalid
+    size_t tree;        // -b: length of lines evaluated as trees, 0 for none
+    const char *save;   // -w: file to save results to, NULL for none
+    bool reload;        // -r: print results saved to the file
+    const char *listen; // -l: address to serve on, NULL for none
+    const char *tolerance;  // -u: relative tolerance of literals, NULL for none
+    size_t samples;     // -n: Monte Carlo samples of each line
+    output_format format;   // -f: how results are printed
+};
+
+/* eval_server<T> *&running_server();
+ Returns the server answering clients, for the signal handler to stop.
+ */
+template <class T>
+eval_server<T> *&running_server() {
+    static eval_server<T> *server = NULL;
+    return server;
+}
+
+/* void stop_server(int sig);
+ Signal handler that makes the running server return.
+ */
+template <class T>
+void stop_server(int) {
+    if (running_server<T>()) { running_server<T>()->stop(); }
+}
+
+/* void print_heading(const options &opt);
+ Prints the heading above the results, unless they are printed as CSV or JSON.
+ */
+void print_heading(const options &opt) {
+    if (opt.format != OUTPUT_TEXT) { return; }
+    cout << "\nRESULTS: " << endl;
+    cout << "==============================================================="<< endl;
+}
+
 /******************************************************************************
-                                MAIN PROGRAM
+                                CALCULATOR
  ******************************************************************************/
-
-int main(int argc, const char * argv[]) {
+ 
+/* Evaluates the input file, or the expressions entered on the command line if
+ no file is given, with a calculator whose values are of type T and prints the
+ results.
+ */
+template <class T>
+int run_calculator(int argc, const char * argv[], const options &opt) {
+    
+    typename basic_calculator<T>::optimize_mode optimization = typename basic_calculator<T>::optimize_mode(opt.optimize);
     
- if (argc == 3) { // Input file given as argument in command line
+    if (opt.listen) { // Answer clients until interrupted
+        
+        basic_calculator<T> calc;
+        calc.enable_cache(opt.cache);
+        calc.set_optimizer(optimization);
+        calc.set_tree_evaluation(opt.tree);
+        
+        try {
+            eval_server<T> server(calc, opt.listen, opt.parallel ? opt.threads : 0);
+            running_server<T>() = &server;
+            signal(SIGINT, stop_server<T>);
+            signal(SIGTERM, stop_server<T>);
+            
+            server.run();
+            
+            running_server<T>() = NULL;
+            cerr << "Answered " << server.requests() << " requests, latency p50 "
+                 << server.latency(50) << " us, p99 " << server.latency(99) << " us" << endl;
+        }
+        catch (const invalid_argument& e) {
+            cerr << "Unable to listen on " << e.what() << endl;
+            exit(1);
+        }
+        
+    }
+    else if (opt.reload && argc == 3) { // Results saved by an earlier run
+        
+        try {
+            // Only the header is read; the results are printed straight
+            // from the mapped file
+            result_file<T> saved(argv[1]);
+            
+            print_heading(opt);
+            saved.write_results(cout, opt.format);
+        }
+        catch (const exception& e) {
+            cerr << "Unable to read saved results " << e.what() << endl;
+            exit(1);
+        }
+        
+    }
+    else if (opt.tolerance && argc == 3) { // Bounds and spread of each line
+        
+        basic_calculator<T> calc;
+        uncertain_evaluator<T> uncertain(calc);
+        T tolerance = (T)strtold(opt.tolerance, NULL);
+        
+        ifstream readf(argv[1]);
+        if (readf.fail()) {
+            cerr << "Unable to open file " << argv[1] << endl;
+            exit(1);
+        }
+        
+        cout << "\nUNCERTAINTY: " << endl;
+        cout << "==============================================================="<< endl;
+        cout << fixed << setprecision(2);
+        
+        string line;
+        while (getline(readf, line)) {
+            try {
+                interval<T> bounds = uncertain.bounds(line, tolerance);
+                sample_summary<T> spread = uncertain.sample(line, tolerance, opt.samples);
+                cout << "[" << bounds.lo << ", " << bounds.hi << "] " << spread.mean
+                     << " +/- " << spread.stddev << " = " << line << '\n';
+            }
+            catch (exception &e) {
+                // If an expression is invalid, output to error stream instead
+                CALC_PROFILE_EXCEPTION();
+                cerr << line << '\n';
+            }
+        }
+        
+    }
+    else if (opt.stream > 0 && argc <= 3) { // Print each result as it is evaluated
+        
+        basic_calculator<T> calc;
+        calc.enable_cache(opt.cache);
+        calc.set_optimizer(optimization);
+        calc.set_tree_evaluation(opt.tree);
+        
+        cout << "\nRESULTS: " << endl;
+        cout << "==============================================================="<< endl;
+        
+        if (argc == 3) {
+            ifstream readf(argv[1]);
+            if (readf.fail()) {
+                cerr << "Unable to open file " << argv[1] << endl;
+                exit(1);
+            }
+            calc.stream(readf, cout, cerr, opt.stream);
+        }
+        else {
+            // Input is read in large blocks instead of a character at a time
+            ios::sync_with_stdio(false);
+            calc.stream(cin, cout, cerr, opt.stream);
+        }
+        
+    }
+    else if (argc == 3) { // Input file given as argument in command line
         
         string fName = argv[1];
         ifstream readf;
         
+        // Invalid lines are printed from the table of invalid lines instead
+        ostream discard(NULL);
+        ostream &err = opt.diagnose ? discard : cerr;
+        
         try {
             // Create new calculator instance from input file
             // Reads and evaluates all expressions in put file
-            calculator calc(fName.c_str(), readf);
+            unsigned threads = opt.parallel ? opt.threads : 1;
+            basic_calculator<T> calc;
+            if (opt.shared) { calc.add_shared(fName, readf, err); }
+            else {
+                calc = opt.mapped ? basic_calculator<T>(fName.c_str(), err, threads, opt.cache, optimization, opt.tree)
+                     : (opt.parallel || opt.cache || opt.optimize || opt.tree) ? basic_calculator<T>(fName.c_str(), readf, err, threads, opt.cache, optimization, opt.tree)
+                     : basic_calculator<T>(fName.c_str(), readf, err);
+            }
+            
+            for (size_t i = 0; opt.diagnose && i<calc.invalid_size(); i++) {
+                const typename basic_calculator<T>::invalid_expression &ie = calc.get_invalid((int)i);
+                cerr << fName << ":" << ie.line + 1 << ":" << ie.column + 1 << ": "
+                     << error_name(ie.kind) << ": " << calc.get_invalid_expression((int)i) << '\n';
+            }
+            cerr.flush();
             
             // Print valid expressions and their results to command line
-            cout << "\nRESULTS: " << endl;
-            cout << "==============================================================="<< endl;
-            cout << calc;
+            print_heading(opt);
+            calc.write_results(cout, opt.format);
+            
+            if (opt.save) {
+                try { calc.save(opt.save); }
+                catch (const invalid_argument& e) {
+                    cerr << "Unable to save results to " << e.what() << endl;
+                    exit(1);
+                }
+            }
         }
         catch (const invalid_argument& e ) {
             
@@ -62,15 +306,19 @@ int main(int argc, const char * argv[]) {
             exit(1);
         }
         
-
+        
     }
     else if (argc < 3){ // No input file given
         string e;
-        calculator calc;
+        basic_calculator<T> calc;
+        calc.enable_cache(opt.cache);
+        calc.set_optimizer(optimization);
+        calc.set_tree_evaluation(opt.tree);
         
         // Get user input from command line until end of file char is reached
         while(!getline(cin,e).eof()) {
             //getline(cin, e);
+            CALC_PROFILE_READ(e.length() + 1);
             
             try {
                 // Add each expression to the calculator class and evaluate
@@ -78,15 +326,24 @@ int main(int argc, const char * argv[]) {
             }
             catch(exception &except) {
                 // If an expression is invalid, output to error stream instead
+                CALC_PROFILE_EXCEPTION();
+                CALC_PROFILE_WRITTEN(e.length() + 1);
                 cerr << e << endl;
             }
         }
         
         // Prints all valid expressions and their results to command line
-        cout << "\nRESULTS: " << endl;
-        cout << "==============================================================="<< endl;
-        cout << calc;
-     
+        print_heading(opt);
+        calc.write_results(cout, opt.format);
+        
+        if (opt.save) {
+            try { calc.save(opt.save); }
+            catch (const invalid_argument& e) {
+                cerr << "Unable to save results to " << e.what() << endl;
+                exit(1);
+            }
+        }
+        
     }
     else { // Error: Too many arguments. Exit with errors
         cerr << "ERROR: Too many arguments passed." << endl;
@@ -95,3 +352,111 @@ int main(int argc, const char * argv[]) {
     
     return 0;
 }
+
+/******************************************************************************
+                                MAIN PROGRAM
+ ******************************************************************************/
+ 
+int main(int argc, const char * argv[]) {
+    
+    // Take options out of the arguments, leaving the program name and file
+    options opt;
+    opt.parallel = false;
+    opt.threads = 0;
+    opt.mapped = false;
+    opt.cache = 0;
+    opt.stream = 0;
+    opt.optimize = 0;
+    opt.shared = false;
+    opt.diagnose = false;
+    opt.tree = 0;
+    opt.save = NULL;
+    opt.reload = false;
+    opt.listen = NULL;
+    opt.tolerance = NULL;
+    opt.samples = 10000;
+    opt.format = OUTPUT_TEXT;
+    char precision = 'f';
+#ifdef CALC_PROFILE
+    bool profile = false;
+    const char *trace = NULL;
+#endif
+    
+    vector<const char *> args;
+    for (int i = 0; i<argc; i++) {
+        string arg = argv[i];
+        if (i > 0 && arg == "-j" && i+1 < argc) {
+            opt.parallel = true;
+            opt.threads = atoi(argv[++i]);
+        }
+        else if (i > 0 && arg == "-c" && i+1 < argc) {
+            opt.cache = strtoul(argv[++i], NULL, 10);
+        }
+        else if (i > 0 && arg == "-s" && i+1 < argc) {
+            opt.stream = strtoul(argv[++i], NULL, 10);
+        }
+        else if (i > 0 && arg == "-m") {
+            opt.mapped = true;
+        }
+        else if (i > 0 && arg == "-O") {
+            opt.optimize = 1;
+        }
+        else if (i > 0 && arg == "-V") {
+            opt.optimize = 2;
+        }
+        else if (i > 0 && arg == "-S") {
+            opt.shared = true;
+        }
+        else if (i > 0 && arg == "-e") {
+            opt.diagnose = true;
+        }
+        else if (i > 0 && arg == "-b" && i+1 < argc) {
+            opt.tree = strtoul(argv[++i], NULL, 10);
+        }
+        else if (i > 0 && arg == "-w" && i+1 < argc) {
+            opt.save = argv[++i];
+        }
+        else if (i > 0 && arg == "-l" && i+1 < argc) {
+            opt.listen = argv[++i];
+        }
+        else if (i > 0 && arg == "-u" && i+1 < argc) {
+            opt.tolerance = argv[++i];
+        }
+        else if (i > 0 && arg == "-n" && i+1 < argc) {
+            opt.samples = strtoul(argv[++i], NULL, 10);
+        }
+        else if (i > 0 && arg == "-f" && i+1 < argc) {
+            string format = argv[++i];
+            opt.format = format == "csv" ? OUTPUT_CSV : format == "json" ? OUTPUT_JSON : OUTPUT_TEXT;
+        }
+        else if (i > 0 && (arg == "-p" || (arg == "-t" && i+1 < argc))) {
+#ifdef CALC_PROFILE
+            profile = true;
+            if (arg == "-t") { trace = argv[++i]; }
+#else
+            cerr << "Profiling is not compiled in, build with -DCALC_PROFILE" << endl;
+            return 1;
+#endif
+        }
+        else if (i > 0 && arg == "-r") {
+            opt.reload = true;
+        }
+        else if (i > 0 && (arg == "-d" || arg == "-L")) {
+            precision = arg[1];
+        }
+        else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = (int)args.size();
+    argv = &args[0];
+    
+#ifdef CALC_PROFILE
+    // Report at exit, so runs that exit on an error are reported too
+    if (profile) { profiler::report_at_exit(trace); }
+#endif
+    
+    if (precision == 'd') { return run_calculator<double>(argc, argv, opt); }
+    else if (precision == 'L') { return run_calculator<long double>(argc, argv, opt); }
+    else { return run_calculator<float>(argc, argv, opt); }
+}
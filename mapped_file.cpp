@@ -0,0 +1,77 @@
+/*****************************************************************************
+ Title:             mapped_file.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Mapped File Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Mapped file constructor. Opens the file, maps all of it and closes the file
+ descriptor again; the mapping stays valid without it. Throws exception if the
+ file cannot be opened or mapped.
+ */
+mapped_file::mapped_file(string fName) throw(invalid_argument) : base(NULL), length(0) {
+    
+    int fd = open(fName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw invalid_argument(fName);
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw invalid_argument(fName);
+    }
+    length = info.st_size;
+    
+    // An empty file cannot be mapped, but has nothing to read either
+    if (length > 0) {
+        void *p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw invalid_argument(fName);
+        }
+        base = (const char *)p;
+        
+        // File is read front to back
+        madvise(p, length, MADV_SEQUENTIAL);
+    }
+    
+    close(fd);
+}
+
+/* Mapped file destructor. Unmaps the file. */
+mapped_file::~mapped_file() {
+    if (base != NULL) {
+        munmap((void *)base, length);
+    }
+}
+
+/* Returns first byte of the file */
+const char *mapped_file::data() const {
+    return base;
+}
+
+/* Returns size of the file */
+size_t mapped_file::size() const {
+    return length;
+}
+
+/* Drops the whole pages inside the given range from memory */
+void mapped_file::release(size_t offset, size_t count) const {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t first = (offset + page - 1) / page * page;
+    size_t last = (offset + count) / page * page;
+    
+    if (base != NULL && first < last) {
+        madvise((void *)(base + first), last - first, MADV_DONTNEED);
+    }
+}
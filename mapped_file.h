@@ -0,0 +1,81 @@
+/*****************************************************************************
+ Title:             mapped_file.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Mapped File Class Definition (Header File)
+                        - Maps a whole file into memory, read only, so it can
+                            be parsed in place without copying it
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___mapped_file__
+#define ___mapped_file__
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+using namespace std;
+
+class mapped_file {
+    
+    const char *base;   // Start of the mapping, NULL for an empty file
+    size_t length;      // Size of the file in bytes
+    
+    // A mapping cannot be copied, only shared
+    mapped_file(const mapped_file &);
+    mapped_file &operator = (const mapped_file &);
+    
+public:
+    
+/******************************************************************************
+    Constructors
+ ******************************************************************************/
+    
+    /* mapped_file(string fName);
+     Constructor that maps the given file into memory.
+        @param  string fName [in]       file name
+     Precondition:      fName is the name and path of a readable file
+     Postcondition:     The contents of the file are readable through data(),
+                        else an invalid_argument exception holding fName is
+                        thrown.
+     */
+    mapped_file(string fName) throw(invalid_argument);
+    
+    /* ~mapped_file();
+     Destructor that unmaps the file.
+     */
+    ~mapped_file();
+    
+/******************************************************************************
+    Accessors
+ ******************************************************************************/
+    
+    /* const char *data() const;
+     Returns a pointer to the first byte of the file. The file is not null
+     terminated.
+     */
+    const char *data() const;
+    
+    /* size_t size() const;
+     Returns the size of the file in bytes.
+     */
+    size_t size() const;
+    
+    /* void release(size_t offset, size_t count) const;
+     Tells the operating system that a range of the file will not be read again
+     soon, so its pages can be dropped from memory. They are read back from
+     the file if they are used again.
+        @param  size_t offset [in]      first byte of the range
+        @param  size_t count [in]       number of bytes in the range
+     Precondition:      offset + count <= size()
+     Postcondition:     Whole pages inside the range may be dropped. The
+                        contents of the file are unchanged.
+     */
+    void release(size_t offset, size_t count) const;
+    
+};
+
+#endif
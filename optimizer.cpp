@@ -0,0 +1,212 @@
+/*****************************************************************************
+ Title:             optimizer.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Expression Optimizer Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "optimizer.h"
+#include <math.h>
+
+/* Optimizer constructor */
+template <class T>
+expression_optimizer<T>::expression_optimizer()
+    : folded_count(0), removed_count(0), reduced_count(0), folding(true) { }
+    
+/* Appends a leaf node. Constants are known exactly; a variable may hold
+ anything.
+ */
+template <class T>
+int expression_optimizer<T>::leaf(opcode op, int arg, T value) {
+    node n;
+    n.op = op;
+    n.arg = arg;
+    n.value = value;
+    n.left = n.right = -1;
+    n.constant = op == calculator_type::PUSH;
+    n.negative_zero = !n.constant || (value == 0 && signbit(value));
+    nodes.push_back(n);
+    return (int)nodes.size() - 1;
+}
+
+/* Returns true if node n is the constant value, with the same sign so +0 and
+ -0 are told apart.
+ */
+template <class T>
+bool expression_optimizer<T>::is_constant(int n, T value) const {
+    return nodes[n].constant && nodes[n].value == value
+        && signbit(nodes[n].value) == signbit(value);
+}
+
+/* Simplifies left op right, or op left if right is -1, as it is added to the
+ tree. Operands are already simplified, so a constant operand is a whole
+ constant subexpression. Constants are folded with execute, so the folded value
+ is exactly what running the program would have computed; division by a
+ constant zero is left in the program so it still fails when run. Each
+ identity returns its operand unchanged, which also holds for infinities and
+ NaN: x*1, 1*x, x/1, x-0 and x^1 always, x+0 and 0+x only if x cannot be -0,
+ since -0+0 is +0.
+ */
+template <class T>
+int expression_optimizer<T>::combine(opcode op, int left, int right) {
+    const node &a = nodes[left];
+    const bool unary = right < 0;
+    
+    // Fold constant subexpression
+    if (folding && a.constant && (unary || nodes[right].constant)
+        && !(op == calculator_type::DIV && nodes[right].value == 0)) {
+        T value = unary ? calculator_type::execute(char(op), a.value)
+                        : calculator_type::execute(char(op), a.value, nodes[right].value);
+        folded_count++;
+        return leaf(calculator_type::PUSH, 0, value);
+    }
+    
+    if (!unary) {
+        switch (op) {
+            case calculator_type::MUL:
+                if (is_constant(right, 1)) { removed_count++; return left; }
+                if (is_constant(left, 1)) { removed_count++; return right; }
+                break;
+            case calculator_type::DIV:
+                if (is_constant(right, 1)) { removed_count++; return left; }
+                break;
+            case calculator_type::ADD:
+                if (is_constant(right, 0) && !a.negative_zero) { removed_count++; return left; }
+                if (is_constant(left, 0) && !nodes[right].negative_zero) { removed_count++; return right; }
+                break;
+            case calculator_type::SUB:
+                if (is_constant(right, 0)) { removed_count++; return left; }
+                break;
+            case calculator_type::POW:
+                if (is_constant(right, 1)) { removed_count++; return left; }
+                if (is_constant(right, 2)) { reduced_count++; return combine(calculator_type::SQR, left, -1); }
+                if (is_constant(right, 0.5)) { reduced_count++; return combine(calculator_type::SQRT, left, -1); }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // Only a sum of two -0, a difference from -0 or the result of an operator
+    // that can change sign may be -0. A square never is.
+    bool negative_zero;
+    switch (op) {
+        case calculator_type::ADD: negative_zero = a.negative_zero && nodes[right].negative_zero; break;
+        case calculator_type::SUB: negative_zero = a.negative_zero; break;
+        case calculator_type::SQR: negative_zero = false; break;
+        default: negative_zero = true; break;
+    }
+    
+    node n;
+    n.op = op;
+    n.arg = 0;
+    n.value = 0;
+    n.left = left;
+    n.right = right;
+    n.constant = false;
+    n.negative_zero = negative_zero;
+    nodes.push_back(n);
+    return (int)nodes.size() - 1;
+}
+
+/* Builds the simplified tree bottom up by running the program on a stack of
+ node indices, then writes the tree back out in postfix order, without
+ recursion so that deeply nested expressions cannot overflow the call stack.
+ Only the constants still used are kept.
+ */
+template <class T>
+void expression_optimizer<T>::optimize(const program &in, program &out) {
+    nodes.clear();
+    stack.clear();
+    
+    for (size_t i = 0; i<in.code.size(); i++) {
+        const instruction &ins = in.code[i];
+        
+        if (ins.op == calculator_type::PUSH) {
+            stack.push_back(leaf(ins.op, 0, in.constants[ins.arg]));
+        }
+        else if (ins.op == calculator_type::LOAD) {
+            stack.push_back(leaf(ins.op, ins.arg, 0));
+        }
+        else if (ins.op == calculator_type::SQR || ins.op == calculator_type::SQRT) {
+            stack.back() = combine(ins.op, stack.back(), -1);
+        }
+        else {
+            int right = stack.back();
+            stack.pop_back();
+            stack.back() = combine(ins.op, stack.back(), right);
+        }
+    }
+    
+    if (&out != &in) { out.variables = in.variables; }
+    out.code.clear();
+    out.constants.clear();
+    out.max_depth = 0;
+    if (stack.empty()) { return; }
+    
+    // Post order walk: each node is pending twice, first to push its
+    // operands, then to emit itself
+    int depth = 0;
+    pending.clear();
+    pending.push_back(make_pair(stack.back(), false));
+    
+    while (!pending.empty()) {
+        pair<int, bool> p = pending.back();
+        pending.pop_back();
+        const node &n = nodes[p.first];
+        
+        if (!p.second && n.left >= 0) {
+            pending.push_back(make_pair(p.first, true));
+            if (n.right >= 0) { pending.push_back(make_pair(n.right, false)); }
+            pending.push_back(make_pair(n.left, false));
+            continue;
+        }
+        
+        instruction ins;
+        ins.op = n.op;
+        ins.arg = n.arg;
+        if (n.constant) {
+            ins.op = calculator_type::PUSH;
+            ins.arg = (int)out.constants.size();
+            out.constants.push_back(n.value);
+            depth++;
+        }
+        else if (n.op == calculator_type::LOAD) { depth++; }
+        else if (n.right >= 0) { depth--; }
+        
+        out.code.push_back(ins);
+        if (depth > out.max_depth) { out.max_depth = depth; }
+    }
+}
+
+/* Sets whether constants are folded */
+template <class T>
+void expression_optimizer<T>::set_folding(bool enabled) {
+    folding = enabled;
+}
+
+/* Returns number of operations folded into constants */
+template <class T>
+size_t expression_optimizer<T>::folded() const {
+    return folded_count;
+}
+
+/* Returns number of identities dropped */
+template <class T>
+size_t expression_optimizer<T>::removed() const {
+    return removed_count;
+}
+
+/* Returns number of powers replaced by a square or square root */
+template <class T>
+size_t expression_optimizer<T>::reduced() const {
+    return reduced_count;
+}
+
+// Compile the optimizer for each value type the calculator supports
+template class expression_optimizer<float>;
+template class expression_optimizer<double>;
+template class expression_optimizer<long double>;
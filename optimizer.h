@@ -0,0 +1,121 @@
+/*****************************************************************************
+ Title:             optimizer.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Expression Optimizer Class Definition (Header File)
+                        - Rebuilds a compiled program as an expression tree
+                        - Folds constant subexpressions, drops the identities
+                            x*1, x/1, x+0, x-0 and x^1 and replaces x^2 and
+                            x^0.5 by a square and a square root
+                        - Writes the tree back out as a compiled program that
+                            gives the same results and errors as the original,
+                            except that a square or square root may differ
+                            from pow in the last bit
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___optimizer__
+#define ___optimizer__
+
+#include <vector>
+#include "calculator.h"
+using namespace std;
+
+template <class T>
+class expression_optimizer {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef typename calculator_type::compiled_expression program;
+    typedef typename calculator_type::instruction instruction;
+    typedef typename calculator_type::opcode opcode;
+    
+    // A node of the expression tree. Leaves are constants and variables,
+    // other nodes are operators with one (left) or two operands.
+    struct node {
+        opcode op;
+        int arg;            // Index of the variable, for LOAD
+        T value;            // Value, for constants
+        int left, right;    // Index of each operand node, or -1
+        bool constant;      // Value is known
+        bool negative_zero; // Value may be -0, so adding 0 is not a no-op
+    };
+    
+    // Nodes of the tree being optimized, reused from one program to the next
+    vector<node> nodes;
+    vector<int> stack;
+    vector<pair<int, bool> > pending;
+    
+    size_t folded_count;
+    size_t removed_count;
+    size_t reduced_count;
+    
+    bool folding;       // Constant subexpressions are folded
+    
+    /* int leaf(opcode op, int arg, T value);
+     Appends a constant or variable node and returns its index.
+     */
+    int leaf(opcode op, int arg, T value);
+    
+    /* int combine(opcode op, int left, int right);
+     Returns the index of a node computing left op right, simplified: a new
+     constant if both are constants, an operand if op is an identity, or a new
+     node otherwise.
+     */
+    int combine(opcode op, int left, int right);
+    
+    /* bool is_constant(int n, T value) const;
+     Returns true if node n is a constant equal to value, with the same sign.
+     */
+    bool is_constant(int n, T value) const;
+    
+public:
+    
+    /* expression_optimizer();
+     Constructor for an optimizer with empty buffers and counters.
+     */
+    expression_optimizer();
+    
+    /* void optimize(const program &in, program &out);
+     Optimizes a compiled program.
+        @param  program &in [in]    program returned by compile
+        @param  program &out [out]  optimized program, which may be in
+     Precondition:      in was returned by compile or optimize
+     Postcondition:     out computes the same result as in for any values of
+                        its variables, except that x^2 and x^0.5 are computed
+                        as x*x and sqrt, which are correctly rounded where pow
+                        may be one unit in the last place off. out fails
+                        whenever in does, e.g. on division by zero.
+                        out.variables is in.variables, so values are bound
+                        the same way. Division by a constant zero is never
+                        folded.
+     */
+    void optimize(const program &in, program &out);
+    
+    /* void set_folding(bool enabled);
+     Sets whether constant subexpressions are folded. Without folding, the
+     identities and the square and square root are still applied, even to
+     constants, so running the result tests them against the original.
+     */
+    void set_folding(bool enabled);
+    
+    /* size_t folded() const;
+       size_t removed() const;
+       size_t reduced() const;
+     Return the number of operations folded into constants, dropped as
+     identities and replaced by a square or square root so far.
+     */
+    size_t folded() const;
+    size_t removed() const;
+    size_t reduced() const;
+    
+};
+
+// Compiled ahead of time in optimizer.cpp
+extern template class expression_optimizer<float>;
+extern template class expression_optimizer<double>;
+extern template class expression_optimizer<long double>;
+
+#endif
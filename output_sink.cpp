@@ -0,0 +1,296 @@
+/*****************************************************************************
+ Title:             output_sink.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Output Sink Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "output_sink.h"
+#include "profiler.h"
+#include <cstdio>
+#include <limits>
+#include <math.h>
+#include <stdint.h>
+
+// Most bytes buffered before they are written, however few the lines
+static const size_t BATCH_BYTES = 1 << 20;
+
+/* Output sink constructor */
+output_sink::output_sink(ostream &os, size_t batch_lines)
+    : os(os), lines(0), batch_lines(batch_lines), rows(0) { }
+    
+/* Output sink destructor. Writes remaining lines. */
+output_sink::~output_sink() {
+    flush();
+}
+
+/* Appends characters to the buffer */
+void output_sink::write(const char *s, size_t n) {
+    buffer.append(s, n);
+}
+
+/* Formats the value with snprintf, which is what ostream's fixed notation
+ uses as well, so the text is the same. Used for values fast_fixed cannot
+ format.
+ */
+static int format_fixed(char *out, size_t size, double value, int precision) {
+    return snprintf(out, size, "%.*f", precision, value);
+}
+
+static int format_fixed(char *out, size_t size, long double value, int precision) {
+    return snprintf(out, size, "%.*Lf", precision, value);
+}
+
+/* Sets hi and lo to the high and low words of the 128-bit product of a and b,
+ from the products of their 32-bit halves
+ */
+static void multiply(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+    uint64_t a_lo = a & 0xffffffffu, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xffffffffu, b_hi = b >> 32;
+    
+    uint64_t low = a_lo * b_lo;
+    uint64_t mid1 = a_hi * b_lo;
+    uint64_t mid2 = a_lo * b_hi;
+    uint64_t carry = ((low >> 32) + (mid1 & 0xffffffffu) + (mid2 & 0xffffffffu)) >> 32;
+    
+    lo = a * b;
+    hi = a_hi * b_hi + (mid1 >> 32) + (mid2 >> 32) + carry;
+}
+
+/* Formats the value the way snprintf does, without it. The value is split
+ exactly into its binary mantissa times a power of 2, giving a 64-bit whole
+ part and a binary fraction. The fraction times 10^precision is found in
+ 128 bits, and rounded on what is shifted out: up past half, to even at
+ exactly half, as snprintf rounds. Returns 0 for a value it cannot format,
+ one that is not finite or 2^64 or more, so the caller uses snprintf.
+ */
+template <class T>
+static int fast_fixed(char *out, T value, int precision) {
+    const int digits = numeric_limits<T>::digits;
+    if (!isfinite(value) || precision < 0 || precision > 18 || digits > 64) { return 0; }
+    
+    uint64_t scale = 1;
+    for (int i = 0; i<precision; i++) { scale *= 10; }
+    
+    // value is mantissa * 2^-shift
+    uint64_t whole = 0, fraction = 0;
+    int shift = 0;
+    if (value != 0) {
+        int exponent;
+        T m = frexp(fabs(value), &exponent);
+        if (exponent > 64) { return 0; }
+        uint64_t mantissa = (uint64_t)ldexp(m, digits);
+        shift = digits - exponent;
+        
+        if (shift <= 0) { whole = mantissa << -shift; }
+        else if (shift < 64) {
+            whole = mantissa >> shift;
+            fraction = mantissa & ((uint64_t(1) << shift) - 1);
+        }
+        else { fraction = mantissa; }
+    }
+    
+    // Decimals of the fraction, and how what is left compares with half
+    uint64_t decimals = 0;
+    int left = -1;
+    if (fraction != 0 && shift < 128) {
+        uint64_t hi, lo;
+        multiply(fraction, scale, hi, lo);
+        if (shift < 64) {
+            decimals = (lo >> shift) | (hi << (64 - shift));
+            uint64_t rest = lo & ((uint64_t(1) << shift) - 1);
+            uint64_t half = uint64_t(1) << (shift - 1);
+            left = rest < half ? -1 : rest > half ? 1 : 0;
+        }
+        else if (shift == 64) {
+            decimals = hi;
+            uint64_t half = uint64_t(1) << 63;
+            left = lo < half ? -1 : lo > half ? 1 : 0;
+        }
+        else {
+            int s = shift - 64;
+            decimals = hi >> s;
+            uint64_t rest = hi & ((uint64_t(1) << s) - 1);
+            uint64_t half = uint64_t(1) << (s - 1);
+            left = rest < half ? -1 : rest > half ? 1 : (lo != 0 ? 1 : 0);
+        }
+    }
+    
+    bool odd = precision > 0 ? (decimals & 1) : (whole & 1);
+    if (left > 0 || (left == 0 && odd)) { decimals++; }
+    if (decimals == scale) {
+        decimals = 0;
+        whole++;
+    }
+    
+    char digits_of[20];
+    int n = 0;
+    do {
+        digits_of[n++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    
+    int length = 0;
+    if (signbit(value)) { out[length++] = '-'; }
+    while (n > 0) { out[length++] = digits_of[--n]; }
+    if (precision > 0) {
+        out[length++] = '.';
+        for (int i = precision - 1; i>=0; i--) {
+            out[length + i] = (char)('0' + decimals % 10);
+            decimals /= 10;
+        }
+        length += precision;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+template <class T>
+void output_sink::write_fixed(T value, int precision) {
+    char local[64];
+    int n = fast_fixed(local, value, precision);
+    if (n > 0) {
+        buffer.append(local, n);
+        return;
+    }
+    
+    n = format_fixed(local, sizeof(local), value, precision);
+    
+    // Very large values do not fit in the local buffer
+    if (n >= (int)sizeof(local)) {
+        string big(n + 1, '\0');
+        format_fixed(&big[0], big.size(), value, precision);
+        buffer.append(big.data(), n);
+    }
+    else if (n > 0) {
+        buffer.append(local, n);
+    }
+}
+
+/* Doubles each quote of a field that needs quotes */
+void output_sink::write_csv(const char *s, size_t n) {
+    bool quote = false;
+    for (size_t i = 0; i<n && !quote; i++) {
+        quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+    }
+    if (!quote) {
+        buffer.append(s, n);
+        return;
+    }
+    
+    buffer += '"';
+    for (size_t i = 0; i<n; i++) {
+        if (s[i] == '"') { buffer += '"'; }
+        buffer += s[i];
+    }
+    buffer += '"';
+}
+
+/* Escapes quotes, backslashes and control characters, copying the runs of
+ characters between them whole
+ */
+void output_sink::write_json(const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    buffer += '"';
+    size_t start = 0;
+    for (size_t i = 0; i<n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') { continue; }
+        
+        buffer.append(s + start, i - start);
+        start = i + 1;
+        if (c == '"' || c == '\\') {
+            buffer += '\\';
+            buffer += (char)c;
+        }
+        else {
+            char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            buffer.append(escape, 6);
+        }
+    }
+    buffer.append(s + start, n - start);
+    buffer += '"';
+}
+
+/* Header line of CSV, opening bracket of JSON */
+void output_sink::begin_results(output_format format) {
+    rows = 0;
+    if (format == OUTPUT_CSV) {
+        write("result,expression", 17);
+        end_line();
+    }
+    else if (format == OUTPUT_JSON) {
+        write("[", 1);
+        end_line();
+    }
+}
+
+/* Writes one result as a line of the format. A JSON object's line is only
+ ended once it is known whether another object, and so a comma, follows it.
+ */
+template <class T>
+void output_sink::write_result(T value, const char *exp, size_t length, output_format format) {
+    if (format == OUTPUT_CSV) {
+        write_fixed(value, 2);
+        write(",", 1);
+        write_csv(exp, length);
+        end_line();
+    }
+    else if (format == OUTPUT_JSON) {
+        if (rows > 0) {
+            write(",", 1);
+            end_line();
+        }
+        write("{\"result\": ", 11);
+        if (isfinite(value)) { write_fixed(value, 2); }
+        else { write("null", 4); }
+        write(", \"expression\": ", 16);
+        write_json(exp, length);
+        write("}", 1);
+    }
+    else {
+        write_fixed(value, 2);
+        write(" = ", 3);
+        write(exp, length);
+        end_line();
+    }
+    rows++;
+}
+
+/* Ends the last JSON object's line and closes the array */
+void output_sink::end_results(output_format format) {
+    if (format == OUTPUT_JSON) {
+        if (rows > 0) { end_line(); }
+        write("]", 1);
+        end_line();
+    }
+}
+
+/* Ends the line and writes the batch once it is full */
+void output_sink::end_line() {
+    buffer += '\n';
+    lines++;
+    if (lines >= batch_lines || buffer.length() >= BATCH_BYTES) { flush(); }
+}
+
+/* Writes the buffer in one go and empties it, keeping its memory */
+void output_sink::flush() {
+    if (!buffer.empty()) {
+        CALC_PROFILE_WRITTEN(buffer.length());
+        os.write(buffer.data(), buffer.length());
+        buffer.clear();
+    }
+    lines = 0;
+    os.flush();
+}
+
+// Compile value formatting for each value type the calculator supports
+template void output_sink::write_fixed(float value, int precision);
+template void output_sink::write_fixed(double value, int precision);
+template void output_sink::write_fixed(long double value, int precision);
+template void output_sink::write_result(float value, const char *exp, size_t length, output_format format);
+template void output_sink::write_result(double value, const char *exp, size_t length, output_format format);
+template void output_sink::write_result(long double value, const char *exp, size_t length, output_format format);
@@ -0,0 +1,118 @@
+/*****************************************************************************
+ Title:             output_sink.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Output Sink Class Definition (Header File)
+                        - Collects output lines in a buffer and writes them
+                            to a stream in a single large write per batch of
+                            lines, instead of flushing every line
+                        - Formats values in fixed notation by hand, with the
+                            same text as snprintf, which is much faster than
+                            going through the stream's formatting
+                        - Writes results as "Result = Expression" lines, or as
+                            CSV or JSON
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___output_sink__
+#define ___output_sink__
+
+#include <iostream>
+#include <string>
+using namespace std;
+
+// How results are written: as "Result = Expression" lines, as CSV with a
+// header line, or as a JSON array with an object for each result
+enum output_format { OUTPUT_TEXT, OUTPUT_CSV, OUTPUT_JSON };
+
+// Lines buffered at a time when a whole list of results is written at once
+const size_t OUTPUT_BATCH_LINES = 4096;
+
+class output_sink {
+    
+    ostream &os;
+    string buffer;          // Lines not yet written
+    size_t lines;           // Number of lines in buffer
+    size_t batch_lines;     // Number of lines to write at once
+    size_t rows;            // Number of results written by write_result
+    
+    // A sink writes to a single stream, it cannot be copied
+    output_sink(const output_sink &);
+    output_sink &operator = (const output_sink &);
+    
+public:
+
+/******************************************************************************
+    Constructors
+ ******************************************************************************/
+    
+    /* output_sink(ostream &os, size_t batch_lines);
+     Constructor for a sink that writes to os.
+        @param  ostream &os [in/out]        stream to write to
+        @param  size_t batch_lines [in]     number of lines to write at once
+     Precondition:      &os is open and initialized, batch_lines > 0
+     Postcondition:     The sink is empty.
+     */
+    output_sink(ostream &os, size_t batch_lines);
+    
+    /* ~output_sink();
+     Destructor that writes any lines left in the buffer.
+     */
+    ~output_sink();
+    
+/******************************************************************************
+    Accessors
+ ******************************************************************************/
+    
+    /* void write(const char *s, size_t n);
+     Appends n characters to the current line.
+     */
+    void write(const char *s, size_t n);
+    
+    /* template <class T> void write_fixed(T value, int precision);
+     Appends a value to the current line in fixed notation with the given
+     number of decimals, exactly as an ostream does with fixed and
+     setprecision.
+     */
+    template <class T> void write_fixed(T value, int precision);
+    
+    /* void write_csv(const char *s, size_t n);
+       void write_json(const char *s, size_t n);
+     Append n characters to the current line as a CSV field, in quotes if it
+     has a comma, quote or line break, or as a JSON string.
+     */
+    void write_csv(const char *s, size_t n);
+    void write_json(const char *s, size_t n);
+    
+    /* void begin_results(output_format format);
+       template <class T> void write_result(T value, const char *exp,
+                                            size_t length,
+                                            output_format format);
+       void end_results(output_format format);
+     Write the header of a list of results, each result with the first length
+     characters of its expression, and the end of the list. A result is
+     written with 2 decimals; in JSON, one that is not finite is null.
+     Precondition:      Every result between begin_results and end_results
+                        is written in the same format.
+     */
+    void begin_results(output_format format);
+    template <class T> void write_result(T value, const char *exp, size_t length, output_format format);
+    void end_results(output_format format);
+    
+    /* void end_line();
+     Ends the current line. Once batch_lines lines, or a megabyte, are
+     buffered, they are written to the stream.
+     */
+    void end_line();
+    
+    /* void flush();
+     Writes all buffered lines to the stream in a single write and flushes it.
+     */
+    void flush();
+    
+};
+
+#endif
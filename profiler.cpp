@@ -0,0 +1,275 @@
+/*****************************************************************************
+ Title:             profiler.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Profiler Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "profiler.h"
+
+#ifdef CALC_PROFILE
+
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <typeinfo>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+
+// Most events kept for each thread, about 24 MB of them
+static const size_t MAX_EVENTS = 1 << 20;
+
+// Names of the phases as reported
+static const char *phase_names[PROFILE_PHASES] = {
+    "read", "compile", "number", "optimize", "execute", "output"
+};
+
+// Counters of every thread that has counted anything. They are never freed,
+// so they can be reported after their thread has finished.
+static mutex registry_lock;
+static vector<profile_counters *> registry;
+
+// Trace file to write at exit, or NULL for a summary
+static const char *trace_path = NULL;
+
+// Time the program started profiling, which is time 0 of the trace
+static uint64_t started = profiler::now();
+
+thread_local profile_counters *profiler::counters = NULL;
+bool profiler::tracing = false;
+
+/* Value initialization zeroes every counter */
+profile_counters *profiler::add_thread() {
+    profile_counters *c = new profile_counters();
+    
+    lock_guard<mutex> lock(registry_lock);
+    c->thread = (unsigned)registry.size();
+    registry.push_back(c);
+    counters = c;
+    return c;
+}
+
+/* Rethrows the exception being handled to find its type, and counts it under
+ its type and message
+ */
+void profiler::count_exception() {
+    string key;
+    try {
+        throw;
+    }
+    catch (exception &e) {
+        int status;
+        char *name = abi::__cxa_demangle(typeid(e).name(), NULL, NULL, &status);
+        key = string(status == 0 ? name : typeid(e).name()) + ": " + e.what();
+        free(name);
+    }
+    catch (...) {
+        key = "unknown exception";
+    }
+    local().exceptions[key]++;
+}
+
+/* Registers report_now to be called by exit or on returning from main */
+void profiler::report_at_exit(const char *trace_file) {
+    trace_path = trace_file;
+    tracing = trace_file != NULL;
+    atexit(report_now);
+}
+
+/* Adds up the counters of every thread, then prints them as a table or writes
+ them to the trace file along with each thread's events
+ */
+void profiler::report_now() {
+    lock_guard<mutex> lock(registry_lock);
+    
+    profile_counters sum = profile_counters();
+    for (size_t t = 0; t<registry.size(); t++) {
+        const profile_counters &c = *registry[t];
+        for (int p = 0; p<PROFILE_PHASES; p++) {
+            sum.calls[p] += c.calls[p];
+            sum.total[p] += c.total[p];
+            sum.self[p] += c.self[p];
+        }
+        for (int op = 0; op<256; op++) { sum.ops[op] += c.ops[op]; }
+        for (int k = 0; k<ERROR_KINDS; k++) { sum.errors[k] += c.errors[k]; }
+        for (int s = 0; s<PROFILE_STACKS; s++) {
+            if (c.depth[s] > sum.depth[s]) { sum.depth[s] = c.depth[s]; }
+        }
+        map<string, uint64_t>::const_iterator it;
+        for (it = c.exceptions.begin(); it != c.exceptions.end(); ++it) {
+            sum.exceptions[it->first] += it->second;
+        }
+        sum.bytes_read += c.bytes_read;
+        sum.bytes_written += c.bytes_written;
+        sum.dropped += c.dropped;
+    }
+    
+    if (!trace_path) {
+        cerr << "\nPROFILE (" << registry.size() << " threads): " << endl;
+        cerr << "===============================================================" << endl;
+        cerr << left << setw(12) << "phase" << right << setw(14) << "calls"
+             << setw(14) << "total ms" << setw(14) << "self ms" << endl;
+        for (int p = 0; p<PROFILE_PHASES; p++) {
+            if (sum.calls[p] == 0) { continue; }
+            cerr << left << setw(12) << phase_names[p] << right << setw(14) << sum.calls[p]
+                 << fixed << setprecision(3) << setw(14) << sum.total[p] / 1e6
+                 << setw(14) << sum.self[p] / 1e6 << endl;
+        }
+        
+        cerr << "\noperator        executed" << endl;
+        for (int op = 0; op<256; op++) {
+            if (sum.ops[op] == 0) { continue; }
+            cerr << left << setw(12) << (char)op << right << setw(14) << sum.ops[op] << endl;
+        }
+        
+        cerr << "\ndeepest stack   values " << sum.depth[PROFILE_VALUE_STACK]
+             << ", operators " << sum.depth[PROFILE_OPERATOR_STACK] << endl;
+        cerr << "bytes           read " << sum.bytes_read << ", written " << sum.bytes_written << endl;
+        
+        cerr << "\n" << left << setw(26) << "error" << "count" << endl;
+        for (int k = 0; k<ERROR_KINDS; k++) {
+            if (sum.errors[k] == 0) { continue; }
+            cerr << left << setw(26) << error_name(error_kind(k)) << right << sum.errors[k] << endl;
+        }
+        
+        if (!sum.exceptions.empty()) { cerr << "\nexceptions" << endl; }
+        map<string, uint64_t>::const_iterator it;
+        for (it = sum.exceptions.begin(); it != sum.exceptions.end(); ++it) {
+            cerr << right << setw(14) << it->second << "  " << it->first << endl;
+        }
+        return;
+    }
+    
+    ofstream out(trace_path);
+    if (out.fail()) {
+        cerr << "Unable to write trace to " << trace_path << endl;
+        return;
+    }
+    
+    // Each phase is a complete event, in microseconds since profiling started
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    char line[256];
+    for (size_t t = 0; t<registry.size(); t++) {
+        const profile_counters &c = *registry[t];
+        snprintf(line, sizeof(line),
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                 first ? "" : ",\n", c.thread, c.thread);
+        out << line;
+        first = false;
+        
+        for (size_t i = 0; i<c.events.size(); i++) {
+            const profile_event &e = c.events[i];
+            snprintf(line, sizeof(line),
+                     ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     phase_names[e.phase], c.thread, (e.start - started) / 1e3, e.duration / 1e3);
+            out << line;
+        }
+    }
+    
+    // Counters that are not events go in the trace's metadata
+    out << "\n],\"otherData\":{";
+    for (int p = 0; p<PROFILE_PHASES; p++) {
+        out << "\"" << phase_names[p] << "_calls\":\"" << sum.calls[p] << "\","
+            << "\"" << phase_names[p] << "_self_ms\":\"" << fixed << setprecision(3) << sum.self[p] / 1e6 << "\",";
+    }
+    for (int op = 0; op<256; op++) {
+        if (sum.ops[op] != 0) { out << "\"op " << (char)op << "\":\"" << sum.ops[op] << "\","; }
+    }
+    for (int k = 0; k<ERROR_KINDS; k++) {
+        if (sum.errors[k] != 0) { out << "\"" << error_name(error_kind(k)) << "\":\"" << sum.errors[k] << "\","; }
+    }
+    map<string, uint64_t>::const_iterator it;
+    for (it = sum.exceptions.begin(); it != sum.exceptions.end(); ++it) {
+        out << "\"";
+        for (size_t i = 0; i<it->first.length(); i++) {
+            char ch = it->first[i];
+            if (ch == '"' || ch == '\\') { out << '\\'; }
+            out << ch;
+        }
+        out << "\":\"" << it->second << "\",";
+    }
+    out << "\"deepest_value_stack\":\"" << sum.depth[PROFILE_VALUE_STACK] << "\","
+        << "\"deepest_operator_stack\":\"" << sum.depth[PROFILE_OPERATOR_STACK] << "\","
+        << "\"bytes_read\":\"" << sum.bytes_read << "\","
+        << "\"bytes_written\":\"" << sum.bytes_written << "\","
+        << "\"events_dropped\":\"" << sum.dropped << "\"}}\n";
+}
+
+/* Adds the time to the phase, and to the phase this one is inside, which
+ takes it out of that one's self time
+ */
+profile_scope::~profile_scope() {
+    uint64_t duration = profiler::now() - start;
+    profile_counters &c = profiler::local();
+    
+    c.calls[phase]++;
+    c.total[phase] += duration;
+    c.self[phase] += duration - children;
+    if (parent) { parent->children += duration; }
+    c.current = parent;
+    
+    if (profiler::tracing) {
+        if (c.events.size() < MAX_EVENTS) {
+            profile_event e;
+            e.start = start;
+            e.duration = duration;
+            e.phase = phase;
+            c.events.push_back(e);
+        }
+        else {
+            c.dropped++;
+        }
+    }
+}
+
+/* Counting buffer constructor */
+counting_buffer::counting_buffer(streambuf *target) : target(target), bytes(0) {
+    setp(buffer, buffer + sizeof(buffer));
+}
+
+/* Counts the buffered characters and writes them to the target */
+bool counting_buffer::send() {
+    streamsize n = pptr() - pbase();
+    bytes += n;
+    setp(buffer, buffer + sizeof(buffer));
+    return n == 0 || target->sputn(buffer, n) == n;
+}
+
+/* Called when the buffer is full */
+int counting_buffer::overflow(int ch) {
+    if (!send()) { return traits_type::eof(); }
+    if (ch != traits_type::eof()) {
+        *pptr() = (char)ch;
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+/* Called when the stream is flushed */
+int counting_buffer::sync() {
+    if (!send()) { return -1; }
+    return target->pubsync();
+}
+
+/* Swaps the buffer in, keeping the stream's state */
+profile_stream::profile_stream(ostream &os) : os(os), saved(os.rdbuf()), counter(os.rdbuf()) {
+    ios::iostate state = os.rdstate();
+    os.rdbuf(&counter);
+    os.clear(state);
+}
+
+/* Sends what is left in the counting buffer and swaps the stream's back */
+profile_stream::~profile_stream() {
+    ios::iostate state = os.rdstate();
+    counter.pubsync();
+    os.rdbuf(saved);
+    os.clear(state);
+    profiler::count_written(counter.bytes);
+}
+
+#endif
@@ -0,0 +1,270 @@
+/*****************************************************************************
+ Title:             profiler.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Profiler Class Definition (Header File)
+                        - Times each phase of evaluating a file: reading it,
+                            compiling, scanning numbers, optimizing, running
+                            programs and writing the results
+                        - Counts how often each operator is executed, the
+                            deepest value and operator stacks, the errors that
+                            rejected expressions, by kind, and the exceptions
+                            thrown, by type and message, and the bytes read
+                            and written
+                        - Prints a summary, or writes a Chrome trace of every
+                            timed phase, when the program exits
+ 
+                    Only compiled in when CALC_PROFILE is defined, e.g. with
+                    g++ -DCALC_PROFILE, for every file of the program. Without
+                    it the CALC_PROFILE macros below expand to nothing and
+                    the calculator runs exactly as before.
+ 
+                    Each thread counts into its own counters, so counting
+                    takes no locks. The counters of every thread are added up
+                    when they are reported.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___profiler__
+#define ___profiler__
+
+#include <iostream>
+#include "diagnostic.h"
+using namespace std;
+
+// Timed phases. A phase timed inside another, as number inside compile, is
+// counted in the total of both but in the self time of the inner one only.
+enum profile_phase {
+    PROFILE_READ,               // Reading input
+    PROFILE_COMPILE,            // Tokenizing and ordering operators
+    PROFILE_NUMBER,             // Converting numeric literals
+    PROFILE_OPTIMIZE,
+    PROFILE_EXECUTE,            // Running programs
+    PROFILE_OUTPUT,             // Formatting and writing results
+    PROFILE_PHASES
+};
+
+// Stacks whose deepest point is recorded
+enum profile_stack {
+    PROFILE_VALUE_STACK,
+    PROFILE_OPERATOR_STACK,
+    PROFILE_STACKS
+};
+
+#ifdef CALC_PROFILE
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+class profile_scope;
+
+// A timed phase of one thread, kept when a trace is requested
+struct profile_event {
+    uint64_t start;                 // Nanoseconds
+    uint64_t duration;
+    profile_phase phase;
+};
+
+// Counters of one thread. Times are in nanoseconds.
+struct profile_counters {
+    unsigned thread;                // Order the thread first counted in
+    uint64_t calls[PROFILE_PHASES];
+    uint64_t total[PROFILE_PHASES];
+    uint64_t self[PROFILE_PHASES];  // Total less the phases inside
+    uint64_t ops[256];              // Executions of each opcode
+    size_t depth[PROFILE_STACKS];
+    uint64_t errors[ERROR_KINDS];
+    map<string, uint64_t> exceptions;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    vector<profile_event> events;
+    uint64_t dropped;               // Events past the most kept
+    profile_scope *current;         // Innermost phase being timed
+};
+
+class profiler {
+    
+    // Counters of the calling thread, registered on first use
+    static thread_local profile_counters *counters;
+    
+    /* static profile_counters *add_thread();
+     Creates and registers the counters of the calling thread.
+     */
+    static profile_counters *add_thread();
+    
+    /* static void report_now();
+     Prints the summary or writes the trace requested, called at exit.
+     */
+    static void report_now();
+    
+public:
+    
+    // Set when a trace is requested, so phases are recorded as events
+    static bool tracing;
+    
+    /* static profile_counters &local();
+     Returns the counters of the calling thread.
+     */
+    static profile_counters &local() {
+        return counters ? *counters : *add_thread();
+    }
+    
+    /* static uint64_t now();
+     Returns the time of a steady clock in nanoseconds.
+     */
+    static uint64_t now() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    /* static void count_op(char op, uint64_t n);
+       static void count_depth(profile_stack s, size_t depth);
+       static void count_read(uint64_t bytes);
+       static void count_error(error_kind kind);
+       static void count_written(uint64_t bytes);
+     Count n executions of an operator, a stack reaching depth, bytes of
+     input read, an expression rejected without throwing and bytes of output
+     written.
+     */
+    static void count_op(char op, uint64_t n) { local().ops[(unsigned char)op] += n; }
+    static void count_depth(profile_stack s, size_t depth) {
+        size_t &deepest = local().depth[s];
+        if (depth > deepest) { deepest = depth; }
+    }
+    static void count_read(uint64_t bytes) { local().bytes_read += bytes; }
+    static void count_error(error_kind kind) { local().errors[kind]++; }
+    static void count_written(uint64_t bytes) { local().bytes_written += bytes; }
+    
+    /* static void count_exception();
+     Counts the exception being handled by the enclosing catch block.
+     Precondition:      called inside a catch block
+     */
+    static void count_exception();
+    
+    /* static void report_at_exit(const char *trace_file);
+     Prints a summary of every thread's counters to cerr when the program
+     exits, or writes them as a Chrome trace to trace_file if it is not NULL.
+     Every timed phase is then recorded as an event, so a trace can be loaded
+     in chrome://tracing or Perfetto and shows the phases of each thread on a
+     timeline.
+     */
+    static void report_at_exit(const char *trace_file);
+    
+};
+
+// Times the phase from its construction to the end of the enclosing block
+class profile_scope {
+    
+    friend class profiler;
+    
+    profile_phase phase;
+    uint64_t start;
+    uint64_t children;              // Time spent in phases timed inside this one
+    profile_scope *parent;
+    
+    profile_scope(const profile_scope &);
+    profile_scope &operator = (const profile_scope &);
+    
+public:
+    
+    /* profile_scope(profile_phase phase);
+     Starts timing phase on the calling thread.
+     */
+    profile_scope(profile_phase phase) : phase(phase), children(0) {
+        profile_counters &c = profiler::local();
+        parent = c.current;
+        c.current = this;
+        start = profiler::now();
+    }
+    
+    /* ~profile_scope();
+     Adds the time since construction to the phase, and records it as an
+     event if a trace was requested.
+     */
+    ~profile_scope();
+    
+};
+
+// Counts the bytes written to a stream it is put in front of. Keeps them in
+// its own buffer, so each character written is not a call to the stream's.
+class counting_buffer : public streambuf {
+    
+    streambuf *target;
+    char buffer[4096];
+    
+    /* bool send();
+     Passes the buffered characters on to the target.
+     */
+    bool send();
+    
+protected:
+    
+    int overflow(int ch);
+    int sync();
+    
+public:
+    
+    uint64_t bytes;
+    
+    /* counting_buffer(streambuf *target);
+     Constructor for a buffer that passes everything on to target.
+     */
+    counting_buffer(streambuf *target);
+    
+};
+
+// Counts the bytes written to a stream from its construction to the end of
+// the enclosing block
+class profile_stream {
+    
+    ostream &os;
+    streambuf *saved;
+    counting_buffer counter;
+    
+    profile_stream(const profile_stream &);
+    profile_stream &operator = (const profile_stream &);
+    
+public:
+    
+    /* profile_stream(ostream &os);
+     Puts a counting buffer in front of the stream's buffer.
+     */
+    profile_stream(ostream &os);
+    
+    /* ~profile_stream();
+     Puts the stream's buffer back and adds the bytes written.
+     */
+    ~profile_stream();
+    
+};
+
+#define CALC_PROFILE_SCOPE(phase)       profile_scope calc_profile_scope(phase)
+#define CALC_PROFILE_OP(op)             profiler::count_op(op, 1)
+#define CALC_PROFILE_OPS(op, n)         profiler::count_op(op, n)
+#define CALC_PROFILE_DEPTH(s, depth)    profiler::count_depth(s, depth)
+#define CALC_PROFILE_EXCEPTION()        profiler::count_exception()
+#define CALC_PROFILE_ERROR(kind)        profiler::count_error(kind)
+#define CALC_PROFILE_READ(bytes)        profiler::count_read(bytes)
+#define CALC_PROFILE_WRITTEN(bytes)     profiler::count_written(bytes)
+#define CALC_PROFILE_STREAM(os)         profile_stream calc_profile_stream(os)
+
+#else
+
+#define CALC_PROFILE_SCOPE(phase)
+#define CALC_PROFILE_OP(op)
+#define CALC_PROFILE_OPS(op, n)
+#define CALC_PROFILE_DEPTH(s, depth)
+#define CALC_PROFILE_EXCEPTION()
+#define CALC_PROFILE_ERROR(kind)
+#define CALC_PROFILE_READ(bytes)
+#define CALC_PROFILE_WRITTEN(bytes)
+#define CALC_PROFILE_STREAM(os)
+
+#endif
+
+#endif
@@ -0,0 +1,177 @@
+/*****************************************************************************
+ Title:             result_cache.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Result Cache Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "result_cache.h"
+#include <ctype.h>
+#include <functional>
+
+/* Result cache constructor. Splits the capacity as evenly as it can over the
+ shards, using no more shards than entries.
+ */
+template <class T>
+result_cache<T>::result_cache(size_t capacity)
+    : hit_count(0), miss_count(0), eviction_count(0) {
+    
+    if (capacity == 0) { capacity = 1; }
+    total_capacity = capacity;
+    shards_used = capacity < shard_count ? capacity : shard_count;
+    
+    // The first capacity % shards_used shards hold one more entry
+    for (size_t i = 0; i<shard_count; i++) {
+        shards[i].hand = 0;
+        shards[i].capacity = i < shards_used ? capacity / shards_used + (i < capacity % shards_used) : 0;
+        shards[i].entries.reserve(shards[i].capacity);
+    }
+}
+
+/* Returns the shard a key hashes to */
+template <class T>
+typename result_cache<T>::shard &result_cache<T>::shard_of(const string &key) {
+    return shards[hash<string>()(key) % shards_used];
+}
+
+/* Returns true if c can be part of a number or a name */
+static bool word_character(char c) {
+    return isalnum(c) || c == '_' || c == '.';
+}
+
+/* Returns true if after would complete the exponent of a number at the end of
+ key, as in 2e- 3: the number scanner only takes an exponent whose sign is
+ followed directly by a digit, so the space must be kept or the key would be
+ that of the literal 2e-3
+ */
+static bool splits_exponent(const string &key, char after) {
+    size_t n = key.length();
+    if (!isdigit(after) || n < 3) { return false; }
+    char sign = key[n-1], e = key[n-2], mantissa = key[n-3];
+    return (sign == '+' || sign == '-') && (e == 'e' || e == 'E')
+        && (isdigit(mantissa) || mantissa == '.');
+}
+
+/* Copies the expression without its spaces. A run of spaces is kept as a
+ single space if the characters on either side of it would otherwise join
+ into a different token, or into an exponent the text did not have.
+ */
+template <class T>
+void result_cache<T>::normalize(const char *exp, size_t length, string &key) {
+    key.clear();
+    
+    for (size_t i = 0; i<length; i++) {
+        if (exp[i] != ' ') {
+            key += exp[i];
+            continue;
+        }
+        
+        // Skip run of spaces, then look at the characters around it
+        size_t j = i;
+        while (j < length && exp[j] == ' ') { j++; }
+        
+        if (!key.empty() && j < length) {
+            char before = key[key.length()-1];
+            char after = exp[j];
+            
+            bool joins_token = word_character(before) && word_character(after);
+            bool joins_exponent = (before == 'e' || before == 'E') && (after == '+' || after == '-');
+            if (joins_token || joins_exponent || splits_exponent(key, after)) { key += ' '; }
+        }
+        i = j-1;
+    }
+}
+
+/* Finds the key in its shard and marks the entry as recently used */
+template <class T>
+bool result_cache<T>::lookup(const string &key, T &value, diagnostic &error) {
+    shard &s = shard_of(key);
+    lock_guard<mutex> lk(s.lock);
+    
+    typename unordered_map<string, size_t>::iterator it = s.index.find(key);
+    if (it == s.index.end()) {
+        miss_count++;
+        return false;
+    }
+    
+    entry &e = s.entries[it->second];
+    e.referenced = true;
+    value = e.value;
+    error = e.error;
+    hit_count++;
+    return true;
+}
+
+/* Adds the key to its shard. If the shard is full, the clock hand sweeps over
+ the entries, clearing the referenced flag of each, until it finds one that
+ has not been used since it last passed; that entry is evicted and its slot
+ reused.
+ */
+template <class T>
+void result_cache<T>::insert(const string &key, T value, const diagnostic &error) {
+    shard &s = shard_of(key);
+    lock_guard<mutex> lk(s.lock);
+    
+    size_t slot;
+    typename unordered_map<string, size_t>::iterator it = s.index.find(key);
+    
+    if (it != s.index.end()) {
+        // Another thread cached it first, overwrite
+        slot = it->second;
+    }
+    else if (s.entries.size() < s.capacity) {
+        slot = s.entries.size();
+        s.entries.push_back(entry());
+        it = s.index.insert(make_pair(key, slot)).first;
+    }
+    else {
+        while (s.entries[s.hand].referenced) {
+            s.entries[s.hand].referenced = false;
+            s.hand = (s.hand + 1) % s.entries.size();
+        }
+        slot = s.hand;
+        s.hand = (s.hand + 1) % s.entries.size();
+        
+        s.index.erase(*s.entries[slot].key);
+        eviction_count++;
+        it = s.index.insert(make_pair(key, slot)).first;
+    }
+    
+    entry &e = s.entries[slot];
+    e.key = &it->first;
+    e.value = value;
+    e.error = error;
+    e.referenced = false;
+}
+
+/* Returns number of lookups that hit */
+template <class T>
+size_t result_cache<T>::hits() const {
+    return hit_count;
+}
+
+/* Returns number of lookups that missed */
+template <class T>
+size_t result_cache<T>::misses() const {
+    return miss_count;
+}
+
+/* Returns number of entries evicted */
+template <class T>
+size_t result_cache<T>::evictions() const {
+    return eviction_count;
+}
+
+/* Returns most entries the cache holds */
+template <class T>
+size_t result_cache<T>::capacity() const {
+    return total_capacity;
+}
+
+// Compile the cache for each value type the calculator supports
+template class result_cache<float>;
+template class result_cache<double>;
+template class result_cache<long double>;
@@ -0,0 +1,155 @@
+/*****************************************************************************
+ Title:             result_cache.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Result Cache Class Definition (Header File)
+                        - Remembers the result, or the error, of recently
+                            evaluated expressions, keyed by their normalized
+                            text
+                        - Holds a bounded number of entries and evicts the
+                            least recently used ones with the CLOCK algorithm
+                        - Safe to use from many threads at once
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___result_cache__
+#define ___result_cache__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "diagnostic.h"
+using namespace std;
+
+template <class T>
+class result_cache {
+    
+    // A cached result. error is set instead of value if the expression is
+    // invalid.
+    struct entry {
+        const string *key;      // Key of the entry in the shard's index
+        T value;
+        diagnostic error;
+        bool referenced;        // Used since the clock hand last passed
+    };
+    
+    // The cache is split into shards by key, each with its own lock, so
+    // threads rarely wait on each other
+    struct shard {
+        mutex lock;
+        unordered_map<string, size_t> index;    // Key to slot in entries
+        vector<entry> entries;
+        size_t hand;                            // Next slot to consider
+        size_t capacity;                        // Most entries it holds
+    };
+    
+    // A small cache uses fewer shards, so each holds at least one entry
+    static const size_t shard_count = 16;
+    shard shards[shard_count];
+    size_t shards_used;
+    size_t total_capacity;
+    
+    atomic<size_t> hit_count;
+    atomic<size_t> miss_count;
+    atomic<size_t> eviction_count;
+    
+    // A cache cannot be copied, only shared
+    result_cache(const result_cache &);
+    result_cache &operator = (const result_cache &);
+    
+    /* shard &shard_of(const string &key);
+     Returns the shard a key belongs to.
+     */
+    shard &shard_of(const string &key);
+    
+public:
+
+/******************************************************************************
+    Constructors
+ ******************************************************************************/
+    
+    /* result_cache(size_t capacity);
+     Constructor for an empty cache.
+        @param  size_t capacity [in]    most entries to hold at once
+     Precondition:      capacity > 0
+     Postcondition:     The cache is empty and holds at most capacity
+                        entries, split as evenly as possible over up to 16
+                        shards.
+     */
+    result_cache(size_t capacity);
+    
+/******************************************************************************
+    Accessors
+ ******************************************************************************/
+    
+    /* static void normalize(const char *exp, size_t length, string &key);
+     Builds the key of an expression by removing its spaces, except where
+     removing one would change what the expression means: between two
+     characters of numbers or names, e.g. "12 13", between an 'e' and a
+     sign, e.g. "2e -3", and between the sign of an exponent and its digits,
+     e.g. "2e- 3". Only spaces are removed; any other character is part
+     of the key, so invalid expressions stay invalid.
+        @param  char *exp [in]          expression to normalize
+        @param  size_t length [in]      number of characters in exp
+        @param  string &key [out]       normalized text of exp
+     Precondition:      none
+     Postcondition:     key holds the normalized text. Expressions with the
+                        same key have the same result.
+     */
+    static void normalize(const char *exp, size_t length, string &key);
+    
+    /* bool lookup(const string &key, T &value, diagnostic &error);
+     Looks up the result of an expression.
+        @param  string &key [in]            normalized expression
+        @param  T &value [out]              cached result
+        @param  diagnostic &error [out]     cached error, if the expression
+                                                is invalid
+        @return bool [out]                  true if the key is cached
+     Precondition:      key was built by normalize
+     Postcondition:     On a hit, returns true and sets either value, with
+                        error of kind ERROR_NONE, or error. Counts a hit or a
+                        miss.
+     */
+    bool lookup(const string &key, T &value, diagnostic &error);
+    
+    /* void insert(const string &key, T value, const diagnostic &error);
+     Caches the result or error of an expression, evicting another entry if
+     the cache is full.
+        @param  string &key [in]            normalized expression
+        @param  T value [in]                result, if valid
+        @param  diagnostic &error [in]      error, of kind ERROR_NONE if
+                                                valid
+     Precondition:      key was built by normalize
+     Postcondition:     key is cached. If an entry had to be evicted, it is
+                        counted.
+     */
+    void insert(const string &key, T value, const diagnostic &error);
+    
+    /* size_t hits() const;
+       size_t misses() const;
+       size_t evictions() const;
+     Return the number of lookups that found their key, the number that did
+     not and the number of entries evicted to make room.
+     */
+    size_t hits() const;
+    size_t misses() const;
+    size_t evictions() const;
+    
+    /* size_t capacity() const;
+     Returns the most entries the cache holds.
+     */
+    size_t capacity() const;
+    
+};
+
+// Compiled ahead of time in result_cache.cpp
+extern template class result_cache<float>;
+extern template class result_cache<double>;
+extern template class result_cache<long double>;
+
+#endif
@@ -0,0 +1,120 @@
+/*****************************************************************************
+ Title:             result_file.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Result File Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "result_file.h"
+#include "profiler.h"
+#include <cstring>
+
+/* Maps the file and checks that its header describes sections that lie
+ inside it, in order, and that the expressions lie inside the strings
+ */
+template <class T>
+result_file<T>::result_file(string fName) throw(invalid_argument)
+    : file(new mapped_file(fName)) {
+    
+    result_file_header h;
+    if (file->size() < sizeof(h)) { throw invalid_argument(fName + " is not a result file"); }
+    memcpy(&h, file->data(), sizeof(h));
+    
+    if (memcmp(h.magic, "CALCRES", 8) != 0) {
+        throw invalid_argument(fName + " is not a result file");
+    }
+    if (h.byte_order != 0x01020304) {
+        throw invalid_argument(fName + " was saved on a machine of another byte order");
+    }
+    if (h.value_size != sizeof(T)) {
+        throw invalid_argument(fName + " holds values of another type");
+    }
+    
+    // Each section starts where the one before it ends, or later. Every offset
+    // is checked against the file size before anything is subtracted from it,
+    // and counts are compared with the room left, so nothing can overflow.
+    uint64_t size = file->size();
+    if (h.results < sizeof(h) || h.results > size || h.results % sizeof(uint64_t) != 0
+        || h.count > (size - h.results) / sizeof(T)
+        || h.offsets < h.results || h.offsets > size || h.offsets % sizeof(uint64_t) != 0
+        || h.count > (h.offsets - h.results) / sizeof(T)
+        || h.count >= (size - h.offsets) / sizeof(uint64_t)
+        || h.strings < h.offsets || h.strings > size
+        || h.count >= (h.strings - h.offsets) / sizeof(uint64_t)
+        || h.strings_size > size - h.strings) {
+        throw invalid_argument(fName + " is damaged");
+    }
+    
+    results = file->data() + h.results;
+    offsets = (const uint64_t *)(file->data() + h.offsets);
+    strings = file->data() + h.strings;
+    count = h.count;
+    
+    // Each expression ends where the next begins, inside the strings
+    if (offsets[0] != 0 || offsets[count] != h.strings_size) {
+        throw invalid_argument(fName + " is damaged");
+    }
+    for (size_t i = 0; i<count; i++) {
+        if (offsets[i] > offsets[i+1]) { throw invalid_argument(fName + " is damaged"); }
+    }
+}
+
+/* Returns the number of expressions */
+template <class T>
+size_t result_file<T>::size() const {
+    return count;
+}
+
+/* Copies the result out of the results column */
+template <class T>
+T result_file<T>::get_result(int exp_id) const {
+    T result;
+    memcpy(&result, results + exp_id * sizeof(T), sizeof(T));
+    return result;
+}
+
+/* Returns a copy of the expression's range of the strings */
+template <class T>
+string result_file<T>::get_expression(int exp_id) const throw(out_of_range) {
+    uint64_t begin = offsets[exp_id];
+    uint64_t end = offsets[exp_id + 1];
+    if (begin > end || end > offsets[count]) { throw out_of_range("Expression is not inside the file"); }
+    return string(strings + begin, end - begin);
+}
+
+/* Writes each line the way the calculator's write_results does, with the text
+ of each expression straight from the file
+ */
+template <class T>
+void result_file<T>::write_results(ostream &os, output_format format) const throw(out_of_range) {
+    CALC_PROFILE_SCOPE(PROFILE_OUTPUT);
+    
+    output_sink sink(os, OUTPUT_BATCH_LINES);
+    sink.begin_results(format);
+    for (size_t i = 0; i<count; i++) {
+        uint64_t begin = offsets[i];
+        uint64_t end = offsets[i+1];
+        if (begin > end || end > offsets[count]) { throw out_of_range("Expression is not inside the file"); }
+        
+        sink.write_result(get_result((int)i), strings + begin, end - begin, format);
+    }
+    sink.end_results(format);
+}
+
+/* Prints each line the way the calculator's operator << does */
+template <class T>
+ostream &operator << (ostream &os, const result_file<T> &f) {
+    f.write_results(os, OUTPUT_TEXT);
+    return os;
+}
+
+// Result files of each calculator
+template class result_file<float>;
+template class result_file<double>;
+template class result_file<long double>;
+template ostream &operator << (ostream &os, const result_file<float> &f);
+template ostream &operator << (ostream &os, const result_file<double> &f);
+template ostream &operator << (ostream &os, const result_file<long double> &f);
@@ -0,0 +1,135 @@
+/*****************************************************************************
+ Title:             result_file.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Result File Class Definition (Header File)
+                        - Binary file of the expressions of a calculator and
+                            their results, written by basic_calculator::save
+                        - Maps a saved file into memory and reads any result
+                            or expression straight out of it, without reading
+                            the whole file first
+ 
+                    A file holds, in the byte order of the machine that wrote
+                    it:
+                        header      result_file_header, 64 bytes
+                        results     count values of type T, at results
+                        offsets     count+1 64 bit offsets into the strings,
+                                    at offsets; expression i is the strings
+                                    from offsets[i] to offsets[i+1]
+                        strings     text of every expression, one after the
+                                    other, at strings
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___result_file__
+#define ___result_file__
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <stdint.h>
+#include "mapped_file.h"
+#include "output_sink.h"
+using namespace std;
+
+// First bytes of a result file
+struct result_file_header {
+    char magic[8];              // "CALCRES", null terminated
+    uint32_t byte_order;        // 0x01020304 as written
+    uint32_t value_size;        // sizeof(T)
+    uint64_t count;             // Number of expressions
+    uint64_t results;           // Offset of each section from the start of
+    uint64_t offsets;           // the file
+    uint64_t strings;
+    uint64_t strings_size;
+    uint64_t reserved;
+};
+
+template <class T> class result_file;
+template <class T> ostream &operator << (ostream &os, const result_file<T> &f);
+
+template <class T>
+class result_file {
+    
+    shared_ptr<mapped_file> file;
+    const char *results;
+    const uint64_t *offsets;
+    const char *strings;
+    size_t count;
+    
+public:
+
+/******************************************************************************
+    Constructors
+ ******************************************************************************/
+    
+    /* result_file(string fName);
+     Constructor that maps a file written by basic_calculator::save. Only the
+     header and where each expression starts are checked; results and text
+     are not read until they are asked for.
+        @param  string fName [in]       file name
+     Precondition:      fName is the name and path of a file saved by a
+                        calculator whose values are of type T, that is not
+                        changed while this object exists
+     Postcondition:     The results and expressions of the file can be read,
+                        else an invalid_argument exception is thrown if the
+                        file cannot be opened, is not a result file, was
+                        written on a machine of another byte order, holds
+                        values of another type or is damaged.
+     */
+    result_file(string fName) throw(invalid_argument);
+    
+/******************************************************************************
+    Accessors
+ ******************************************************************************/
+    
+    /* size_t size() const;
+     Returns the number of expressions in the file.
+     */
+    size_t size() const;
+    
+    /* T get_result(int exp_id) const;
+     Returns the result of the (exp_id)th expression of the file.
+     Precondition:      0 <= exp_id < size()
+     */
+    T get_result(int exp_id) const;
+    
+    /* string get_expression(int exp_id) const;
+     Returns the (exp_id)th expression of the file.
+     Precondition:      0 <= exp_id < size()
+     Postcondition:     Throws an out_of_range exception if the offsets of
+                        the expression are not inside the file.
+     */
+    string get_expression(int exp_id) const throw(out_of_range);
+    
+    /* friend ostream &operator << (ostream &os, const result_file &f);
+     Prints each expression of the file and its result on a single line as
+     "Result = Expression", as the calculator that saved it would.
+     */
+    friend ostream &operator << <>(ostream &os, const result_file &f);
+    
+    /* void write_results(ostream &os, output_format format=OUTPUT_TEXT)
+                          const;
+     Prints each expression of the file and its result as operator << does,
+     or as CSV or JSON, as the calculator's write_results would.
+     Postcondition:     Throws an out_of_range exception if the offsets of
+                        an expression are not inside the file, once the
+                        lines before it are written.
+     */
+    void write_results(ostream &os, output_format format=OUTPUT_TEXT) const throw(out_of_range);
+    
+};
+
+// Compiled ahead of time in result_file.cpp
+extern template class result_file<float>;
+extern template class result_file<double>;
+extern template class result_file<long double>;
+extern template ostream &operator << (ostream &os, const result_file<float> &f);
+extern template ostream &operator << (ostream &os, const result_file<double> &f);
+extern template ostream &operator << (ostream &os, const result_file<long double> &f);
+
+#endif
@@ -0,0 +1,162 @@
+/*****************************************************************************
+ Title:             shared_dag.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Shared Expression DAG Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "shared_dag.h"
+#include <functional>
+#include <math.h>
+
+/* Nodes are the same if they apply the same operator to the same operands,
+ or are equal constants of the same sign.
+ */
+template <class T>
+bool shared_dag<T>::node_key::operator == (const node_key &other) const {
+    return op == other.op && left == other.left && right == other.right
+        && value == other.value && signbit(value) == signbit(other.value);
+}
+
+/* Combines the hashes of each part of the key */
+template <class T>
+size_t shared_dag<T>::node_hash::operator () (const node_key &key) const {
+    size_t h = hash<T>()(key.value);
+    h = h * 31 + (unsigned char)key.op;
+    h = h * 1000003 + (size_t)key.left;
+    h = h * 1000003 + (size_t)key.right;
+    return h;
+}
+
+/* Shared DAG constructor */
+template <class T>
+shared_dag<T>::shared_dag()
+    : evaluated(0), expression_count(0), reference_count(0), released_count(0) { }
+
+/* Looks the node up, adding it if it is not in the graph yet */
+template <class T>
+int shared_dag<T>::intern(char op, int left, int right, T value) {
+    reference_count++;
+    
+    node_key key;
+    key.op = op;
+    key.left = left;
+    key.right = right;
+    key.value = value;
+    
+    typename unordered_map<node_key, int, node_hash>::iterator it = index.find(key);
+    if (it != index.end()) { return it->second; }
+    
+    node n;
+    n.op = op;
+    n.left = left;
+    n.right = right;
+    n.value = value;
+    n.failed = false;
+    nodes.push_back(n);
+    
+    int id = (int)nodes.size() - 1;
+    index.insert(make_pair(key, id));
+    return id;
+}
+
+/* Runs the program on a stack of node indices, interning a node for each
+ instruction
+ */
+template <class T>
+int shared_dag<T>::add(const program &prog) throw(invalid_argument) {
+    if (!prog.variables.empty()) {
+        throw invalid_argument("Unbound variable " + prog.variables[0]);
+    }
+    
+    stack.clear();
+    for (size_t i = 0; i<prog.code.size(); i++) {
+        char op = prog.code[i].op;
+        
+        if (op == calculator_type::PUSH) {
+            stack.push_back(intern(op, -1, -1, prog.constants[prog.code[i].arg]));
+        }
+        else if (op == calculator_type::SQR || op == calculator_type::SQRT) {
+            stack.back() = intern(op, stack.back(), -1, 0);
+        }
+        else {
+            int right = stack.back();
+            stack.pop_back();
+            stack.back() = intern(op, stack.back(), right, 0);
+        }
+    }
+    
+    expression_count++;
+    return stack.back();
+}
+
+/* Nodes are in the order they were added, operands first, so one pass in that
+ order sees every operand evaluated before it is used. A node fails if an
+ operand failed or if it divides by zero.
+ */
+template <class T>
+void shared_dag<T>::evaluate() {
+    for (; evaluated<nodes.size(); evaluated++) {
+        node &n = nodes[evaluated];
+        if (n.op == calculator_type::PUSH) { continue; }
+        
+        const node &a = nodes[n.left];
+        if (n.right < 0) {
+            n.failed = a.failed;
+            if (!n.failed) { n.value = calculator_type::execute(n.op, a.value); }
+            continue;
+        }
+        
+        const node &b = nodes[n.right];
+        n.failed = a.failed || b.failed || (n.op == calculator_type::DIV && b.value == 0);
+        if (!n.failed) { n.value = calculator_type::execute(n.op, a.value, b.value); }
+    }
+}
+
+/* Returns whether a node divides by zero */
+template <class T>
+bool shared_dag<T>::failed(int n) const {
+    return nodes[n].failed;
+}
+
+/* Returns value of a node */
+template <class T>
+T shared_dag<T>::value(int n) const {
+    return nodes[n].value;
+}
+
+/* Frees the nodes and the index */
+template <class T>
+void shared_dag<T>::clear() {
+    released_count += nodes.size();
+    vector<node>().swap(nodes);
+    unordered_map<node_key, int, node_hash>().swap(index);
+    vector<int>().swap(stack);
+    evaluated = 0;
+}
+
+/* Returns number of expressions added */
+template <class T>
+size_t shared_dag<T>::expressions() const {
+    return expression_count;
+}
+
+/* Returns number of subexpressions added, shared or not */
+template <class T>
+size_t shared_dag<T>::references() const {
+    return reference_count;
+}
+
+/* Returns number of distinct subexpressions */
+template <class T>
+size_t shared_dag<T>::nodes_created() const {
+    return released_count + nodes.size();
+}
+
+// Compile the graph for each value type the calculator supports
+template class shared_dag<float>;
+template class shared_dag<double>;
+template class shared_dag<long double>;
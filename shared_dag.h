@@ -0,0 +1,127 @@
+/*****************************************************************************
+ Title:             shared_dag.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Shared Expression DAG Class Definition (Header File)
+                        - Merges the compiled programs of many expressions
+                            into one graph in which each distinct
+                            subexpression is a single node
+                        - Evaluates every node once, so a subexpression that
+                            many expressions share is only computed once
+                        - Counts how many nodes were shared
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___shared_dag__
+#define ___shared_dag__
+
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "calculator.h"
+using namespace std;
+
+template <class T>
+class shared_dag {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef typename calculator_type::compiled_expression program;
+    
+    // A distinct subexpression: a constant, or an operator applied to other
+    // nodes. Operands always come before the nodes that use them.
+    struct node {
+        char op;
+        int left, right;    // Index of each operand node, or -1
+        T value;
+        bool failed;        // Divides by zero, here or in an operand
+    };
+    
+    // What makes two nodes the same subexpression
+    struct node_key {
+        char op;
+        int left, right;
+        T value;
+        bool operator == (const node_key &other) const;
+    };
+    struct node_hash {
+        size_t operator () (const node_key &key) const;
+    };
+    
+    vector<node> nodes;
+    unordered_map<node_key, int, node_hash> index;
+    vector<int> stack;
+    size_t evaluated;       // Nodes before this one have been evaluated
+    
+    size_t expression_count;
+    size_t reference_count;
+    size_t released_count;
+    
+    /* int intern(char op, int left, int right, T value);
+     Returns the index of the node for op applied to left and right, or for
+     the constant value, adding it if it is new.
+     */
+    int intern(char op, int left, int right, T value);
+    
+public:
+    
+    /* shared_dag();
+     Constructor for an empty graph.
+     */
+    shared_dag();
+    
+    /* int add(const program &prog);
+     Merges a compiled expression into the graph.
+        @param  program &prog [in]  program returned by compile or optimize
+        @return int [out]           node of the whole expression
+     Precondition:      prog has no variables
+     Postcondition:     Returns the node holding the result of prog. Nodes
+                        already in the graph are reused for each of its
+                        subexpressions. Throws an invalid_argument exception
+                        if prog has variables.
+     */
+    int add(const program &prog) throw(invalid_argument);
+    
+    /* void evaluate();
+     Evaluates each node added since the last call, once.
+     Postcondition:     value and failed hold the result of every node.
+     */
+    void evaluate();
+    
+    /* bool failed(int n) const;
+       T value(int n) const;
+     Return whether a node divides by zero and, if it does not, its value.
+     Precondition:      n was returned by add and evaluate has been called
+                        since
+     */
+    bool failed(int n) const;
+    T value(int n) const;
+    
+    /* void clear();
+     Frees all nodes. The counters are kept.
+     */
+    void clear();
+    
+    /* size_t expressions() const;
+       size_t references() const;
+       size_t nodes_created() const;
+     Return the number of expressions added, the number of subexpressions
+     they have between them, counting every operand and operator, and the
+     number of distinct ones that were made into nodes. The difference of the
+     last two is the number of subexpressions shared rather than computed
+     again.
+     */
+    size_t expressions() const;
+    size_t references() const;
+    size_t nodes_created() const;
+    
+};
+
+// Compiled ahead of time in shared_dag.cpp
+extern template class shared_dag<float>;
+extern template class shared_dag<double>;
+extern template class shared_dag<long double>;
+
+#endif
@@ -0,0 +1,164 @@
+/*****************************************************************************
+ Title:             thread_pool.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Thread Pool Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "thread_pool.h"
+
+// Pool and queue of the worker running on this thread, if any
+static thread_local thread_pool *current_pool = NULL;
+static thread_local size_t current_queue = 0;
+
+/* Thread pool constructor. Creates one queue per worker and starts the workers.
+ */
+thread_pool::thread_pool(unsigned threads)
+    : queued(0), pending(0), next_queue(0), stopping(false) {
+    
+    if (threads == 0) { threads = thread::hardware_concurrency(); }
+    if (threads == 0) { threads = 1; }
+    
+    for (unsigned i = 0; i<threads; i++) {
+        queues.push_back(new task_queue);
+    }
+    for (unsigned i = 0; i<threads; i++) {
+        workers.push_back(thread(&thread_pool::work, this, i));
+    }
+}
+
+/* Thread pool destructor. Waits for the queued tasks, then wakes and joins
+ every worker.
+ */
+thread_pool::~thread_pool() {
+    {
+        unique_lock<mutex> lk(state_lock);
+        all_done.wait(lk, [this] { return pending == 0; });
+        stopping = true;
+    }
+    task_added.notify_all();
+    
+    for (size_t i = 0; i<workers.size(); i++) {
+        workers[i].join();
+    }
+    for (size_t i = 0; i<queues.size(); i++) {
+        delete queues[i];
+    }
+}
+
+/* Returns number of worker threads */
+unsigned thread_pool::size() const {
+    return (unsigned)workers.size();
+}
+
+/* Pushes a task to the back of the calling worker's queue, or spreads tasks
+ from other threads over the queues in turn, then wakes a worker.
+ */
+void thread_pool::submit(const function<void()> &task) {
+    size_t id;
+    if (current_pool == this) { id = current_queue; }
+    else { id = next_queue++ % queues.size(); }
+    
+    pending++;
+    {
+        lock_guard<mutex> lk(queues[id]->lock);
+        queues[id]->tasks.push_back(task);
+    }
+    
+    {
+        lock_guard<mutex> lk(state_lock);
+        queued++;
+    }
+    task_added.notify_one();
+}
+
+/* Takes the newest task from the worker's own queue. If it is empty, steals the
+ oldest task from the next non-empty queue.
+ */
+bool thread_pool::take(size_t id, function<void()> &task) {
+    for (size_t k = 0; k<queues.size(); k++) {
+        task_queue &q = *queues[(id + k) % queues.size()];
+        lock_guard<mutex> lk(q.lock);
+        
+        if (!q.tasks.empty()) {
+            if (k == 0) {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+            }
+            else {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+            }
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Runs a task, keeping the first exception thrown, and wakes anyone waiting
+ once no tasks are left.
+ */
+void thread_pool::finish(function<void()> &task) {
+    try {
+        task();
+    }
+    catch (...) {
+        lock_guard<mutex> lk(state_lock);
+        if (!failure) { failure = current_exception(); }
+    }
+    
+    if (--pending == 0) {
+        lock_guard<mutex> lk(state_lock);
+        all_done.notify_all();
+    }
+}
+
+/* Worker loop: run tasks while there are any, else sleep until one is
+ submitted or the pool is destroyed.
+ */
+void thread_pool::work(size_t id) {
+    current_pool = this;
+    current_queue = id;
+    
+    while (true) {
+        function<void()> task;
+        if (take(id, task)) {
+            finish(task);
+            continue;
+        }
+        
+        unique_lock<mutex> lk(state_lock);
+        task_added.wait(lk, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) { return; }
+    }
+}
+
+/* Runs one queued task on the calling thread */
+bool thread_pool::run_one() {
+    size_t id = (current_pool == this) ? current_queue : 0;
+    
+    function<void()> task;
+    if (!take(id, task)) { return false; }
+    finish(task);
+    return true;
+}
+
+/* Helps run queued tasks, then blocks until the last running task finishes.
+ Rethrows the first exception a task threw.
+ */
+void thread_pool::wait() {
+    while (run_one()) { }
+    
+    unique_lock<mutex> lk(state_lock);
+    all_done.wait(lk, [this] { return pending == 0; });
+    
+    if (failure) {
+        exception_ptr e = failure;
+        failure = exception_ptr();
+        rethrow_exception(e);
+    }
+}
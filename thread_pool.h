@@ -0,0 +1,122 @@
+/*****************************************************************************
+ Title:             thread_pool.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Thread Pool Class Definition (Header File)
+                        - Runs tasks on a fixed number of worker threads
+                        - Each worker has its own queue of tasks. A worker
+                            that runs out of tasks steals from the others, so
+                            a few long tasks do not leave the rest idle.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___thread_pool__
+#define ___thread_pool__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class thread_pool {
+    
+    // A queue of tasks owned by a single worker. The owner takes tasks from
+    // the back, other workers steal from the front.
+    struct task_queue {
+        mutex lock;
+        deque<function<void()> > tasks;
+    };
+    
+    vector<task_queue *> queues;
+    vector<thread> workers;
+    
+    atomic<size_t> queued;      // Tasks waiting in a queue
+    atomic<size_t> pending;     // Tasks submitted but not yet finished
+    atomic<size_t> next_queue;  // Queue the next outside task goes to
+    bool stopping;
+    
+    mutex state_lock;
+    condition_variable task_added;
+    condition_variable all_done;
+    
+    // First exception thrown by a task since the last wait
+    exception_ptr failure;
+    
+    /* void work(size_t id);
+     Loop run by worker thread id until the pool is destroyed.
+     */
+    void work(size_t id);
+    
+    /* bool take(size_t id, function<void()> &task);
+     Takes a task off queue id, else steals one from another queue.
+     */
+    bool take(size_t id, function<void()> &task);
+    
+    /* void finish(function<void()> &task);
+     Runs a task and records that it has finished.
+     */
+    void finish(function<void()> &task);
+    
+public:
+    
+/******************************************************************************
+    Constructors
+ ******************************************************************************/
+    
+    /* thread_pool(unsigned threads=0);
+     Constructor that starts the worker threads.
+        @param  unsigned threads [in]   number of workers, 0 for one per core
+     Precondition:      none
+     Postcondition:     threads workers (at least one) are waiting for tasks
+     */
+    thread_pool(unsigned threads=0);
+    
+    /* ~thread_pool();
+     Destructor that finishes all submitted tasks and stops the workers.
+     */
+    ~thread_pool();
+    
+/******************************************************************************
+    Accessors
+ ******************************************************************************/
+    
+    /* unsigned size() const;
+     Returns the number of worker threads.
+     */
+    unsigned size() const;
+    
+    /* void submit(const function<void()> &task);
+     Queues a task to be run by one of the workers. A task submitted by a
+     worker goes to that worker's own queue.
+        @param  function<void()> &task [in]     task to run
+     Precondition:      task is callable
+     Postcondition:     task will be run exactly once by some thread
+     */
+    void submit(const function<void()> &task);
+    
+    /* bool run_one();
+     Runs a single queued task on the calling thread, if there is one. Lets a
+     thread waiting on other tasks help instead of blocking.
+        @return bool [out]      true if a task was run
+     */
+    bool run_one();
+    
+    /* void wait();
+     Blocks until every submitted task has finished.
+     Precondition:      not called from inside a task
+     Postcondition:     all tasks have finished. If any task threw an
+                        exception, the first one is rethrown.
+     */
+    void wait();
+    
+};
+
+#endif
@@ -0,0 +1,281 @@
+/*****************************************************************************
+ Title:             tree_evaluator.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Tree Evaluator Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "tree_evaluator.h"
+#include <algorithm>
+#include <ctype.h>
+#include <thread>
+
+// Levels of the tree below which parts are evaluated on a single stack. A
+// balanced cut only needs one level per halving, so this is never reached
+// unless parentheses are nested deeper than any cut could use.
+static const int MAX_NESTING = 64;
+
+/* Tree evaluator constructor */
+template <class T>
+tree_evaluator<T>::tree_evaluator(calculator_type &calc, size_t grain)
+    : calc(calc), grain(grain ? grain : 1), exp(NULL), length(0), pool(NULL),
+      fork_count(0), guard_count(0) { }
+      
+/* Records each left parenthesis as it is read and pairs it with the next right
+ parenthesis that is not already paired, as compile does with its operator
+ stack
+ */
+template <class T>
+bool tree_evaluator<T>::match() {
+    opens.clear();
+    closes.clear();
+    unmatched.clear();
+    
+    for (size_t i = 0; i<length; i++) {
+        if (exp[i] == '(') {
+            unmatched.push_back(opens.size());
+            opens.push_back(i);
+            closes.push_back(0);
+        }
+        else if (exp[i] == ')') {
+            if (unmatched.empty()) { return false; }
+            closes[unmatched.back()] = i;
+            unmatched.pop_back();
+        }
+    }
+    return unmatched.empty();
+}
+
+/* Left parentheses are recorded in order, so the one at open is found by a
+ binary search
+ */
+template <class T>
+size_t tree_evaluator<T>::closing(size_t open) const {
+    return closes[lower_bound(opens.begin(), opens.end(), open) - opens.begin()];
+}
+
+/* Mirrors the number scanner: digits and decimal points, then an exponent only
+ if a digit follows the e and its sign. Any other name is letters, digits and
+ underscores.
+ */
+template <class T>
+size_t tree_evaluator<T>::token_end(size_t i, size_t to) const {
+    size_t j = i;
+    if (!isdigit(exp[i])) {
+        while (j < to && (isalnum(exp[j]) || exp[j] == '_')) { j++; }
+        return j;
+    }
+    
+    while (j < to && (isdigit(exp[j]) || exp[j] == '.')) { j++; }
+    if (j < to && (exp[j] == 'e' || exp[j] == 'E')) {
+        size_t k = j+1;
+        if (k < to && (exp[k] == '+' || exp[k] == '-')) { k++; }
+        if (k < to && isdigit(exp[k])) {
+            while (k < to && isdigit(exp[k])) { k++; }
+            j = k;
+        }
+    }
+    return j;
+}
+
+/* + and - have the lowest precedence and are left associative, so the range
+ is a sum of the operands between its + and - outside parentheses. Cutting at
+ every + gives parts that are each a run of them, and the range is the sum of
+ its parts; cutting at a - would not, as the part after it would be negated.
+ A range without either is a product of the operands between its * and /, and
+ only the *'s after the last / multiply the rest: a*b/c*d is (a*b/c) * d.
+ Numbers and names are skipped whole, and parentheses jumped over.
+ */
+template <class T>
+char tree_evaluator<T>::split(size_t from, size_t to, vector<size_t> &cuts) const {
+    cuts.clear();
+    vector<size_t> stars;
+    bool minus = false;
+    
+    for (size_t i = from; i<to; i++) {
+        char c = exp[i];
+        if (c == '(') { i = closing(i); }
+        else if (isalnum(c) || c == '_') { i = token_end(i, to) - 1; }
+        else if (c == '+') { cuts.push_back(i); }
+        else if (c == '-') { minus = true; }
+        else if (c == '*') { stars.push_back(i); }
+        else if (c == '/') { stars.clear(); }
+    }
+    
+    if (!cuts.empty()) { return '+'; }
+    if (minus || stars.empty()) { return 0; }
+    cuts.swap(stars);
+    return '*';
+}
+
+/* Evaluates the range with a context of its own, so parts can be evaluated on
+ any thread, and reports an error where it is in the whole expression
+ */
+template <class T>
+typename tree_evaluator<T>::outcome tree_evaluator<T>::evaluate_stack(size_t from, size_t to) const {
+    context ctx;
+    outcome o;
+    o.ok = calc.try_evaluate_stack(exp + from, to - from, ctx, o.value, o.error);
+    if (!o.ok) { o.error.offset += from; }
+    return o;
+}
+
+/* A short range, or one past the nesting guard, is evaluated as it is. A
+ range in parentheses has the value of what is inside them. Otherwise the
+ operands between its cuts are gathered into parts of at least a grain each,
+ which are reduced as a balanced tree. If every cut is within the first
+ grain, the range is cut at the last one.
+ */
+template <class T>
+typename tree_evaluator<T>::outcome tree_evaluator<T>::evaluate_range(size_t from, size_t to, int depth) {
+    while (from < to && exp[from] == ' ') { from++; }
+    while (to > from && exp[to-1] == ' ') { to--; }
+    
+    if (to - from < 2 * grain) { return evaluate_stack(from, to); }
+    if (depth >= MAX_NESTING) {
+        guard_count++;
+        return evaluate_stack(from, to);
+    }
+    
+    if (exp[from] == '(' && closing(from) == to - 1) {
+        return evaluate_range(from + 1, to - 1, depth + 1);
+    }
+    
+    vector<size_t> cuts;
+    char op = split(from, to, cuts);
+    if (op == 0) { return evaluate_stack(from, to); }
+    
+    vector<part> parts;
+    part p;
+    p.from = from;
+    for (size_t i = 0; i<cuts.size(); i++) {
+        if (cuts[i] - p.from >= grain) {
+            p.to = cuts[i];
+            parts.push_back(p);
+            p.from = cuts[i] + 1;
+        }
+    }
+    if (parts.empty()) {
+        p.to = cuts.back();
+        parts.push_back(p);
+        p.from = cuts.back() + 1;
+    }
+    p.to = to;
+    parts.push_back(p);
+    
+    return reduce(parts, 0, parts.size(), op, depth + 1);
+}
+
+/* Hands left to the pool and runs right. While waiting for left, the thread
+ runs other queued tasks, which may be left itself, so it never blocks while
+ there is work, and forks inside tasks cannot deadlock. Without a pool of
+ more than one thread both run here, in the same order of operations.
+ */
+template <class T>
+template <class F, class G>
+void tree_evaluator<T>::fork(F left, G right) {
+    if (pool == NULL || pool->size() < 2) {
+        left();
+        right();
+        return;
+    }
+    
+    atomic<bool> done(false);
+    pool->submit([&left, &done] {
+        left();
+        done.store(true, memory_order_release);
+    });
+    fork_count++;
+    
+    right();
+    while (!done.load(memory_order_acquire)) {
+        if (!pool->run_one()) { this_thread::yield(); }
+    }
+}
+
+/* Parts are cut where their characters are halved, leaving at least one on
+ each side, and the halves evaluated in parallel. Past the nesting guard the
+ parts are combined left to right instead.
+ */
+template <class T>
+typename tree_evaluator<T>::outcome tree_evaluator<T>::reduce(const vector<part> &parts, size_t first, size_t last, char op, int depth) {
+    if (last - first == 1) { return evaluate_range(parts[first].from, parts[first].to, depth); }
+    
+    if (depth >= MAX_NESTING) {
+        outcome acc = evaluate_range(parts[first].from, parts[first].to, depth);
+        for (size_t i = first + 1; i<last; i++) {
+            acc = combine(acc, evaluate_range(parts[i].from, parts[i].to, depth), op);
+        }
+        return acc;
+    }
+    
+    size_t middle = parts[first].from + (parts[last-1].to - parts[first].from) / 2;
+    size_t mid = first + 1;
+    while (mid < last - 1 && parts[mid].to <= middle) { mid++; }
+    
+    outcome a, b;
+    fork([&] { a = reduce(parts, first, mid, op, depth + 1); },
+         [&] { b = reduce(parts, mid, last, op, depth + 1); });
+    return combine(a, b, op);
+}
+
+/* An error other than division by zero wins, as evaluating the expression on a
+ single stack would find it while compiling, before running anything. Of two
+ divisions by zero, the one on the left comes first in the program.
+ */
+template <class T>
+typename tree_evaluator<T>::outcome tree_evaluator<T>::combine(const outcome &a, const outcome &b, char op) {
+    if (!a.ok && a.error.kind != ERROR_DIVIDE_BY_ZERO) { return a; }
+    if (!b.ok && b.error.kind != ERROR_DIVIDE_BY_ZERO) { return b; }
+    if (!a.ok) { return a; }
+    if (!b.ok) { return b; }
+    
+    outcome o = a;
+    o.value = calculator_type::execute(op, a.value, b.value);
+    return o;
+}
+
+/* Evaluates a long expression with balanced parentheses as a tree, and any
+ other on a single stack. An error that is not a division by zero is found
+ again on a single stack, where it is reported at the same place as always.
+ */
+template <class T>
+bool tree_evaluator<T>::evaluate(const char *exp, size_t length, thread_pool *pool, T &result, diagnostic &error) {
+    this->exp = exp;
+    this->length = length;
+    this->pool = pool;
+    
+    outcome o;
+    if (length < 2 * grain || !match()) { o = evaluate_stack(0, length); }
+    else {
+        o = evaluate_range(0, length, 0);
+        if (!o.ok && o.error.kind != ERROR_DIVIDE_BY_ZERO) { o = evaluate_stack(0, length); }
+    }
+    
+    if (!o.ok) {
+        error = o.error;
+        return false;
+    }
+    result = o.value;
+    return true;
+}
+
+/* Returns number of tasks forked */
+template <class T>
+size_t tree_evaluator<T>::forked() const {
+    return fork_count;
+}
+
+/* Returns number of parts evaluated past the nesting guard */
+template <class T>
+size_t tree_evaluator<T>::guarded() const {
+    return guard_count;
+}
+
+// Compile the tree evaluator for each value type the calculator supports
+template class tree_evaluator<float>;
+template class tree_evaluator<double>;
+template class tree_evaluator<long double>;
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ Title:             tree_evaluator.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Tree Evaluator Class Definition (Header File)
+                        - Evaluates a single very long infix expression on
+                            many threads instead of one
+                        - Parses the expression into a balanced tree of parts:
+                            a long sum is cut at its + operators and a long
+                            product at its * operators into parts of about the
+                            same length, and a part that is a long expression
+                            in parentheses is cut the same way
+                        - Compiles and evaluates the parts as fork-join tasks
+                            on a thread pool and adds up, or multiplies, their
+                            values pairwise, as a balanced tree
+ 
+                    Both the parsing and the running of the expression are
+                    split, as compiling takes longer than running. Only the
+                    order in which the parts of long sums and products are
+                    added up changes, so results may differ from evaluate by
+                    rounding, and are usually closer to exact. Where an
+                    expression is cut depends only on its text, never on the
+                    threads, so it always gives the same result. Nesting
+                    deeper than the guard is evaluated on a single stack, so
+                    no expression can overflow the call stack.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___tree_evaluator__
+#define ___tree_evaluator__
+
+#include <atomic>
+#include <vector>
+#include "calculator.h"
+#include "diagnostic.h"
+#include "thread_pool.h"
+using namespace std;
+
+template <class T>
+class tree_evaluator {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef typename calculator_type::evaluator_context context;
+    
+    // A part of the expression, from its first character to the one after
+    // its last
+    struct part {
+        size_t from;
+        size_t to;
+    };
+    
+    // Value of part of the expression, or why it has none. Only a division
+    // by zero found in a part is reported as it is; for any other error the
+    // whole expression is evaluated again on a single stack, so the error is
+    // reported exactly as evaluate would report it.
+    struct outcome {
+        T value;
+        diagnostic error;
+        bool ok;
+    };
+    
+    calculator_type &calc;
+    size_t grain;
+    
+    // Expression being evaluated and the pool its parts are forked onto
+    const char *exp;
+    size_t length;
+    thread_pool *pool;
+    
+    // Where each left parenthesis is, in order, and its matching right one
+    vector<size_t> opens;
+    vector<size_t> closes;
+    vector<size_t> unmatched;
+    
+    atomic<size_t> fork_count;
+    atomic<size_t> guard_count;
+    
+    /* bool match();
+     Pairs up the parentheses of the expression. Returns false if they do
+     not balance.
+     */
+    bool match();
+    
+    /* size_t closing(size_t open) const;
+     Returns where the right parenthesis matching the one at open is.
+     */
+    size_t closing(size_t open) const;
+    
+    /* size_t token_end(size_t i, size_t to) const;
+     Returns the end of the number or name starting at i, read the way
+     compile reads it, so a + or - in an exponent is never taken for an
+     operator.
+     */
+    size_t token_end(size_t i, size_t to) const;
+    
+    /* char split(size_t from, size_t to, vector<size_t> &cuts) const;
+     Finds where a range can be cut: at each + outside parentheses, or if
+     there is no + or -, at each * after the last / outside parentheses.
+        @return char [out]      '+' or '*', the operator at each cut, or 0
+                                    if the range cannot be cut
+     */
+    char split(size_t from, size_t to, vector<size_t> &cuts) const;
+    
+    /* outcome evaluate_range(size_t from, size_t to, int depth);
+     Evaluates a range of the expression, depth levels below the root.
+     */
+    outcome evaluate_range(size_t from, size_t to, int depth);
+    
+    /* outcome evaluate_stack(size_t from, size_t to) const;
+     Evaluates a range of the expression on a single stack.
+     */
+    outcome evaluate_stack(size_t from, size_t to) const;
+    
+    /* outcome reduce(const vector<part> &parts, size_t first, size_t last,
+                      char op, int depth);
+     Evaluates parts first to last - 1 and combines their values with op,
+     halves in parallel.
+     */
+    outcome reduce(const vector<part> &parts, size_t first, size_t last, char op, int depth);
+    
+    /* static outcome combine(const outcome &a, const outcome &b, char op);
+     Returns a op b, or the error to report if either has none.
+     */
+    static outcome combine(const outcome &a, const outcome &b, char op);
+    
+    /* template <class F, class G> void fork(F left, G right);
+     Runs left as a task on the pool while the calling thread runs right,
+     then helps run queued tasks until left is done.
+     */
+    template <class F, class G>
+    void fork(F left, G right);
+    
+public:
+    
+    /* tree_evaluator(basic_calculator<T> &calc, size_t grain=16384);
+     Constructor for an evaluator that evaluates each part with calc.
+        @param  basic_calculator<T> &calc [in]  calculator whose parser,
+                                                    optimizer and stack
+                                                    each part is evaluated
+                                                    with
+        @param  size_t grain [in]   fewest characters worth a task
+     Precondition:      calc exists as long as this object
+     */
+    tree_evaluator(calculator_type &calc, size_t grain=16384);
+    
+    /* bool evaluate(const char *exp, size_t length, thread_pool *pool,
+                     T &result, diagnostic &error);
+     Evaluates the first length characters of exp as a balanced tree of
+     parts, forked onto the threads of pool. Expressions shorter than two
+     grains are simply evaluated.
+        @param  char *exp [in]          expression to evaluate
+        @param  size_t length [in]      number of characters in exp
+        @param  thread_pool *pool [in]  pool to fork onto, or NULL to evaluate
+                                            every part on the calling thread
+        @param  T &result [out]         result of evaluation
+        @param  diagnostic &error [out] kind and offset of the error
+     Precondition:      this evaluator is not used by another thread. May be
+                        called from a task of pool.
+     Postcondition:     Returns true with result set if exp is valid, else
+                        false with error set as try_evaluate sets it. Long
+                        sums and products are added up in a balanced order,
+                        which may round differently.
+     */
+    bool evaluate(const char *exp, size_t length, thread_pool *pool, T &result, diagnostic &error);
+    
+    /* size_t forked() const;
+       size_t guarded() const;
+     Return the number of tasks forked so far, and of parts evaluated on a
+     single stack because they were nested too deep.
+     */
+    size_t forked() const;
+    size_t guarded() const;
+    
+};
+
+// Compiled ahead of time in tree_evaluator.cpp
+extern template class tree_evaluator<float>;
+extern template class tree_evaluator<double>;
+extern template class tree_evaluator<long double>;
+
+#endif
@@ -0,0 +1,290 @@
+/*****************************************************************************
+ Title:             uncertainty.cpp
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Uncertain Evaluator Class Implementation
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+#include "uncertainty.h"
+#include "kernels.h"
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <math.h>
+
+// Rows of samples run by run_batch at a time
+static const size_t SAMPLE_BLOCK = 4096;
+
+/* Returns the bounds of the values given, widened by one unit in the last
+ place each way to allow for the rounding of the operation that gave them.
+ If any is NaN, the result has no bounds.
+ */
+template <class T>
+static interval<T> span(const T *values, int n) {
+    interval<T> r;
+    r.lo = r.hi = values[0];
+    for (int i = 0; i<n; i++) {
+        if (values[i] != values[i]) {
+            r.lo = r.hi = numeric_limits<T>::quiet_NaN();
+            return r;
+        }
+        if (values[i] < r.lo) { r.lo = values[i]; }
+        if (values[i] > r.hi) { r.hi = values[i]; }
+    }
+    r.lo = nextafter(r.lo, -numeric_limits<T>::infinity());
+    r.hi = nextafter(r.hi, numeric_limits<T>::infinity());
+    return r;
+}
+
+/* Returns the bounds of a ^ b. pow is monotonic in each operand where it is
+ defined, so for a base that is not negative the bounds are at the corners.
+ A negative base only has a value for an integer exponent, where the result
+ is monotonic on each side of 0, so 0 is a bound too if the base spans it.
+ A negative exponent has a pole at 0 instead, which an odd one approaches
+ from both sides and an even one only from above.
+ */
+template <class T>
+static interval<T> interval_pow(interval<T> a, interval<T> b) {
+    T corners[5];
+    corners[0] = pow(a.lo, b.lo);
+    corners[1] = pow(a.lo, b.hi);
+    corners[2] = pow(a.hi, b.lo);
+    corners[3] = pow(a.hi, b.hi);
+    
+    if (a.lo >= 0) { return span(corners, 4); }
+    
+    if (b.lo == b.hi && b.lo == floor(b.lo)) {
+        if (b.lo < 0 && a.hi >= 0) {
+            interval<T> r = span(corners, 4);
+            if (fmod(b.lo, T(2)) != 0) { r.lo = -numeric_limits<T>::infinity(); }
+            r.hi = numeric_limits<T>::infinity();
+            return r;
+        }
+        corners[4] = pow(T(0), b.lo);
+        return span(corners, a.hi > 0 ? 5 : 4);
+    }
+    
+    interval<T> none;
+    none.lo = none.hi = numeric_limits<T>::quiet_NaN();
+    return none;
+}
+
+/* Uncertain evaluator constructor */
+template <class T>
+uncertain_evaluator<T>::uncertain_evaluator(calculator_type &calc) : calc(calc) { }
+
+/* Throws, as run does, for a variable without bounds */
+template <class T>
+void uncertain_evaluator<T>::check_bound(const compiled_expression &prog, const vector<interval<T> > &constants, const vector<interval<T> > &vars) throw(invalid_argument) {
+    if (constants.size() < prog.constants.size()) {
+        throw invalid_argument("Constant without bounds");
+    }
+    if (vars.size() < prog.variables.size()) {
+        throw invalid_argument("Unbound variable " + prog.variables[vars.size()]);
+    }
+}
+
+/* Compiles an expression the way evaluate does, throwing its exceptions */
+template <class T>
+typename uncertain_evaluator<T>::compiled_expression uncertain_evaluator<T>::compile_constant(const string &exp) {
+    compiled_expression prog = calc.compile(exp);
+    if (!prog.variables.empty()) {
+        throw invalid_argument("Unbound variable " + prog.variables[0]);
+    }
+    return prog;
+}
+
+/* Bounds of each literal are its value less and plus tolerance times its size */
+template <class T>
+vector<interval<T> > uncertain_evaluator<T>::jitter(const compiled_expression &prog, T tolerance) {
+    vector<interval<T> > out(prog.constants.size());
+    for (size_t i = 0; i<out.size(); i++) {
+        T c = prog.constants[i];
+        T d = fabs(c) * tolerance;
+        out[i].lo = c - d;
+        out[i].hi = c + d;
+    }
+    return out;
+}
+
+/* Runs the program on a stack of intervals, the way run_checked runs it on a
+ stack of values. Each binary operator takes the bounds of the results it
+ could give at the corners of its operands, which is where the operators of
+ execute have their extremes; a product or square spanning 0 has its least
+ magnitude there too, and a division whose divisor spans 0 is an error.
+ */
+template <class T>
+bool uncertain_evaluator<T>::bounds(const compiled_expression &prog, const vector<interval<T> > &constants, const vector<interval<T> > &vars, interval<T> &result, diagnostic &error) throw(invalid_argument) {
+    check_bound(prog, constants, vars);
+    
+    interval<T> local[64];
+    vector<interval<T> > heap;
+    interval<T> *stack = local;
+    if (prog.max_depth > 64) {
+        heap.resize(prog.max_depth);
+        stack = &heap[0];
+    }
+    
+    int top = 0;
+    T corners[4];
+    for (size_t i = 0; i<prog.code.size(); i++) {
+        const instruction &ins = prog.code[i];
+        
+        if (ins.op == calculator_type::PUSH) { stack[top++] = constants[ins.arg]; }
+        else if (ins.op == calculator_type::LOAD) { stack[top++] = vars[ins.arg]; }
+        else if (ins.op == calculator_type::SQR) {
+            interval<T> &a = stack[top-1];
+            corners[0] = a.lo * a.lo;
+            corners[1] = a.hi * a.hi;
+            corners[2] = 0;
+            a = span(corners, (a.lo < 0 && a.hi > 0) ? 3 : 2);
+        }
+        else if (ins.op == calculator_type::SQRT) {
+            interval<T> &a = stack[top-1];
+            if (a.lo < 0) { a.lo = a.hi = numeric_limits<T>::quiet_NaN(); }
+            else {
+                corners[0] = sqrt(a.lo);
+                corners[1] = sqrt(a.hi);
+                a = span(corners, 2);
+            }
+        }
+        else {
+            top--;
+            interval<T> &a = stack[top-1];
+            const interval<T> &b = stack[top];
+            
+            if (ins.op == calculator_type::DIV && b.lo <= 0 && b.hi >= 0) {
+                error.kind = ERROR_DIVIDE_BY_ZERO;
+                error.offset = ins.arg;
+                error.message = "Attempt to divide by zero";
+                return false;
+            }
+            
+            if (ins.op == calculator_type::POW) { a = interval_pow(a, b); }
+            else {
+                corners[0] = calculator_type::execute(ins.op, a.lo, b.lo);
+                corners[1] = calculator_type::execute(ins.op, a.lo, b.hi);
+                corners[2] = calculator_type::execute(ins.op, a.hi, b.lo);
+                corners[3] = calculator_type::execute(ins.op, a.hi, b.hi);
+                a = span(corners, 4);
+            }
+        }
+    }
+    
+    result = stack[0];
+    return true;
+}
+
+/* Bounds of an expression whose literals are jittered by tolerance */
+template <class T>
+interval<T> uncertain_evaluator<T>::bounds(const string &exp, T tolerance) {
+    compiled_expression prog = compile_constant(exp);
+    
+    interval<T> result;
+    diagnostic error;
+    if (!bounds(prog, jitter(prog, tolerance), vector<interval<T> >(), result, error)) {
+        throw invalid_argument(calculator_type::error_message(error, exp.data(), exp.length()));
+    }
+    return result;
+}
+
+/* Rewrites the program so that constant i is loaded as the variable after the
+ program's own, then fills a column of each input a block of rows at a time
+ and runs the block with run_batch. Inputs whose bounds are a single value
+ are filled rather than drawn. The results that have a value are kept, to
+ sort out the percentiles once all blocks are done.
+ */
+template <class T>
+sample_summary<T> uncertain_evaluator<T>::sample(const compiled_expression &prog, const vector<interval<T> > &constants, const vector<interval<T> > &vars, size_t samples, unsigned long seed) throw(invalid_argument) {
+    check_bound(prog, constants, vars);
+    
+    size_t nvars = prog.variables.size();
+    compiled_expression batch = prog;
+    for (size_t i = 0; i<batch.code.size(); i++) {
+        if (batch.code[i].op == calculator_type::PUSH) {
+            batch.code[i].op = calculator_type::LOAD;
+            batch.code[i].arg += (int)nvars;
+        }
+    }
+    batch.variables.resize(nvars + prog.constants.size());
+    
+    // Bounds of each input, in the order of the columns
+    vector<interval<T> > inputs(vars.begin(), vars.begin() + nvars);
+    inputs.insert(inputs.end(), constants.begin(), constants.begin() + prog.constants.size());
+    
+    vector<vector<T> > data(inputs.size(), vector<T>(SAMPLE_BLOCK));
+    vector<const T *> columns(inputs.size());
+    for (size_t c = 0; c<inputs.size(); c++) { columns[c] = &data[c][0]; }
+    vector<T> results(SAMPLE_BLOCK);
+    vector<unsigned char> errors(SAMPLE_BLOCK);
+    
+    mt19937_64 random(seed);
+    vector<T> kept;
+    kept.reserve(samples);
+    long double sum = 0;
+    
+    for (size_t start = 0; start<samples; start += SAMPLE_BLOCK) {
+        size_t n = (samples - start < SAMPLE_BLOCK) ? samples - start : SAMPLE_BLOCK;
+        
+        for (size_t c = 0; c<inputs.size(); c++) {
+            if (inputs[c].lo == inputs[c].hi) { column_fill(inputs[c].lo, &data[c][0], n); }
+            else {
+                uniform_real_distribution<T> draw(inputs[c].lo, inputs[c].hi);
+                for (size_t r = 0; r<n; r++) { data[c][r] = draw(random); }
+            }
+        }
+        
+        calc.run_batch(batch, columns, n, &results[0], &errors[0]);
+        
+        for (size_t r = 0; r<n; r++) {
+            if (errors[r] || results[r] != results[r]) { continue; }
+            kept.push_back(results[r]);
+            sum += results[r];
+        }
+    }
+    
+    sample_summary<T> s;
+    s.samples = samples;
+    s.failed = samples - kept.size();
+    if (kept.empty()) {
+        s.mean = s.stddev = s.min = s.max = numeric_limits<T>::quiet_NaN();
+        s.p05 = s.p50 = s.p95 = s.mean;
+        return s;
+    }
+    
+    long double mean = sum / kept.size();
+    long double squares = 0;
+    for (size_t i = 0; i<kept.size(); i++) {
+        long double d = kept[i] - mean;
+        squares += d * d;
+    }
+    s.mean = (T)mean;
+    s.stddev = kept.size() > 1 ? (T)sqrt(squares / (kept.size() - 1)) : 0;
+    
+    // Percentiles are the nearest rank, found by partial sorts of the results
+    size_t last = kept.size() - 1;
+    s.min = *min_element(kept.begin(), kept.end());
+    s.max = *max_element(kept.begin(), kept.end());
+    size_t ranks[3] = { last * 5 / 100, last / 2, last * 95 / 100 };
+    T *percentiles[3] = { &s.p05, &s.p50, &s.p95 };
+    for (int p = 0; p<3; p++) {
+        nth_element(kept.begin(), kept.begin() + ranks[p], kept.end());
+        *percentiles[p] = kept[ranks[p]];
+    }
+    return s;
+}
+
+/* Statistics of an expression whose literals are jittered by tolerance */
+template <class T>
+sample_summary<T> uncertain_evaluator<T>::sample(const string &exp, T tolerance, size_t samples, unsigned long seed) {
+    compiled_expression prog = compile_constant(exp);
+    return sample(prog, jitter(prog, tolerance), vector<interval<T> >(), samples, seed);
+}
+
+// Uncertain evaluators of each calculator
+template class uncertain_evaluator<float>;
+template class uncertain_evaluator<double>;
+template class uncertain_evaluator<long double>;
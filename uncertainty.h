@@ -0,0 +1,172 @@
+/*****************************************************************************
+ Title:             uncertainty.h
+ Author:            Anna Cristina Karingal
+ Created on:        Oct 17, 2026
+ Description:       Uncertain Evaluator Class Definition (Header File)
+                        - Evaluates an infix expression whose literals, and
+                            variables, are only known to lie within bounds
+                        - Interval mode runs the compiled program once on
+                            [lo, hi] bounds, giving bounds that hold for every
+                            value of the inputs within theirs
+                        - Monte Carlo mode draws many samples of every input
+                            within its bounds and runs them all as columns
+                            with run_batch, giving the mean, spread and
+                            percentiles of the results
+ 
+                    Both replace evaluating the expression again for each set
+                    of jittered literals. Expressions are compiled by the
+                    same parser evaluate uses and are never optimized, as
+                    folding would merge literals that vary independently.
+ 
+ Last Modified:     Oct 17, 2026
+ 
+ *****************************************************************************/
+
+
+#ifndef ___uncertainty__
+#define ___uncertainty__
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include "calculator.h"
+#include "diagnostic.h"
+using namespace std;
+
+// Closed range of values, lo <= hi, or both NaN if it has no bounds, e.g.
+// the square root of a range of negative numbers
+template <class T>
+struct interval {
+    T lo;
+    T hi;
+};
+
+// Statistics of the results of a Monte Carlo run. Samples that divide by
+// zero or whose result is NaN are counted as failed and left out of the rest.
+template <class T>
+struct sample_summary {
+    size_t samples;
+    size_t failed;
+    T mean;
+    T stddev;               // Sample standard deviation
+    T min, max;
+    T p05, p50, p95;        // 5th, 50th and 95th percentiles
+};
+
+template <class T>
+class uncertain_evaluator {
+    
+    typedef basic_calculator<T> calculator_type;
+    typedef typename calculator_type::compiled_expression compiled_expression;
+    typedef typename calculator_type::instruction instruction;
+    
+    calculator_type &calc;
+    
+    /* static void check_bound(const compiled_expression &prog,
+                               const vector<interval<T> > &constants,
+                               const vector<interval<T> > &vars);
+     Throws an invalid_argument exception if there are fewer bounds than
+     constants or variables of prog.
+     */
+    static void check_bound(const compiled_expression &prog, const vector<interval<T> > &constants, const vector<interval<T> > &vars) throw(invalid_argument);
+    
+    /* compiled_expression compile_constant(const string &exp);
+     Compiles exp, which must not have variables, throwing if it is invalid.
+     */
+    compiled_expression compile_constant(const string &exp);
+    
+public:
+    
+    /* uncertain_evaluator(basic_calculator<T> &calc);
+     Constructor for an evaluator that compiles and runs with calc.
+        @param  basic_calculator<T> &calc [in]  calculator whose parser and
+                                                    column kernels are used
+     Precondition:      calc exists as long as this object
+     */
+    uncertain_evaluator(calculator_type &calc);
+    
+    /* static vector<interval<T> > jitter(const compiled_expression &prog,
+                                         T tolerance);
+     Returns bounds for each literal of prog that are within tolerance of it,
+     relative to its value, e.g. [9.9, 10.1] for 10 with a tolerance of 0.01.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @param  T tolerance [in]                relative tolerance, >= 0
+        @return vector<interval<T> > [out]      bounds of each constant, in
+                                                    the order of
+                                                    prog.constants
+     */
+    static vector<interval<T> > jitter(const compiled_expression &prog, T tolerance);
+    
+    /* bool bounds(const compiled_expression &prog,
+                   const vector<interval<T> > &constants,
+                   const vector<interval<T> > &vars, interval<T> &result,
+                   diagnostic &error);
+     Runs prog once with interval arithmetic: each operator of execute is
+     applied to the bounds of its operands, giving the bounds of its result.
+     Bounds are rounded outward, so they hold whatever rounding the scalar
+     evaluation does.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @param  vector<interval<T> > &constants [in]    bounds of each
+                                                            constant
+        @param  vector<interval<T> > &vars [in] bounds of each variable
+        @param  interval<T> &result [out]       bounds of the result
+        @param  diagnostic &error [out]         why there are none
+     Precondition:      prog was returned by compile
+     Postcondition:     Returns true with result holding every value prog
+                        gives with its inputs within their bounds, else false
+                        with error set if a divisor's bounds hold 0. Throws an
+                        invalid_argument exception if too few bounds are
+                        given.
+     */
+    bool bounds(const compiled_expression &prog, const vector<interval<T> > &constants, const vector<interval<T> > &vars, interval<T> &result, diagnostic &error) throw(invalid_argument);
+    
+    /* interval<T> bounds(string exp, T tolerance);
+     Same as above for an expression without variables whose literals are all
+     within tolerance of their value.
+     Postcondition:     Returns the bounds of exp, else throws the exception
+                        evaluate would, or an invalid_argument exception if a
+                        divisor may be 0.
+     */
+    interval<T> bounds(const string &exp, T tolerance);
+    
+    /* sample_summary<T> sample(const compiled_expression &prog,
+                                const vector<interval<T> > &constants,
+                                const vector<interval<T> > &vars,
+                                size_t samples, unsigned long seed=1);
+     Runs prog on samples sets of inputs, each drawn uniformly within its
+     bounds. Every constant is turned into a variable, so all samples are run
+     together, a column of each input at a time, by run_batch and the
+     vectorized column kernels.
+        @param  compiled_expression &prog [in]  program returned by compile
+        @param  vector<interval<T> > &constants [in]    bounds of each
+                                                            constant
+        @param  vector<interval<T> > &vars [in] bounds of each variable
+        @param  size_t samples [in]             number of samples
+        @param  unsigned long seed [in]         seed of the random numbers;
+                                                    the same seed gives the
+                                                    same samples
+        @return sample_summary<T> [out]         statistics of the results
+     Precondition:      prog was returned by compile
+     Postcondition:     Returns the statistics of the samples that have a
+                        result, all NaN if none does. Throws an
+                        invalid_argument exception if too few bounds are
+                        given.
+     */
+    sample_summary<T> sample(const compiled_expression &prog, const vector<interval<T> > &constants, const vector<interval<T> > &vars, size_t samples, unsigned long seed=1) throw(invalid_argument);
+    
+    /* sample_summary<T> sample(string exp, T tolerance, size_t samples,
+                                unsigned long seed=1);
+     Same as above for an expression without variables whose literals are all
+     within tolerance of their value.
+     Postcondition:     Throws the exception evaluate would if exp is invalid.
+     */
+    sample_summary<T> sample(const string &exp, T tolerance, size_t samples, unsigned long seed=1);
+    
+};
+
+// Compiled ahead of time in uncertainty.cpp
+extern template class uncertain_evaluator<float>;
+extern template class uncertain_evaluator<double>;
+extern template class uncertain_evaluator<long double>;
+
+#endif